@@ -0,0 +1,383 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Client list walking benchmark: the loops of client_align_adjust(),
+ * client_cycle() and the reflow after a screen change, over nclients
+ * clients laid out the old way (one malloc'd struct with everything in
+ * it, size hints and title malloc'd beside it) and the new way (hot
+ * client_ctx from a cache line aligned pool, cold part out of line).
+ *
+ *	usage: clients [-c nclients] [-n rounds]
+ *
+ * The lists are shuffled, as MRU order is after a while, so that each
+ * walk jumps around memory the way it does in a long running session.
+ */
+
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "calmwm.h"
+
+#define NGROUP		10
+#define XMAX		3840
+#define YMAX		2160
+
+/* struct client_ctx as it was before the hot/cold split. */
+struct oclient {
+	TAILQ_ENTRY(oclient)	 entry;
+	TAILQ_ENTRY(oclient)	 group_entry;
+	TAILQ_ENTRY(oclient)	 mru_entry;
+	struct screen_ctx	*sc;
+	Window			 win;
+	XSizeHints		*size;
+	Colormap		 cmap;
+	u_int			 bwidth;
+	struct client_geom	 geom, savegeom;
+	struct {
+		int		 basew, baseh, minw, minh;
+		int		 maxw, maxh, incw, inch;
+		float		 mina, maxa;
+	} hint;
+	struct {
+		int		 x, y;
+	} ptr;
+	int			 xproto;
+	int			 flags;
+	int			 state;
+	int			 active;
+	int			 stackingorder;
+	int			 highlight;
+	char			*nameq[CLIENT_MAXNAMEQLEN];
+	int			 namehead;
+	int			 nameqlen;
+	char			*name;
+	char			*label;
+	char			*matchname;
+	void			*group;
+	char			*app_class;
+	char			*app_name;
+};
+TAILQ_HEAD(oclient_q, oclient);
+
+static struct oclient_q	 oclientq, omruq, ogroupq[NGROUP];
+static struct client_ctx_q newclientq, ngroupq[NGROUP];
+static struct cycle_entry_q nmruq;
+static struct pool	 client_pool =
+    POOL_INITIALIZER_ALIGN("client", sizeof(struct client_ctx), CACHELINE);
+static struct pool	 client_cold_pool =
+    POOL_INITIALIZER("client_cold", sizeof(struct client_cold));
+static int		 groups[NGROUP];
+
+static void		 setup(int);
+static int		 align_old(struct oclient *);
+static int		 align_new(struct client_ctx *);
+static int		 cycle_old(void);
+static int		 cycle_new(void);
+static int		 reflow_old(int);
+static int		 reflow_new(int);
+static void		 shuffle(int *, int);
+static double		 now(void);
+static int		 dcmp(const void *, const void *);
+
+#define ADJUST(to, cc, amt) do {					\
+	if ((cc)->geom.y > (to)->geom.y + (to)->geom.height +		\
+	    2 * (int)(to)->bwidth &&					\
+	    abs((cc)->geom.y - (to)->geom.y - (to)->geom.height) < (amt))\
+		(amt)--;						\
+	if ((cc)->geom.x > (to)->geom.x + (to)->geom.width +		\
+	    2 * (int)(to)->bwidth &&					\
+	    abs((cc)->geom.x - (to)->geom.x - (to)->geom.width) < (amt))\
+		(amt)--;						\
+} while (0)
+
+#define REFLOW(cc, xmax, ymax, moved) do {				\
+	if ((cc)->geom.y + (cc)->geom.height < 0)			\
+		(cc)->geom.y = 0, (moved)++;				\
+	else if ((cc)->geom.y >= (ymax))				\
+		(cc)->geom.y = MAX((ymax) - (cc)->geom.height -		\
+		    (int)(cc)->bwidth * 2, 0), (moved)++;		\
+	if ((cc)->geom.x < 0)						\
+		(cc)->geom.x = 0, (moved)++;				\
+	else if ((cc)->geom.x + (cc)->geom.width >= (xmax))		\
+		(cc)->geom.x = MAX((xmax) - (cc)->geom.width -		\
+		    (int)(cc)->bwidth * 2, 0), (moved)++;		\
+} while (0)
+
+int
+main(int argc, char *argv[])
+{
+	struct oclient		*occ;
+	struct client_ctx	*ncc;
+	double			*t[6], t0;
+	int			 ch, i, j, sum[2] = { 0, 0 };
+	int			 nclients = 5000, rounds = 20;
+	const char		*names[] = { "align", "cycle", "reflow" };
+
+	while ((ch = getopt(argc, argv, "c:n:")) != -1) {
+		switch (ch) {
+		case 'c':
+			nclients = atoi(optarg);
+			break;
+		case 'n':
+			rounds = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: clients [-c nclients] "
+			    "[-n rounds]\n");
+			exit(1);
+		}
+	}
+	if (nclients < 2 || rounds < 1)
+		errx(1, "bad arguments");
+
+	setup(nclients);
+	for (i = 0; i < 6; i++)
+		t[i] = xcalloc(rounds, sizeof(*t[i]));
+
+	for (i = 0; i < rounds; i++) {
+		/* A keyboard move: align against every other client, 64x. */
+		occ = TAILQ_FIRST(&oclientq);
+		t0 = now();
+		for (j = 0; j < 64; j++)
+			sum[0] += align_old(occ);
+		t[0][i] = now() - t0;
+		ncc = TAILQ_FIRST(&newclientq);
+		t0 = now();
+		for (j = 0; j < 64; j++)
+			sum[1] += align_new(ncc);
+		t[1][i] = now() - t0;
+
+		t0 = now();
+		sum[0] += cycle_old();
+		t[2][i] = now() - t0;
+		t0 = now();
+		sum[1] += cycle_new();
+		t[3][i] = now() - t0;
+
+		/* Shrink and regrow the screen, as a RandR change does. */
+		t0 = now();
+		sum[0] += reflow_old(XMAX / 2) + reflow_old(XMAX);
+		t[4][i] = now() - t0;
+		t0 = now();
+		sum[1] += reflow_new(XMAX / 2) + reflow_new(XMAX);
+		t[5][i] = now() - t0;
+	}
+	if (sum[0] != sum[1])
+		errx(1, "layouts disagree: %d != %d", sum[0], sum[1]);
+
+	printf("%d clients, %d rounds, median; client_ctx %zu bytes, "
+	    "was %zu\n", nclients, rounds, sizeof(struct client_ctx),
+	    sizeof(struct oclient));
+	for (i = 0; i < 3; i++) {
+		qsort(t[2 * i], rounds, sizeof(double), dcmp);
+		qsort(t[2 * i + 1], rounds, sizeof(double), dcmp);
+		printf("%-8s old %8.3f ms  new %8.3f ms\n", names[i],
+		    t[2 * i][rounds / 2] * 1e3, t[2 * i + 1][rounds / 2] * 1e3);
+	}
+
+	return (0);
+}
+
+/*
+ * Both layouts get the same clients, in the same (shuffled) orders,
+ * allocated interleaved as client_new() and its callers did.
+ */
+static void
+setup(int n)
+{
+	struct oclient		**ov;
+	struct client_ctx	**nv;
+	char			  buf[64];
+	int			 *perm, i, k;
+
+	ov = xcalloc(n, sizeof(*ov));
+	nv = xcalloc(n, sizeof(*nv));
+	perm = xcalloc(n, sizeof(*perm));
+	TAILQ_INIT(&oclientq);
+	TAILQ_INIT(&omruq);
+	TAILQ_INIT(&newclientq);
+	TAILQ_INIT(&nmruq);
+	for (k = 0; k < NGROUP; k++) {
+		TAILQ_INIT(&ogroupq[k]);
+		TAILQ_INIT(&ngroupq[k]);
+	}
+
+	srandom(1);
+	for (i = 0; i < n; i++) {
+		(void)snprintf(buf, sizeof(buf), "xterm %d: ~/src", i);
+
+		ov[i] = xcalloc(1, sizeof(*ov[i]));
+		ov[i]->size = xcalloc(1, sizeof(XSizeHints));
+		ov[i]->name = xstrdup(buf);
+		ov[i]->app_class = xstrdup("XTerm");
+
+		nv[i] = pool_get(&client_pool);
+		nv[i]->cold = pool_get(&client_cold_pool);
+		nv[i]->name = xstrdup(buf);
+		nv[i]->cold->app_class = xstrdup("XTerm");
+
+		ov[i]->geom.x = nv[i]->geom.x = random() % XMAX;
+		ov[i]->geom.y = nv[i]->geom.y = random() % YMAX;
+		ov[i]->geom.width = nv[i]->geom.width = 200 + random() % 800;
+		ov[i]->geom.height = nv[i]->geom.height = 100 + random() % 600;
+		ov[i]->bwidth = nv[i]->bwidth = 1;
+		ov[i]->flags = nv[i]->flags =
+		    (random() % 4 == 0) ? CLIENT_HIDDEN : 0;
+		k = random() % NGROUP;
+		ov[i]->group = nv[i]->group = (void *)&groups[k];
+	}
+
+	shuffle(perm, n);
+	for (i = 0; i < n; i++) {
+		k = (int *)ov[perm[i]]->group - groups;
+		TAILQ_INSERT_TAIL(&oclientq, ov[perm[i]], entry);
+		TAILQ_INSERT_TAIL(&ogroupq[k], ov[perm[i]], group_entry);
+		TAILQ_INSERT_TAIL(&newclientq, nv[perm[i]], entry);
+		TAILQ_INSERT_TAIL(&ngroupq[k], nv[perm[i]], group_entry);
+	}
+	shuffle(perm, n);
+	for (i = 0; i < n; i++) {
+		TAILQ_INSERT_TAIL(&omruq, ov[perm[i]], mru_entry);
+		TAILQ_INSERT_TAIL(&nmruq, nv[perm[i]], mru_entry);
+	}
+
+	xfree(perm);
+	xfree(ov);
+	xfree(nv);
+}
+
+static int
+align_old(struct oclient *cc)
+{
+	struct oclient	*scc;
+	int		 k, amt = 1000;
+
+	for (k = 0; k < NGROUP; k++)
+		TAILQ_FOREACH(scc, &ogroupq[k], group_entry) {
+			if (cc == scc || scc->flags & CLIENT_HIDDEN)
+				continue;
+			ADJUST(scc, cc, amt);
+		}
+	return (amt);
+}
+
+static int
+align_new(struct client_ctx *cc)
+{
+	struct client_ctx	*scc;
+	int			 k, amt = 1000;
+
+	for (k = 0; k < NGROUP; k++)
+		TAILQ_FOREACH(scc, &ngroupq[k], group_entry) {
+			if (cc == scc || scc->flags & CLIENT_HIDDEN)
+				continue;
+			ADJUST(scc, cc, amt);
+		}
+	return (amt);
+}
+
+/* Cycle through every client of the first one's group. */
+static int
+cycle_old(void)
+{
+	struct oclient	*oldcc, *cc;
+	int		 n = 0;
+
+	oldcc = TAILQ_FIRST(&omruq);
+	for (cc = TAILQ_NEXT(oldcc, mru_entry); cc != NULL;
+	    cc = TAILQ_NEXT(cc, mru_entry))
+		if (!(cc->flags & (CLIENT_HIDDEN|CLIENT_IGNORE)) &&
+		    cc->group == oldcc->group)
+			n++;
+	return (n);
+}
+
+static int
+cycle_new(void)
+{
+	struct client_ctx	*oldcc, *cc;
+	int			 n = 0;
+
+	oldcc = TAILQ_FIRST(&nmruq);
+	for (cc = TAILQ_NEXT(oldcc, mru_entry); cc != NULL;
+	    cc = TAILQ_NEXT(cc, mru_entry))
+		if (!(cc->flags & (CLIENT_HIDDEN|CLIENT_IGNORE)) &&
+		    cc->group == oldcc->group)
+			n++;
+	return (n);
+}
+
+static int
+reflow_old(int xmax)
+{
+	struct oclient	*cc;
+	int		 moved = 0;
+
+	TAILQ_FOREACH(cc, &oclientq, entry)
+		REFLOW(cc, xmax, YMAX, moved);
+	return (moved);
+}
+
+static int
+reflow_new(int xmax)
+{
+	struct client_ctx	*cc;
+	int			 moved = 0;
+
+	TAILQ_FOREACH(cc, &newclientq, entry)
+		REFLOW(cc, xmax, YMAX, moved);
+	return (moved);
+}
+
+static void
+shuffle(int *v, int n)
+{
+	int	 i, j, p;
+
+	for (i = 0; i < n; i++)
+		v[i] = i;
+	for (i = n - 1; i > 0; i--) {
+		j = random() % (i + 1);
+		p = v[i];
+		v[i] = v[j];
+		v[j] = p;
+	}
+}
+
+static double
+now(void)
+{
+	struct timespec	 ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static int
+dcmp(const void *a, const void *b)
+{
+	double	 x = *(const double *)a, y = *(const double *)b;
+
+	return ((x > y) - (x < y));
+}
@@ -0,0 +1,263 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * ssh menu benchmark: time to build the menu from a generated
+ * known_hosts of nlines lines, with the fgetln loop kbfunc_ssh() used
+ * to run against hosts_fill(), both right after the file changed
+ * ("index") and with nothing changed ("cached").
+ *
+ *	usage: hosts [-l nlines] [-n rounds]
+ *
+ * One line in ten repeats an earlier host, one in twenty is hashed.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "calmwm.h"
+
+#define KNOWN_HOSTS	".ssh/known_hosts"
+#define HASH_MARKER	"|1|"
+#define KEY		"ssh-ed25519 AAAAC3NzaC1lZDI1NTE5AAAAIOMqqnkVzrm0SdG6UOoqKLsabgH5C9okWi0dh2l9GKJl"
+
+struct conf		 Conf;
+
+static char		 home[] = "/tmp/cwm-hosts.XXXXXXXXXX";
+static char		 known[MAXPATHLEN];
+
+static void		 mkhome(int);
+static int		 fill_old(struct menu_q *);
+static int		 fill_new(struct menu_q *);
+static double		 now(void);
+static int		 dcmp(const void *, const void *);
+static void		 cleanup(void);
+
+/* search.c wants this for client menus, which are not used here. */
+struct client_ctx *
+client_current(void)
+{
+	return (NULL);
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct menu_q	 menuq;
+	struct timespec	 ts[2];
+	double		*told, *tnew, *tcached, t;
+	int		 ch, i, n, nold = 0, nnew = 0;
+	int		 nlines = 50000, rounds = 20;
+
+	while ((ch = getopt(argc, argv, "l:n:")) != -1) {
+		switch (ch) {
+		case 'l':
+			nlines = atoi(optarg);
+			break;
+		case 'n':
+			rounds = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: hosts [-l nlines] [-n rounds]\n");
+			exit(1);
+		}
+	}
+	if (nlines < 1 || rounds < 1)
+		errx(1, "bad arguments");
+
+	mkhome(nlines);
+	atexit(cleanup);
+
+	told = xcalloc(rounds, sizeof(*told));
+	tnew = xcalloc(rounds, sizeof(*tnew));
+	tcached = xcalloc(rounds, sizeof(*tcached));
+
+	for (i = 0; i < rounds; i++) {
+		menuq_init(&menuq);
+		t = now();
+		nold = fill_old(&menuq);
+		told[i] = now() - t;
+		menuq_clear(&menuq);
+
+		/* Make the file look changed. */
+		ts[0].tv_sec = ts[1].tv_sec = 1000000000;
+		ts[0].tv_nsec = ts[1].tv_nsec = i + 1;
+		if (utimensat(AT_FDCWD, known, ts, 0) == -1)
+			err(1, "%s", known);
+		menuq_init(&menuq);
+		t = now();
+		nnew = fill_new(&menuq);
+		tnew[i] = now() - t;
+		menuq_clear(&menuq);
+
+		menuq_init(&menuq);
+		t = now();
+		n = fill_new(&menuq);
+		tcached[i] = now() - t;
+		menuq_clear(&menuq);
+		if (n != nnew)
+			errx(1, "cached index has %d, not %d", n, nnew);
+	}
+
+	qsort(told, rounds, sizeof(*told), dcmp);
+	qsort(tnew, rounds, sizeof(*tnew), dcmp);
+	qsort(tcached, rounds, sizeof(*tcached), dcmp);
+
+	printf("%d lines, %d rounds, median\n", nlines, rounds);
+	printf("%-8s %8.3f ms %6d entries\n", "old", told[rounds / 2] * 1e3,
+	    nold);
+	printf("%-8s %8.3f ms %6d entries\n", "index",
+	    tnew[rounds / 2] * 1e3, nnew);
+	printf("%-8s %8.3f ms %6d entries\n", "cached",
+	    tcached[rounds / 2] * 1e3, nnew);
+
+	return (0);
+}
+
+static void
+mkhome(int nlines)
+{
+	FILE	*fp;
+	char	 dir[MAXPATHLEN];
+	int	 i;
+
+	if (mkdtemp(home) == NULL)
+		err(1, "mkdtemp");
+	(void)snprintf(dir, sizeof(dir), "%s/.ssh", home);
+	if (mkdir(dir, 0700) == -1)
+		err(1, "%s", dir);
+
+	(void)snprintf(known, sizeof(known), "%s/%s", home, KNOWN_HOSTS);
+	if ((fp = fopen(known, "w")) == NULL)
+		err(1, "%s", known);
+	for (i = 0; i < nlines; i++) {
+		if (i % 20 == 19)
+			fprintf(fp, "|1|c2FsdCVk%08d=|aGFzaCVk%08d= %s\n",
+			    i, i, KEY);
+		else if (i % 10 == 9)
+			fprintf(fp, "host%d.example.org,10.%d.%d.%d %s\n",
+			    i / 2, (i / 2 >> 16) & 255, (i / 2 >> 8) & 255,
+			    i / 2 & 255, KEY);
+		else
+			fprintf(fp, "host%d.example.org,10.%d.%d.%d %s\n",
+			    i, (i >> 16) & 255, (i >> 8) & 255, i & 255, KEY);
+	}
+	(void)fclose(fp);
+
+	(void)snprintf(dir, sizeof(dir), "%s/.ssh/config", home);
+	if ((fp = fopen(dir, "w")) == NULL)
+		err(1, "%s", dir);
+	for (i = 0; i < 100; i++)
+		fprintf(fp, "Host alias%d a%d\n\tHostName host%d.example.org\n",
+		    i, i, i);
+	fprintf(fp, "Host *\n\tServerAliveInterval 60\n");
+	(void)fclose(fp);
+
+	if (setenv("HOME", home, 1) == -1)
+		err(1, "setenv");
+}
+
+/* The loop kbfunc_ssh() used to run. */
+static int
+fill_old(struct menu_q *menuq)
+{
+	FILE		*fp;
+	char		*buf, *lbuf, *p;
+	char		 hostbuf[MAXHOSTNAMELEN];
+	size_t		 len;
+	int		 n = 0;
+
+	if ((fp = fopen(known, "r")) == NULL)
+		err(1, "%s", known);
+
+	lbuf = NULL;
+	while ((buf = fgetln(fp, &len))) {
+		if (buf[len - 1] == '\n')
+			buf[len - 1] = '\0';
+		else {
+			lbuf = xmalloc(len + 1);
+			(void)memcpy(lbuf, buf, len);
+			lbuf[len] = '\0';
+			buf = lbuf;
+		}
+		if (strncmp(buf, HASH_MARKER, strlen(HASH_MARKER)) == 0)
+			continue;
+		for (p = buf; *p != ',' && *p != ' ' && p != buf + len; p++) {
+			/* do nothing */
+		}
+		if (p - buf + 1 > sizeof(hostbuf))
+			continue;
+		(void)strlcpy(hostbuf, buf, p - buf + 1);
+		(void)menuq_add(menuq, NULL, "%s", hostbuf);
+		n++;
+	}
+	xfree(lbuf);
+	(void)fclose(fp);
+
+	search_sort(menuq);
+
+	return (n);
+}
+
+static int
+fill_new(struct menu_q *menuq)
+{
+	struct menu	*mi;
+	int		 n = 0;
+
+	if (hosts_fill(menuq) == -1)
+		errx(1, "no hosts");
+	TAILQ_FOREACH(mi, menuq, entry)
+		n++;
+
+	return (n);
+}
+
+static double
+now(void)
+{
+	struct timespec	 ts;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static int
+dcmp(const void *a, const void *b)
+{
+	double	 x = *(const double *)a, y = *(const double *)b;
+
+	return (x < y ? -1 : x > y);
+}
+
+static void
+cleanup(void)
+{
+	char	 cmd[MAXPATHLEN + 16];
+
+	(void)snprintf(cmd, sizeof(cmd), "rm -rf %s", home);
+	(void)system(cmd);
+}
@@ -0,0 +1,173 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Logging benchmark: the cost of one message as the event loop would
+ * log it, through the old write_log() (vfprintf and fflush to the file)
+ * and through log_write() into the ring, flushed every nflush messages
+ * as the idle loop would.  A compiled out log_debug() is timed too.
+ *
+ *	usage: log [-f nflush] [-n nmsgs] [-t nthreads]
+ *
+ * With -t, that many more threads log while the main thread does, to
+ * show the rings do not contend.
+ */
+
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include <err.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "calmwm.h"
+
+static char		 home[] = "/tmp/cwm-log.XXXXXXXXXX";
+static FILE		*oldlog;
+static volatile int	 stop;
+
+static void		 write_log(const char *, ...);
+static void		*logger(void *);
+static double		 now(void);
+static void		 cleanup(void);
+
+int
+main(int argc, char *argv[])
+{
+	pthread_t	*tids;
+	char		 path[MAXPATHLEN];
+	double		 t, told, tnew, tflush = 0, toff;
+	int		 ch, i, j, nmsgs = 200000, nflush = 64, nthreads = 0;
+
+	while ((ch = getopt(argc, argv, "f:n:t:")) != -1) {
+		switch (ch) {
+		case 'f':
+			nflush = atoi(optarg);
+			break;
+		case 'n':
+			nmsgs = atoi(optarg);
+			break;
+		case 't':
+			nthreads = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: log [-f nflush] [-n nmsgs] "
+			    "[-t nthreads]\n");
+			exit(1);
+		}
+	}
+	if (nmsgs < 1 || nflush < 1 || nflush > 256 || nthreads < 0)
+		errx(1, "bad arguments");
+
+	if (mkdtemp(home) == NULL)
+		err(1, "mkdtemp");
+	atexit(cleanup);
+	if (setenv("HOME", home, 1) == -1)
+		err(1, "setenv");
+
+	(void)snprintf(path, sizeof(path), "%s/old.log", home);
+	if ((oldlog = fopen(path, "w")) == NULL)
+		err(1, "%s", path);
+	setvbuf(oldlog, NULL, _IOLBF, 0);
+	t = now();
+	for (i = 0; i < nmsgs; i++)
+		write_log("event %d window 0x%lx\n", i % 35, 0x1200000UL + i);
+	told = now() - t;
+
+	tids = xcalloc(nthreads + 1, sizeof(*tids));
+	for (i = 0; i < nthreads; i++)
+		if (pthread_create(&tids[i], NULL, logger, NULL) != 0)
+			errx(1, "pthread_create");
+
+	/* Batches of nflush messages, each followed by a flush. */
+	tnew = 0;
+	for (i = 0; i < nmsgs; i += nflush) {
+		t = now();
+		for (j = i; j < i + nflush && j < nmsgs; j++)
+			log_info("event %d window 0x%lx", j % 35,
+			    0x1200000UL + j);
+		tnew += now() - t;
+		t = now();
+		log_flush();
+		tflush += now() - t;
+	}
+
+	t = now();
+	for (i = 0; i < nmsgs; i++)
+		log_debug("event %d window 0x%lx", i % 35, 0x1200000UL + i);
+	toff = now() - t;
+
+	stop = 1;
+	for (i = 0; i < nthreads; i++)
+		pthread_join(tids[i], NULL);
+	log_flush();
+
+	printf("%d messages, %d other threads, per message\n", nmsgs,
+	    nthreads);
+	printf("%-10s %8.1f ns\n", "write_log", told / nmsgs * 1e9);
+	printf("%-10s %8.1f ns\n", "log_info", tnew / nmsgs * 1e9);
+	printf("%-10s %8.1f ns\n", "flush", tflush / nmsgs * 1e9);
+	printf("%-10s %8.1f ns\n", "log_debug", toff / nmsgs * 1e9);
+
+	return (0);
+}
+
+/* log.c before the rings. */
+static void
+write_log(const char *fmt, ...)
+{
+	va_list	 ap;
+
+	va_start(ap, fmt);
+	vfprintf(oldlog, fmt, ap);
+	va_end(ap);
+	fflush(oldlog);
+}
+
+static void *
+logger(void *arg)
+{
+	int	 i = 0;
+
+	while (!stop) {
+		log_info("thread %p message %d", (void *)&i, i);
+		i++;
+	}
+	return (NULL);
+}
+
+static double
+now(void)
+{
+	struct timespec	 ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static void
+cleanup(void)
+{
+	char	 cmd[MAXPATHLEN + 16];
+
+	(void)snprintf(cmd, sizeof(cmd), "rm -rf %s", home);
+	(void)system(cmd);
+}
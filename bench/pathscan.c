@@ -0,0 +1,344 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * PATH scanning benchmark: the serial snprintf/access loop kbfunc_exec()
+ * used to run, against the pathcache scanner, on a made up $PATH of
+ * ndirs directories holding nfiles entries in all.
+ *
+ *	usage: pathscan [-d ndirs] [-f nfiles] [-n rounds]
+ *
+ * Most entries are executables; the rest are plain files, symlinks to
+ * executables, subdirectories and symlinks to directories.  The scanner
+ * is timed both with every directory changed ("scan") and with nothing
+ * changed ("cached").
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include <dirent.h>
+#include <err.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "calmwm.h"
+
+#define NPATHS	256
+
+struct conf		 Conf;
+
+static char		 root[] = "/tmp/cwm-pathscan.XXXXXXXXXX";
+static char		*oldpath;
+static int		 ndirs = 20, nfiles = 10000;
+
+static void		 mkpath(void);
+static void		 touchpath(void);
+static int		 scan_old(struct menu_q *);
+static int		 scan_new(struct menu_q *);
+static double		 now(void);
+static int		 dcmp(const void *, const void *);
+static void		 cleanup(void);
+
+/* search.c wants this for client menus, which are not used here. */
+struct client_ctx *
+client_current(void)
+{
+	return (NULL);
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct menu_q	 menuq;
+	double		*told, *tnew, *tcached, t;
+	int		 ch, i, n, nold = 0, nnew = 0, rounds = 20;
+
+	while ((ch = getopt(argc, argv, "d:f:n:")) != -1) {
+		switch (ch) {
+		case 'd':
+			ndirs = atoi(optarg);
+			break;
+		case 'f':
+			nfiles = atoi(optarg);
+			break;
+		case 'n':
+			rounds = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr,
+			    "usage: pathscan [-d ndirs] [-f nfiles] [-n rounds]\n");
+			exit(1);
+		}
+	}
+	if (ndirs < 1 || ndirs > NPATHS - 1 || nfiles < ndirs || rounds < 1)
+		errx(1, "bad arguments");
+
+	mkpath();
+	atexit(cleanup);
+
+	told = xcalloc(rounds, sizeof(*told));
+	tnew = xcalloc(rounds, sizeof(*tnew));
+	tcached = xcalloc(rounds, sizeof(*tcached));
+
+	for (i = 0; i < rounds; i++) {
+		menuq_init(&menuq);
+		t = now();
+		nold = scan_old(&menuq);
+		told[i] = now() - t;
+		menuq_clear(&menuq);
+
+		touchpath();
+		menuq_init(&menuq);
+		t = now();
+		nnew = scan_new(&menuq);
+		tnew[i] = now() - t;
+		menuq_clear(&menuq);
+
+		menuq_init(&menuq);
+		t = now();
+		n = scan_new(&menuq);
+		tcached[i] = now() - t;
+		menuq_clear(&menuq);
+		if (n != nnew)
+			errx(1, "cached scan found %d, not %d", n, nnew);
+	}
+
+	qsort(told, rounds, sizeof(*told), dcmp);
+	qsort(tnew, rounds, sizeof(*tnew), dcmp);
+	qsort(tcached, rounds, sizeof(*tcached), dcmp);
+
+	printf("%d dirs, %d entries, %d rounds, median\n",
+	    ndirs, nfiles, rounds);
+	printf("%-8s %8.3f ms %6d found\n", "old", told[rounds / 2] * 1e3,
+	    nold);
+	printf("%-8s %8.3f ms %6d found\n", "scan", tnew[rounds / 2] * 1e3,
+	    nnew);
+	printf("%-8s %8.3f ms %6d found\n", "cached",
+	    tcached[rounds / 2] * 1e3, nnew);
+
+	return (0);
+}
+
+static void
+mkpath(void)
+{
+	char	 dir[MAXPATHLEN], file[MAXPATHLEN], target[MAXPATHLEN];
+	char	*path;
+	size_t	 len;
+	int	 d, f, fd, nper;
+
+	if (mkdtemp(root) == NULL)
+		err(1, "mkdtemp");
+
+	len = ndirs * (strlen(root) + 16) + 1;
+	path = xcalloc(1, len);
+	nper = nfiles / ndirs;
+
+	for (d = 0; d < ndirs; d++) {
+		(void)snprintf(dir, sizeof(dir), "%s/bin%d", root, d);
+		if (mkdir(dir, 0755) == -1)
+			err(1, "%s", dir);
+		if (d > 0)
+			(void)strlcat(path, ":", len);
+		(void)strlcat(path, dir, len);
+
+		for (f = 0; f < nper; f++) {
+			(void)snprintf(file, sizeof(file), "%s/cmd%d-%d",
+			    dir, d, f);
+			switch (f % 20) {
+			case 0:
+			case 1:
+				/* plain file */
+				if ((fd = open(file, O_CREAT | O_WRONLY,
+				    0644)) == -1)
+					err(1, "%s", file);
+				(void)close(fd);
+				break;
+			case 2:
+			case 3:
+				/* symlink to an executable */
+				(void)snprintf(target, sizeof(target),
+				    "cmd%d-%d", d, f + 4);
+				if (symlink(target, file) == -1)
+					err(1, "%s", file);
+				break;
+			case 4:
+				if (mkdir(file, 0755) == -1)
+					err(1, "%s", file);
+				break;
+			case 5:
+				/* symlink to a directory */
+				if (symlink(".", file) == -1)
+					err(1, "%s", file);
+				break;
+			default:
+				if ((fd = open(file, O_CREAT | O_WRONLY,
+				    0755)) == -1)
+					err(1, "%s", file);
+				(void)close(fd);
+				break;
+			}
+		}
+	}
+
+	if ((oldpath = getenv("PATH")) != NULL)
+		oldpath = xstrdup(oldpath);
+	if (setenv("PATH", path, 1) == -1)
+		err(1, "setenv");
+	xfree(path);
+}
+
+/* Make every directory look changed to the cache. */
+static void
+touchpath(void)
+{
+	struct timespec	 ts[2];
+	char		 dir[MAXPATHLEN];
+	static long	 nsec;
+	int		 d;
+
+	ts[0].tv_sec = ts[1].tv_sec = 1000000000;
+	ts[0].tv_nsec = ts[1].tv_nsec = ++nsec;
+	for (d = 0; d < ndirs; d++) {
+		(void)snprintf(dir, sizeof(dir), "%s/bin%d", root, d);
+		if (utimensat(AT_FDCWD, dir, ts, 0) == -1)
+			err(1, "%s", dir);
+	}
+}
+
+/* The loop kbfunc_exec() used to run. */
+static int
+scan_old(struct menu_q *menuq)
+{
+	char		**ap, *paths[NPATHS], *path, *pathcpy;
+	char		 tpath[MAXPATHLEN];
+	DIR		*dirp;
+	struct dirent	*dp;
+	int		 l, i, j, n = 0;
+
+	path = getenv("PATH");
+	pathcpy = path = xstrdup(path);
+
+	for (ap = paths; ap < &paths[NPATHS - 1] &&
+	    (*ap = strsep(&pathcpy, ":")) != NULL;) {
+		if (**ap != '\0')
+			ap++;
+	}
+	*ap = NULL;
+	for (i = 0; i < NPATHS && paths[i] != NULL; i++) {
+		if ((l = readlink(paths[i], tpath, sizeof(tpath) - 1)) != -1) {
+			tpath[l] = '\0';
+			for (j = 0; j < NPATHS && paths[j] != NULL; ++j) {
+				if (!strcmp(paths[j], tpath))
+					break;
+			}
+			if (j < NPATHS || paths[j] != NULL)
+				continue;
+		}
+		for (j = 0; j < i; ++j) {
+			if (!strcmp(paths[i], paths[j]))
+				break;
+		}
+		if (j < i)
+			continue;
+
+		if ((dirp = opendir(paths[i])) == NULL)
+			continue;
+
+		while ((dp = readdir(dirp)) != NULL) {
+			if (dp->d_type != DT_REG && dp->d_type != DT_LNK)
+				continue;
+			(void)memset(tpath, '\0', sizeof(tpath));
+			l = snprintf(tpath, sizeof(tpath), "%s/%s", paths[i],
+			    dp->d_name);
+			if (l == -1 || l >= (int)sizeof(tpath))
+				continue;
+			if (access(tpath, X_OK) == 0) {
+				(void)menuq_add(menuq, NULL, "%s",
+				    dp->d_name);
+				n++;
+			}
+		}
+		(void)closedir(dirp);
+	}
+	xfree(path);
+
+	search_sort(menuq);
+
+	return (n);
+}
+
+/* What the exec menu does now, minus the drawing. */
+static int
+scan_new(struct menu_q *menuq)
+{
+	struct menu_feed	 feed;
+	struct pollfd		 pfd;
+	struct menu		*mi;
+	int			 n = 0;
+
+	pathcache_start(&feed, menuq);
+	while (feed.fd != -1) {
+		pfd.fd = feed.fd;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, -1) == -1)
+			err(1, "poll");
+		if ((*feed.fill)(menuq, feed.arg) == 0)
+			feed.fd = -1;
+	}
+	pathcache_stop(&feed);
+
+	TAILQ_FOREACH(mi, menuq, entry)
+		n++;
+
+	return (n);
+}
+
+static double
+now(void)
+{
+	struct timespec	 ts;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static int
+dcmp(const void *a, const void *b)
+{
+	double	 x = *(const double *)a, y = *(const double *)b;
+
+	return (x < y ? -1 : x > y);
+}
+
+static void
+cleanup(void)
+{
+	char	 cmd[MAXPATHLEN + 16];
+
+	if (oldpath != NULL)
+		(void)setenv("PATH", oldpath, 1);
+	(void)snprintf(cmd, sizeof(cmd), "rm -rf %s", root);
+	(void)system(cmd);
+}
@@ -0,0 +1,684 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Replay of a recording cwm made with CWM_RECORD set against a running
+ * cwm, normally the one bench/xbench.sh starts under Xvfb, as the
+ * clients and the user that caused it:
+ *
+ *	usage: replay [-lp] [-r rounds] file
+ *
+ *	-l	list the recording instead, no X server needed
+ *	-p	keep the recorded time between events, rather than
+ *		replaying as fast as the server takes it
+ *
+ * Windows are made with the geometry, title and class cwm read of them,
+ * and mapped, configured, retitled, withdrawn and destroyed as they
+ * were; client messages are sent again; keys, buttons, pointer motion
+ * are pressed and moved through XTEST; screen changes are made with
+ * RandR.  What cwm did itself, the unmaps of hiding, the crossings and
+ * exposures, follows from that, and is not replayed.  Windows there
+ * before the first event are made before the clock starts.
+ *
+ * Each round is timed until cwm has mapped a window mapped after the
+ * last event, so has handled everything before.  Prints a JSON line
+ * as bench/xbench does.
+ */
+
+#include <sys/param.h>
+#include <sys/stat.h>
+
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XTest.h>
+#include <X11/extensions/Xrandr.h>
+
+#include <err.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rec.h"
+
+#define TIMEOUT		5	/* seconds to wait for cwm */
+
+struct item {
+	uint32_t	 usec;
+	int		 kind;
+	const u_char	*data;
+	size_t		 len;
+};
+
+struct win {
+	uint32_t	 rec;
+	Window		 win;
+};
+
+struct atom {
+	uint32_t	 rec;
+	const char	*name;
+	Atom		 atom;
+};
+
+static void		 load(const char *);
+static void		 list(void);
+static double		 round_play(int);
+static void		 play(int);
+static void		 create(uint32_t, int);
+static const char	*lookahead(int, int, uint32_t);
+static Window		 wfind(uint32_t);
+static void		 wforget(uint32_t);
+static Atom		 atom(uint32_t);
+static const char	*atomname(uint32_t);
+static void		 mods(u_int, int);
+static void		 barrier(void);
+static int		 xerror(Display *, XErrorEvent *);
+static double		 now(void);
+static int		 dcmp(const void *, const void *);
+
+static const char	*evnames[LASTEvent] = {
+	[KeyPress] = "KeyPress",
+	[KeyRelease] = "KeyRelease",
+	[ButtonPress] = "ButtonPress",
+	[ButtonRelease] = "ButtonRelease",
+	[MotionNotify] = "MotionNotify",
+	[EnterNotify] = "EnterNotify",
+	[LeaveNotify] = "LeaveNotify",
+	[Expose] = "Expose",
+	[DestroyNotify] = "DestroyNotify",
+	[UnmapNotify] = "UnmapNotify",
+	[MapNotify] = "MapNotify",
+	[MapRequest] = "MapRequest",
+	[ConfigureNotify] = "ConfigureNotify",
+	[ConfigureRequest] = "ConfigureRequest",
+	[PropertyNotify] = "PropertyNotify",
+	[ClientMessage] = "ClientMessage",
+	[MappingNotify] = "MappingNotify",
+};
+
+static u_char		*buf;
+static struct rec_hdr	*hdr;
+static struct item	*items;
+static int		 nitem, nevents, first;
+static struct atom	*atoms;
+static int		 natoms;
+static struct win	*wins;
+static int		 nwins, winsize;
+
+static Display		*dpy;
+static Window		 root;
+static XModifierKeymap	*modmap;
+static int		 havextest, haverandr, pace;
+static int		 replayed, skipped;
+
+int
+main(int argc, char *argv[])
+{
+	double	*t, total = 0;
+	int	 ch, i, dolist = 0, rounds = 10;
+
+	while ((ch = getopt(argc, argv, "lpr:")) != -1) {
+		switch (ch) {
+		case 'l':
+			dolist = 1;
+			break;
+		case 'p':
+			pace = 1;
+			break;
+		case 'r':
+			rounds = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr,
+			    "usage: replay [-lp] [-r rounds] file\n");
+			exit(1);
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	if (argc != 1 || rounds < 1)
+		errx(1, "need a file and at least one round");
+
+	load(argv[0]);
+	if (dolist) {
+		list();
+		return (0);
+	}
+
+	if ((dpy = XOpenDisplay(NULL)) == NULL)
+		errx(1, "cannot open display");
+	root = DefaultRootWindow(dpy);
+	XSetErrorHandler(xerror);
+	havextest = XTestQueryExtension(dpy, &i, &i, &i, &i);
+	haverandr = XRRQueryExtension(dpy, &i, &i);
+	modmap = XGetModifierMapping(dpy);
+	if (DisplayWidth(dpy, DefaultScreen(dpy)) != hdr->width ||
+	    DisplayHeight(dpy, DefaultScreen(dpy)) != hdr->height)
+		warnx("recorded on a %dx%d screen", hdr->width, hdr->height);
+
+	if ((t = calloc(rounds, sizeof(*t))) == NULL)
+		err(1, NULL);
+	for (i = 0; i < rounds; i++) {
+		t[i] = round_play(i);
+		total += t[i];
+	}
+	qsort(t, rounds, sizeof(*t), dcmp);
+	printf("{\"scenario\":\"replay\",\"file\":\"%s\",\"events\":%d,"
+	    "\"replayed\":%d,\"skipped\":%d,\"rounds\":%d,"
+	    "\"total_ms\":%.3f,\"ops_per_s\":%.1f,\"p50_ms\":%.3f,"
+	    "\"p90_ms\":%.3f,\"max_ms\":%.3f}\n", argv[0], nevents,
+	    replayed / rounds, skipped / rounds, rounds, total * 1e3,
+	    replayed / total, t[rounds / 2] * 1e3, t[rounds * 9 / 10] * 1e3,
+	    t[rounds - 1] * 1e3);
+
+	free(t);
+	XFreeModifiermap(modmap);
+	XCloseDisplay(dpy);
+	return (0);
+}
+
+/*
+ * Read the whole recording and index its items.
+ */
+static void
+load(const char *path)
+{
+	struct rec_item	 ri;
+	struct stat	 st;
+	FILE		*fp;
+	size_t		 off, len;
+	int		 size = 0;
+
+	if ((fp = fopen(path, "r")) == NULL || fstat(fileno(fp), &st) == -1)
+		err(1, "%s", path);
+	len = st.st_size;
+	if ((buf = malloc(len + 1)) == NULL)
+		err(1, NULL);
+	if (fread(buf, 1, len, fp) != len)
+		err(1, "%s", path);
+	(void)fclose(fp);
+	buf[len] = '\0';
+
+	hdr = (struct rec_hdr *)buf;
+	if (len < sizeof(*hdr) || hdr->magic != REC_MAGIC)
+		errx(1, "%s: not a recording", path);
+	if (hdr->version != REC_VERSION)
+		errx(1, "%s: version %u", path, hdr->version);
+
+	first = -1;
+	for (off = sizeof(*hdr); off < len; off += ri.len) {
+		if (len - off < sizeof(ri))
+			errx(1, "%s: cut short", path);
+		memcpy(&ri, buf + off, sizeof(ri));
+		off += sizeof(ri);
+		if (len - off < ri.len)
+			errx(1, "%s: cut short", path);
+		if (nitem == size) {
+			size = MAX(size * 2, 1024);
+			if ((items = reallocarray(items, size,
+			    sizeof(*items))) == NULL)
+				err(1, NULL);
+		}
+		items[nitem].usec = ri.usec;
+		items[nitem].kind = ri.kind;
+		items[nitem].data = buf + off;
+		items[nitem].len = ri.len;
+
+		switch (ri.kind) {
+		case REC_EVENT:
+			if (ri.len < sizeof(struct rec_event))
+				errx(1, "%s: bad event", path);
+			if (first == -1)
+				first = nitem;
+			nevents++;
+			break;
+		case REC_GEOM:
+			if (ri.len < sizeof(struct rec_geom))
+				errx(1, "%s: bad geometry", path);
+			break;
+		case REC_ATOM:
+		case REC_NAME:
+		case REC_CLASS:
+			if (ri.len <= sizeof(uint32_t) ||
+			    buf[off + ri.len - 1] != '\0')
+				errx(1, "%s: bad string", path);
+			if (ri.kind != REC_ATOM)
+				break;
+			if ((atoms = reallocarray(atoms, natoms + 1,
+			    sizeof(*atoms))) == NULL)
+				err(1, NULL);
+			memcpy(&atoms[natoms].rec, buf + off, sizeof(uint32_t));
+			atoms[natoms].name = (char *)buf + off +
+			    sizeof(uint32_t);
+			atoms[natoms].atom = None;
+			natoms++;
+			break;
+		}
+		nitem++;
+	}
+	if (first == -1)
+		first = nitem;
+}
+
+static void
+list(void)
+{
+	struct rec_event	 ev;
+	struct rec_geom		 g;
+	struct item		*it;
+	const char		*s;
+	uint32_t		 w;
+	double			 t = 0;
+	int			 i;
+
+	printf("%dx%d screen, %d items, %d events\n", hdr->width,
+	    hdr->height, nitem, nevents);
+	for (i = 0; i < nitem; i++) {
+		it = &items[i];
+		t += it->usec / 1e6;
+		printf("%12.6f ", t);
+		switch (it->kind) {
+		case REC_EVENT:
+			memcpy(&ev, it->data, sizeof(ev));
+			if (ev.type == REC_RANDR)
+				printf("RRScreenChange");
+			else if (ev.type < LASTEvent && evnames[ev.type])
+				printf("%s", evnames[ev.type]);
+			else
+				printf("event %u", ev.type);
+			printf(" 0x%x %d %d %d %d %d %d", ev.window,
+			    ev.arg[0], ev.arg[1], ev.arg[2], ev.arg[3],
+			    ev.arg[4], ev.arg[5]);
+			if (ev.type == PropertyNotify ||
+			    ev.type == ClientMessage)
+				printf(" %s", atomname(ev.arg[0]));
+			break;
+		case REC_GEOM:
+			memcpy(&g, it->data, sizeof(g));
+			printf("  geometry 0x%x %dx%d+%d+%d border %d%s",
+			    g.window, g.width, g.height, g.x, g.y, g.bwidth,
+			    g.mapped ? " mapped" : "");
+			break;
+		case REC_ATOM:
+		case REC_NAME:
+		case REC_CLASS:
+			memcpy(&w, it->data, sizeof(w));
+			s = (const char *)it->data + sizeof(w);
+			if (it->kind == REC_ATOM)
+				printf("  atom %u \"%s\"", w, s);
+			else if (it->kind == REC_NAME)
+				printf("  name 0x%x \"%s\"", w, s);
+			else
+				printf("  class 0x%x \"%s\" \"%s\"", w, s,
+				    s + strlen(s) + 1);
+			break;
+		default:
+			printf("  item %d, %zu bytes", it->kind, it->len);
+			break;
+		}
+		printf("\n");
+	}
+}
+
+/*
+ * One round: the windows there before, untimed, then the events until
+ * cwm is done with them, then everything gone again.
+ */
+static double
+round_play(int r)
+{
+	struct rec_geom	 g;
+	struct timespec	 ts;
+	double		 start, due, t;
+	int		 i;
+
+	for (i = 0; i < first; i++) {
+		if (items[i].kind != REC_GEOM)
+			continue;
+		memcpy(&g, items[i].data, sizeof(g));
+		if (wfind(g.window) == None) {
+			create(g.window, 0);
+			if (g.mapped)
+				XMapWindow(dpy, wfind(g.window));
+		}
+	}
+	barrier();
+
+	start = due = now();
+	for (i = first; i < nitem; i++) {
+		due += items[i].usec / 1e6;
+		if (items[i].kind != REC_EVENT)
+			continue;
+		if (pace && (t = due - now()) > 0) {
+			XFlush(dpy);
+			ts.tv_sec = t;
+			ts.tv_nsec = (t - ts.tv_sec) * 1e9;
+			(void)nanosleep(&ts, NULL);
+		}
+		play(i);
+	}
+	barrier();
+	t = now() - start;
+
+	for (i = 0; i < nwins; i++)
+		XDestroyWindow(dpy, wins[i].win);
+	nwins = 0;
+	barrier();
+	return (t);
+}
+
+static void
+play(int i)
+{
+	struct rec_event	 ev;
+	XWindowChanges		 wc;
+	XEvent			 e;
+	const char		*s;
+	Window			 w;
+	int			 j;
+
+	memcpy(&ev, items[i].data, sizeof(ev));
+	w = wfind(ev.window);
+	switch (ev.type) {
+	case MapRequest:
+		if (w == None) {
+			create(ev.window, i + 1);
+			w = wfind(ev.window);
+		}
+		XMapWindow(dpy, w);
+		break;
+	case ConfigureRequest:
+		if (w == None)
+			goto skip;
+		wc.x = ev.arg[0];
+		wc.y = ev.arg[1];
+		wc.width = MAX(ev.arg[2], 1);
+		wc.height = MAX(ev.arg[3], 1);
+		wc.border_width = ev.arg[4];
+		XConfigureWindow(dpy, w, ev.arg[5] & (CWX | CWY | CWWidth |
+		    CWHeight | CWBorderWidth), &wc);
+		break;
+	case UnmapNotify:
+		/* Only a withdrawal is surely the client's doing. */
+		if (w == None || !ev.arg[0])
+			goto skip;
+		XWithdrawWindow(dpy, w, DefaultScreen(dpy));
+		break;
+	case DestroyNotify:
+		if (w == None)
+			goto skip;
+		XDestroyWindow(dpy, w);
+		wforget(ev.window);
+		break;
+	case PropertyNotify:
+		s = atomname(ev.arg[0]);
+		if (w == None || ev.arg[1] != PropertyNewValue ||
+		    (strcmp(s, "WM_NAME") != 0 &&
+		    strcmp(s, "_NET_WM_NAME") != 0) ||
+		    (s = lookahead(i + 1, REC_NAME, ev.window)) == NULL)
+			goto skip;
+		XChangeProperty(dpy, w, atom(ev.arg[0]),
+		    XInternAtom(dpy, "UTF8_STRING", False), 8,
+		    PropModeReplace, (const u_char *)s, strlen(s));
+		break;
+	case ClientMessage:
+		if (w == None)
+			goto skip;
+		bzero(&e, sizeof(e));
+		e.xclient.type = ClientMessage;
+		e.xclient.window = w;
+		e.xclient.message_type = atom(ev.arg[0]);
+		e.xclient.format = 32;
+		for (j = 0; j < 5; j++)
+			e.xclient.data.l[j] = ev.arg[j + 1];
+		XSendEvent(dpy, root, False, SubstructureRedirectMask |
+		    SubstructureNotifyMask, &e);
+		break;
+	case KeyPress:
+		if (!havextest)
+			goto skip;
+		mods(ev.arg[1], True);
+		XTestFakeKeyEvent(dpy, ev.arg[0], True, CurrentTime);
+		XTestFakeKeyEvent(dpy, ev.arg[0], False, CurrentTime);
+		mods(ev.arg[1], False);
+		break;
+	case ButtonPress:
+	case ButtonRelease:
+		if (!havextest)
+			goto skip;
+		XTestFakeMotionEvent(dpy, -1, ev.arg[2], ev.arg[3],
+		    CurrentTime);
+		if (ev.type == ButtonPress)
+			mods(ev.arg[1], True);
+		XTestFakeButtonEvent(dpy, ev.arg[0], ev.type == ButtonPress,
+		    CurrentTime);
+		if (ev.type == ButtonRelease)
+			mods(ev.arg[1], False);
+		break;
+	case MotionNotify:
+		if (!havextest)
+			goto skip;
+		XTestFakeMotionEvent(dpy, -1, ev.arg[2], ev.arg[3],
+		    CurrentTime);
+		break;
+	case REC_RANDR:
+		if (!haverandr)
+			goto skip;
+		XRRSetScreenSize(dpy, root, ev.arg[0], ev.arg[1], ev.arg[2],
+		    ev.arg[3]);
+		break;
+	default:
+		goto skip;
+	}
+	replayed++;
+	return;
+skip:
+	skipped++;
+}
+
+/*
+ * Make a window as cwm saw it, from what follows item i.
+ */
+static void
+create(uint32_t rec, int i)
+{
+	struct rec_geom	 g, gj;
+	XClassHint	 class;
+	const char	*s;
+	Window		 w;
+	int		 j;
+
+	bzero(&g, sizeof(g));
+	g.width = g.height = 100;
+	for (j = i; j < nitem && items[j].kind != REC_EVENT; j++) {
+		if (items[j].kind != REC_GEOM)
+			continue;
+		memcpy(&gj, items[j].data, sizeof(gj));
+		if (gj.window == rec) {
+			g = gj;
+			break;
+		}
+	}
+	w = XCreateSimpleWindow(dpy, root, g.x, g.y, MAX(g.width, 1),
+	    MAX(g.height, 1), g.bwidth, 0, 0);
+	if ((s = lookahead(i, REC_NAME, rec)) != NULL)
+		XStoreName(dpy, w, s);
+	if ((s = lookahead(i, REC_CLASS, rec)) != NULL) {
+		class.res_name = (char *)s;
+		class.res_class = (char *)s + strlen(s) + 1;
+		XSetClassHint(dpy, w, &class);
+	}
+
+	if (nwins == winsize) {
+		winsize = MAX(winsize * 2, 64);
+		if ((wins = reallocarray(wins, winsize,
+		    sizeof(*wins))) == NULL)
+			err(1, NULL);
+	}
+	wins[nwins].rec = rec;
+	wins[nwins].win = w;
+	nwins++;
+}
+
+/*
+ * The string of the first item of kind for window rec from item i on,
+ * up to the next event; what cwm read because of the one before.
+ */
+static const char *
+lookahead(int i, int kind, uint32_t rec)
+{
+	uint32_t	 w;
+
+	for (; i < nitem && items[i].kind != REC_EVENT; i++) {
+		if (items[i].kind != kind)
+			continue;
+		memcpy(&w, items[i].data, sizeof(w));
+		if (w == rec)
+			return ((const char *)items[i].data + sizeof(w));
+	}
+	return (NULL);
+}
+
+static Window
+wfind(uint32_t rec)
+{
+	int	 i;
+
+	for (i = 0; i < nwins; i++)
+		if (wins[i].rec == rec)
+			return (wins[i].win);
+	return (None);
+}
+
+static void
+wforget(uint32_t rec)
+{
+	int	 i;
+
+	for (i = 0; i < nwins; i++)
+		if (wins[i].rec == rec) {
+			wins[i] = wins[--nwins];
+			return;
+		}
+}
+
+/* The atom of this server with the name the recorded one had. */
+static Atom
+atom(uint32_t rec)
+{
+	int	 i;
+
+	for (i = 0; i < natoms; i++)
+		if (atoms[i].rec == rec) {
+			if (atoms[i].atom == None)
+				atoms[i].atom = XInternAtom(dpy,
+				    atoms[i].name, False);
+			return (atoms[i].atom);
+		}
+	return (rec);
+}
+
+static const char *
+atomname(uint32_t rec)
+{
+	int	 i;
+
+	for (i = 0; i < natoms; i++)
+		if (atoms[i].rec == rec)
+			return (atoms[i].name);
+	return ("");
+}
+
+/* Press, or release, the keys of the modifiers in state. */
+static void
+mods(u_int state, int down)
+{
+	KeyCode	 kc;
+	int	 i;
+
+	for (i = 0; i < 8; i++) {
+		/* Not Lock or Mod2, Num Lock, which cwm ignores. */
+		if ((state & (1 << i)) == 0 || i == LockMapIndex ||
+		    i == Mod2MapIndex)
+			continue;
+		kc = modmap->modifiermap[i * modmap->max_keypermod];
+		if (kc != 0)
+			XTestFakeKeyEvent(dpy, kc, down, CurrentTime);
+	}
+}
+
+/*
+ * Map a window of our own and wait for cwm to have mapped it: cwm
+ * takes requests in order, so it is done with everything sent before.
+ */
+static void
+barrier(void)
+{
+	struct pollfd	 pfd;
+	XEvent		 e;
+	Window		 w;
+	double		 end = now() + TIMEOUT;
+
+	w = XCreateSimpleWindow(dpy, root, 0, 0, 10, 10, 0, 0, 0);
+	XSelectInput(dpy, w, StructureNotifyMask);
+	XMapWindow(dpy, w);
+	XFlush(dpy);
+
+	pfd.fd = ConnectionNumber(dpy);
+	pfd.events = POLLIN;
+	for (;;) {
+		while (XPending(dpy)) {
+			XNextEvent(dpy, &e);
+			if (e.type == MapNotify && e.xmap.window == w) {
+				XDestroyWindow(dpy, w);
+				XSync(dpy, False);
+				return;
+			}
+		}
+		if (now() > end)
+			errx(1, "timed out waiting for cwm");
+		(void)poll(&pfd, 1, 100);
+	}
+}
+
+/* Windows go away under us; that is to be expected. */
+static int
+xerror(Display *d, XErrorEvent *e)
+{
+	return (0);
+}
+
+static double
+now(void)
+{
+	struct timespec	 ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static int
+dcmp(const void *a, const void *b)
+{
+	double	 x = *(const double *)a, y = *(const double *)b;
+
+	return ((x > y) - (x < y));
+}
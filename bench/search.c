@@ -0,0 +1,293 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Menu filtering benchmark: what the menu does on each key typed, over
+ * made up menus, with no X server.  Each query is typed a character at
+ * a time and every prefix matched, as menu_filter() would:
+ *
+ *	client	search_match_client() over nclients windows, then
+ *		search_print_client() on what matched, as menu_draw()
+ *	exec	search_match_exec() over ncommands sorted commands
+ *	text	search_match_text(), and so strsubmatch(), over nlines
+ *		host names
+ *
+ *	usage: search [-c nclients] [-e ncommands] [-l nlines] [-n rounds]
+ *	    [-t threads] [query ...]
+ *
+ * Titles are drawn from a handful of kinds, terminals, browser tabs,
+ * editors, chat and mail, with up to CLIENT_MAXNAMEQLEN of history and
+ * a label on one window in ten.  threads is filterthreads in .cwmrc.
+ */
+
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "calmwm.h"
+
+#define MAXQUERIES	16
+#define MAXSEARCH	1024	/* as in menu.c */
+#define MAXPRINT	256
+
+struct conf		 Conf;
+
+static struct client_ctx *clients;
+
+static void		 mkclients(struct menu_q *, int);
+static void		 mkcommands(struct menu_q *, int);
+static void		 mklines(struct menu_q *, int);
+static void		 bench(const char *, struct menu_q *,
+			    void (*)(struct menu_q *, struct menu_q *, char *),
+			    int, char **, int, int);
+static double		 now(void);
+static int		 dcmp(const void *, const void *);
+
+static const char	*classes[] = {
+	"XTerm", "Firefox", "Emacs", "Slack", "Thunderbird", "Chromium"
+};
+static const char	*words[] = {
+	"src", "cwm", "calmwm", "search", "menu", "build", "release",
+	"notes", "inbox", "review", "kernel", "patch", "bench", "docs"
+};
+
+/* One of the windows is the current one, to be ranked down. */
+struct client_ctx *
+client_current(void)
+{
+	return (clients);
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct menu_q	 clientq, execq, textq;
+	char		*cq[] = { "xterm", "cwm", "inbox", "zzz" };
+	char		*eq[] = { "fire", "x", "gi", "zzz" };
+	char		*tq[] = { "host1", "example", "zzz" };
+	int		 ch, nclients = 200, ncommands = 5000, nlines = 20000;
+	int		 rounds = 50;
+
+	while ((ch = getopt(argc, argv, "c:e:l:n:t:")) != -1) {
+		switch (ch) {
+		case 'c':
+			nclients = atoi(optarg);
+			break;
+		case 'e':
+			ncommands = atoi(optarg);
+			break;
+		case 'l':
+			nlines = atoi(optarg);
+			break;
+		case 'n':
+			rounds = atoi(optarg);
+			break;
+		case 't':
+			Conf.filterthreads = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: search [-c nclients] "
+			    "[-e ncommands] [-l nlines] [-n rounds]\n"
+			    "    [-t threads] [query ...]\n");
+			exit(1);
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	if (nclients < 1 || ncommands < 1 || nlines < 1 || rounds < 1 ||
+	    argc > MAXQUERIES)
+		errx(1, "bad arguments");
+
+	srandom(1);
+	mkclients(&clientq, nclients);
+	mkcommands(&execq, ncommands);
+	mklines(&textq, nlines);
+
+	printf("%d clients, %d commands, %d lines, %d threads, %d rounds, "
+	    "median per key typed\n", nclients, ncommands, nlines,
+	    Conf.filterthreads, rounds);
+	bench("client", &clientq, search_match_client, 1,
+	    argc > 0 ? argv : cq, argc > 0 ? argc : nitems(cq), rounds);
+	bench("exec", &execq, search_match_exec, 0,
+	    argc > 0 ? argv : eq, argc > 0 ? argc : nitems(eq), rounds);
+	bench("text", &textq, search_match_text, 0,
+	    argc > 0 ? argv : tq, argc > 0 ? argc : nitems(tq), rounds);
+
+	menuq_clear(&clientq);
+	menuq_clear(&execq);
+	menuq_clear(&textq);
+	return (0);
+}
+
+/*
+ * Type each query into menuq, rounds times over.  Prints the time per
+ * key, and that of the slowest key, usually the first.
+ */
+static void
+bench(const char *name, struct menu_q *menuq,
+    void (*match)(struct menu_q *, struct menu_q *, char *), int print,
+    char **queries, int nqueries, int rounds)
+{
+	struct menu_q	 resultq;
+	struct menu	*mi;
+	char		 prefix[MAXSEARCH + 1], buf[MAXPRINT + 1];
+	double		*tkey, *tworst, t, tk;
+	size_t		 len, i;
+	int		 q, r, found = 0;
+
+	tkey = xcalloc(rounds, sizeof(*tkey));
+	tworst = xcalloc(rounds, sizeof(*tworst));
+	for (q = 0; q < nqueries; q++) {
+		len = MIN(strlen(queries[q]), MAXSEARCH);
+		for (r = 0; r < rounds; r++) {
+			tkey[r] = tworst[r] = 0;
+			for (i = 1; i <= len; i++) {
+				(void)strlcpy(prefix, queries[q], i + 1);
+				t = now();
+				(*match)(menuq, &resultq, prefix);
+				found = 0;
+				TAILQ_FOREACH(mi, &resultq, resultentry) {
+					if (print)
+						search_print_client(mi, 0,
+						    buf, sizeof(buf));
+					found++;
+				}
+				tk = now() - t;
+				tkey[r] += tk / len;
+				tworst[r] = MAX(tworst[r], tk);
+			}
+		}
+		qsort(tkey, rounds, sizeof(*tkey), dcmp);
+		qsort(tworst, rounds, sizeof(*tworst), dcmp);
+		printf("%-8s %-12s %8.3f ms/key %8.3f ms worst %7d found\n",
+		    name, queries[q], tkey[rounds / 2] * 1e3,
+		    tworst[rounds / 2] * 1e3, found);
+	}
+	xfree(tkey);
+	xfree(tworst);
+}
+
+static void
+mkclients(struct menu_q *menuq, int n)
+{
+	struct client_ctx	*cc;
+	struct client_cold	*cold;
+	char			 buf[WIN_MAXTITLELEN];
+	const char		*w;
+	int			 i, j, k;
+
+	clients = xcalloc(n, sizeof(*clients));
+	cold = xcalloc(n, sizeof(*cold));
+	menuq_init(menuq);
+	for (i = 0; i < n; i++) {
+		cc = &clients[i];
+		cc->cold = &cold[i];
+		k = random() % nitems(classes);
+		cc->cold->app_class = (char *)classes[k];
+		cc->cold->nameqlen = 1 + random() % CLIENT_MAXNAMEQLEN;
+		for (j = 0; j < cc->cold->nameqlen; j++) {
+			w = words[random() % nitems(words)];
+			switch (k) {
+			case 0:
+				(void)snprintf(buf, sizeof(buf),
+				    "user@host%d: ~/%s/%s", i % 8, w,
+				    words[(i + j) % nitems(words)]);
+				break;
+			case 1:
+			case 5:
+				(void)snprintf(buf, sizeof(buf),
+				    "%s - page %d of the %s wiki - Mozilla "
+				    "Firefox", w, (int)(random() % 1000),
+				    words[j]);
+				break;
+			case 2:
+				(void)snprintf(buf, sizeof(buf),
+				    "%s.c (~/src/%s) - GNU Emacs", w,
+				    words[i % nitems(words)]);
+				break;
+			case 3:
+				(void)snprintf(buf, sizeof(buf),
+				    "Slack | #%s-%d | Team", w, j);
+				break;
+			default:
+				(void)snprintf(buf, sizeof(buf),
+				    "Inbox (%d) - %s@example.org", i + j, w);
+				break;
+			}
+			cc->cold->nameq[j] = xstrdup(buf);
+		}
+		cc->name = CLIENT_NAME(cc, 0);
+		if (i % 10 == 0)
+			cc->cold->label = xstrdup(words[i % nitems(words)]);
+		if (i % 7 == 0)
+			cc->flags |= CLIENT_HIDDEN;
+		(void)menuq_add(menuq, cc, "%s", cc->name);
+	}
+}
+
+/* Made up program names, the way a $PATH full of them looks. */
+static void
+mkcommands(struct menu_q *menuq, int n)
+{
+	const char	*pre[] = { "", "x", "git-", "g", "k", "py" };
+	const char	*mid[] = { "fire", "term", "edit", "mail", "view",
+			    "conf", "grep", "diff", "find", "stat" };
+	char		 buf[MAXPRINT + 1];
+	int		 i;
+
+	menuq_init(menuq);
+	for (i = 0; i < n; i++) {
+		(void)snprintf(buf, sizeof(buf), "%s%s%s%d",
+		    pre[random() % nitems(pre)], mid[random() % nitems(mid)],
+		    words[random() % nitems(words)], i);
+		(void)menuq_add(menuq, NULL, "%s", buf);
+	}
+	search_sort(menuq);
+}
+
+static void
+mklines(struct menu_q *menuq, int n)
+{
+	int	 i;
+
+	menuq_init(menuq);
+	for (i = 0; i < n; i++)
+		(void)menuq_add(menuq, NULL, "host%d.%s.example.org", i,
+		    words[random() % nitems(words)]);
+}
+
+static double
+now(void)
+{
+	struct timespec	 ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static int
+dcmp(const void *a, const void *b)
+{
+	double	 x = *(const double *)a, y = *(const double *)b;
+
+	return ((x > y) - (x < y));
+}
@@ -0,0 +1,687 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Window manager benchmark: synthetic clients driving a running cwm,
+ * normally the one bench/xbench.sh starts under Xvfb, through scenarios,
+ * each timed from what the client does to when the effect is seen.
+ *
+ *	usage: xbench [-n nwindows] [-r rounds] [-q query] [scenario ...]
+ *
+ *	map	map each window, until it is mapped
+ *	retitle	a storm of title changes, until the control socket's
+ *		"title" events for them come in
+ *	group	nwindows split over two groups, switched between with
+ *		grouponly on the control socket, until every window of
+ *		the one is unmapped and of the other mapped
+ *	cycle	M-Tab, through XTEST, until _NET_ACTIVE_WINDOW changes
+ *	menu	M-slash until the menu maps, then the query and Escape
+ *		until it unmaps
+ *	randr	resizing the screen until _NET_DESKTOP_GEOMETRY changes
+ *	unmap	withdraw each window, until its WM_STATE says so
+ *
+ * By default, all of them in that order.  The control socket is found
+ * in $CWM_SOCKET.  Each scenario prints a JSON line: operations, total
+ * time, throughput and latency percentiles, in milliseconds.
+ */
+
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <X11/extensions/XTest.h>
+#include <X11/extensions/Xrandr.h>
+
+#include <ctype.h>
+#include <err.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TIMEOUT		5	/* seconds to wait for any one effect */
+#define TITLE		"xbench title %d"
+
+struct scenario {
+	const char	*name;
+	void		(*run)(void);
+};
+
+static void		 sc_map(void);
+static void		 sc_retitle(void);
+static void		 sc_group(void);
+static void		 sc_cycle(void);
+static void		 sc_menu(void);
+static void		 sc_randr(void);
+static void		 sc_unmap(void);
+
+static void		 mapall(void);
+static void		 waitfor(int (*)(XEvent *, void *), void *,
+			    const char *);
+static int		 is_map(XEvent *, void *);
+static int		 is_withdrawn(XEvent *, void *);
+static int		 is_rootprop(XEvent *, void *);
+static int		 is_menumap(XEvent *, void *);
+static int		 is_unmap(XEvent *, void *);
+static int		 is_groupdone(XEvent *, void *);
+static int		 xerror(Display *, XErrorEvent *);
+static void		 key(KeySym, int);
+static int		 ctl_open(void);
+static void		 ctl_cmd(int, const char *, ...)
+			    __attribute__((__format__ (printf, 2, 3)));
+static char		*ctl_line(int, char *, size_t);
+static void		 report(const char *, double *, int, int, double);
+static void		 skip(const char *, const char *);
+static double		 now(void);
+static int		 dcmp(const void *, const void *);
+
+static struct scenario	 scenarios[] = {
+	{ "map", sc_map },
+	{ "retitle", sc_retitle },
+	{ "group", sc_group },
+	{ "cycle", sc_cycle },
+	{ "menu", sc_menu },
+	{ "randr", sc_randr },
+	{ "unmap", sc_unmap },
+};
+
+static Display		*dpy;
+static Window		 root;
+static Window		*wins;
+static int		*seen;
+static int		 nwins = 100, rounds = 200, mapped;
+static const char	*query = "xbench 1";
+static double		*lat;
+static int		 havextest;
+static int		 xerrors;
+static Atom		 a_active, a_geometry, a_wmstate;
+
+int
+main(int argc, char *argv[])
+{
+	struct scenario	*s;
+	XClassHint	 class = { "xbench", "XBench" };
+	char		 buf[64];
+	int		 ch, i, j, n;
+	const char	*p;
+
+	while ((ch = getopt(argc, argv, "n:q:r:")) != -1) {
+		switch (ch) {
+		case 'n':
+			nwins = atoi(optarg);
+			break;
+		case 'q':
+			query = optarg;
+			break;
+		case 'r':
+			rounds = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: xbench [-n nwindows] "
+			    "[-r rounds] [-q query] [scenario ...]\n");
+			exit(1);
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	if (nwins < 2 || rounds < 1)
+		errx(1, "need at least two windows and one round");
+	for (p = query; *p != '\0'; p++)
+		if (!islower((u_char)*p) && !isdigit((u_char)*p) && *p != ' ')
+			errx(1, "query: only lower case, digits and spaces");
+
+	if ((dpy = XOpenDisplay(NULL)) == NULL)
+		errx(1, "cannot open display");
+	root = DefaultRootWindow(dpy);
+	XSetErrorHandler(xerror);
+	havextest = XTestQueryExtension(dpy, &i, &i, &i, &i);
+	a_active = XInternAtom(dpy, "_NET_ACTIVE_WINDOW", False);
+	a_geometry = XInternAtom(dpy, "_NET_DESKTOP_GEOMETRY", False);
+	a_wmstate = XInternAtom(dpy, "WM_STATE", False);
+	XSelectInput(dpy, root, SubstructureNotifyMask |
+	    PropertyChangeMask);
+
+	wins = calloc(nwins, sizeof(*wins));
+	seen = calloc(nwins, sizeof(*seen));
+	n = MAX(nwins, rounds);
+	lat = calloc(n, sizeof(*lat));
+	if (wins == NULL || seen == NULL || lat == NULL)
+		err(1, NULL);
+	for (i = 0; i < nwins; i++) {
+		wins[i] = XCreateSimpleWindow(dpy, root, 0, 0, 200, 100, 0,
+		    0, 0);
+		XSelectInput(dpy, wins[i], StructureNotifyMask |
+		    PropertyChangeMask);
+		(void)snprintf(buf, sizeof(buf), "xbench %d", i);
+		XStoreName(dpy, wins[i], buf);
+		XSetClassHint(dpy, wins[i], &class);
+	}
+	XSync(dpy, False);
+
+	for (i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+		s = &scenarios[i];
+		if (argc > 0) {
+			for (j = 0; j < argc; j++)
+				if (strcmp(argv[j], s->name) == 0)
+					break;
+			if (j == argc)
+				continue;
+		}
+		s->run();
+	}
+
+	XCloseDisplay(dpy);
+	return (0);
+}
+
+static void
+sc_map(void)
+{
+	double	 t0, start;
+	int	 i;
+
+	if (mapped)
+		sc_unmap();
+	start = now();
+	for (i = 0; i < nwins; i++) {
+		t0 = now();
+		XMapWindow(dpy, wins[i]);
+		XFlush(dpy);
+		waitfor(is_map, &wins[i], "map");
+		lat[i] = now() - t0;
+	}
+	report("map", lat, nwins, nwins, now() - start);
+	mapped = 1;
+}
+
+/*
+ * cwm reads a title when told it changed, by which time it may have
+ * changed again; the titles it never saw have no event, so this waits
+ * only for the last title of each window.
+ */
+static void
+sc_retitle(void)
+{
+	struct pollfd	 pfd;
+	char		 buf[BUFSIZ], *p;
+	double		*sent, t0, start;
+	int		 fd, i, n = 0, got = 0, pending = MIN(rounds, nwins);
+
+	mapall();
+	fd = ctl_open();
+	ctl_cmd(fd, "subscribe title");
+	if ((sent = calloc(rounds, sizeof(*sent))) == NULL)
+		err(1, NULL);
+
+	/* Send them all as fast as we can, taking events as they come. */
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	start = now();
+	while (n < rounds || pending > 0) {
+		if (n < rounds) {
+			(void)snprintf(buf, sizeof(buf), TITLE, n);
+			sent[n] = now();
+			XStoreName(dpy, wins[n % nwins], buf);
+			XFlush(dpy);
+			n++;
+		}
+		if (poll(&pfd, 1, n < rounds ? 0 : TIMEOUT * 1000) < 1) {
+			if (n < rounds)
+				continue;
+			errx(1, "retitle: timed out, %d windows to go",
+			    pending);
+		}
+		t0 = now();
+		if (ctl_line(fd, buf, sizeof(buf)) == NULL)
+			errx(1, "retitle: control socket closed");
+		if ((p = strstr(buf, "\"name\":\"xbench title ")) == NULL)
+			continue;
+		i = atoi(p + strlen("\"name\":\"xbench title "));
+		if (i < 0 || i >= n || got == rounds)
+			continue;
+		lat[got++] = t0 - sent[i];
+		if (i + nwins >= rounds)
+			pending--;
+	}
+	report("retitle", lat, got, rounds, now() - start);
+	free(sent);
+	(void)close(fd);
+}
+
+static void
+sc_group(void)
+{
+	double	 t0, start;
+	int	 fd, i, r;
+
+	mapall();
+	fd = ctl_open();
+	for (i = 0; i < nwins; i++)
+		ctl_cmd(fd, "movetogroup%d 0x%lx", i % 2 + 1, wins[i]);
+
+	/* Start from only the first group showing. */
+	ctl_cmd(fd, "grouponly1");
+	XSync(dpy, False);
+	usleep(100000);
+	while (XPending(dpy))
+		XNextEvent(dpy, &(XEvent){ 0 });
+
+	start = now();
+	for (r = 0; r < rounds; r++) {
+		bzero(seen, nwins * sizeof(*seen));
+		t0 = now();
+		ctl_cmd(fd, "grouponly%d", (r + 1) % 2 + 1);
+		waitfor(is_groupdone, &r, "group");
+		lat[r] = now() - t0;
+	}
+	report("group", lat, rounds, rounds, now() - start);
+
+	/* Everything back in view, for what follows. */
+	for (i = 0; i < nwins; i++)
+		ctl_cmd(fd, "movetogroup1 0x%lx", wins[i]);
+	ctl_cmd(fd, "grouponly1");
+	(void)close(fd);
+}
+
+static void
+sc_cycle(void)
+{
+	double	 t0, start;
+	int	 r;
+
+	if (!havextest) {
+		skip("cycle", "no XTEST");
+		return;
+	}
+	mapall();
+	key(XK_Alt_L, True);
+	start = now();
+	for (r = 0; r < rounds; r++) {
+		t0 = now();
+		key(XK_Tab, True);
+		key(XK_Tab, False);
+		XFlush(dpy);
+		waitfor(is_rootprop, &a_active, "cycle");
+		lat[r] = now() - t0;
+	}
+	key(XK_Alt_L, False);
+	XFlush(dpy);
+	report("cycle", lat, rounds, rounds, now() - start);
+}
+
+static void
+sc_menu(void)
+{
+	double	*filter, t0, start, typing = 0;
+	Window	 menu;
+	int	 len = strlen(query), r, i;
+
+	if (!havextest) {
+		skip("menu", "no XTEST");
+		return;
+	}
+	if ((filter = calloc(rounds, sizeof(*filter))) == NULL)
+		err(1, NULL);
+	mapall();
+	start = now();
+	for (r = 0; r < rounds; r++) {
+		t0 = now();
+		key(XK_Alt_L, True);
+		key(XK_slash, True);
+		key(XK_slash, False);
+		key(XK_Alt_L, False);
+		XFlush(dpy);
+		menu = None;
+		waitfor(is_menumap, &menu, "menu");
+		lat[r] = now() - t0;
+
+		/* Per key typed, Escape included. */
+		t0 = now();
+		for (i = 0; i < len; i++) {
+			key(query[i] == ' ' ? XK_space : (KeySym)query[i],
+			    True);
+			key(query[i] == ' ' ? XK_space : (KeySym)query[i],
+			    False);
+		}
+		key(XK_Escape, True);
+		key(XK_Escape, False);
+		XFlush(dpy);
+		waitfor(is_unmap, &menu, "menu");
+		filter[r] = (now() - t0) / (len + 1);
+		typing += now() - t0;
+	}
+	report("menu_open", lat, rounds, rounds, now() - start);
+	report("menu_key", filter, rounds, rounds * (len + 1), typing);
+	free(filter);
+}
+
+static void
+sc_randr(void)
+{
+	Screen	*s = DefaultScreenOfDisplay(dpy);
+	double	 t0, start;
+	int	 w = s->width, h = s->height, mw = s->mwidth, mh = s->mheight;
+	int	 ev, er, maj, min, minw, minh, maxw, maxh, r;
+
+	if (!XRRQueryExtension(dpy, &ev, &er) ||
+	    !XRRQueryVersion(dpy, &maj, &min) || (maj == 1 && min < 2)) {
+		skip("randr", "no RandR 1.2");
+		return;
+	}
+	XRRGetScreenSizeRange(dpy, root, &minw, &minh, &maxw, &maxh);
+	if (minw > w * 3 / 4 || minh > h * 3 / 4) {
+		skip("randr", "screen cannot shrink");
+		return;
+	}
+
+	mapall();
+	start = now();
+	for (r = 0; r < rounds; r++) {
+		t0 = now();
+		xerrors = 0;
+		if (r % 2 == 0)
+			XRRSetScreenSize(dpy, root, w * 3 / 4, h * 3 / 4,
+			    mw * 3 / 4, mh * 3 / 4);
+		else
+			XRRSetScreenSize(dpy, root, w, h, mw, mh);
+		XSync(dpy, False);
+		if (xerrors) {
+			skip("randr", "resize refused");
+			return;
+		}
+		waitfor(is_rootprop, &a_geometry, "randr");
+		lat[r] = now() - t0;
+	}
+	report("randr", lat, rounds, rounds, now() - start);
+	if (rounds % 2 == 1)
+		XRRSetScreenSize(dpy, root, w, h, mw, mh);
+}
+
+static void
+sc_unmap(void)
+{
+	double	 t0, start;
+	int	 i;
+
+	if (!mapped)
+		mapall();
+	start = now();
+	for (i = 0; i < nwins; i++) {
+		t0 = now();
+		XWithdrawWindow(dpy, wins[i], DefaultScreen(dpy));
+		XFlush(dpy);
+		waitfor(is_withdrawn, &wins[i], "unmap");
+		lat[i] = now() - t0;
+	}
+	report("unmap", lat, nwins, nwins, now() - start);
+	mapped = 0;
+}
+
+/* Map every window, untimed, for the scenarios needing them. */
+static void
+mapall(void)
+{
+	int	 i;
+
+	if (mapped)
+		return;
+	for (i = 0; i < nwins; i++) {
+		XMapWindow(dpy, wins[i]);
+		XFlush(dpy);
+		waitfor(is_map, &wins[i], "map");
+	}
+	mapped = 1;
+}
+
+/*
+ * Take events until match says so, or give up after TIMEOUT.
+ */
+static void
+waitfor(int (*match)(XEvent *, void *), void *arg, const char *what)
+{
+	struct pollfd	 pfd;
+	XEvent		 e;
+	double		 end = now() + TIMEOUT;
+
+	pfd.fd = ConnectionNumber(dpy);
+	pfd.events = POLLIN;
+	for (;;) {
+		while (XPending(dpy)) {
+			XNextEvent(dpy, &e);
+			if (match(&e, arg))
+				return;
+		}
+		if (now() > end)
+			errx(1, "%s: timed out", what);
+		(void)poll(&pfd, 1, 100);
+	}
+}
+
+static int
+is_map(XEvent *e, void *arg)
+{
+	Window	 w = *(Window *)arg;
+
+	return (e->type == MapNotify && e->xmap.event == w &&
+	    e->xmap.window == w);
+}
+
+static int
+is_withdrawn(XEvent *e, void *arg)
+{
+	Window		 w = *(Window *)arg;
+	Atom		 type;
+	u_long		 n, extra;
+	u_char		*data;
+	int		 format, withdrawn = 0;
+
+	if (e->type != PropertyNotify || e->xproperty.window != w ||
+	    e->xproperty.atom != a_wmstate)
+		return (0);
+	if (e->xproperty.state == PropertyDelete)
+		return (1);
+	if (XGetWindowProperty(dpy, w, a_wmstate, 0, 1, False, a_wmstate,
+	    &type, &format, &n, &extra, &data) != Success)
+		return (0);
+	if (n == 1 && format == 32)
+		withdrawn = *(long *)data == WithdrawnState;
+	XFree(data);
+	return (withdrawn);
+}
+
+static int
+is_rootprop(XEvent *e, void *arg)
+{
+	return (e->type == PropertyNotify && e->xproperty.window == root &&
+	    e->xproperty.atom == *(Atom *)arg);
+}
+
+/* The menu is the top level window mapped that is not ours. */
+static int
+is_menumap(XEvent *e, void *arg)
+{
+	int	 i;
+
+	if (e->type != MapNotify || e->xmap.event != root)
+		return (0);
+	for (i = 0; i < nwins; i++)
+		if (wins[i] == e->xmap.window)
+			return (0);
+	*(Window *)arg = e->xmap.window;
+	return (1);
+}
+
+static int
+is_unmap(XEvent *e, void *arg)
+{
+	return (e->type == UnmapNotify &&
+	    e->xunmap.window == *(Window *)arg);
+}
+
+/* Round r shows the windows with i % 2 == (r + 1) % 2, hides the rest. */
+static int
+is_groupdone(XEvent *e, void *arg)
+{
+	int	 r = *(int *)arg, i, n;
+
+	if ((e->type != MapNotify || e->xmap.event != e->xmap.window) &&
+	    (e->type != UnmapNotify || e->xunmap.event != e->xunmap.window))
+		return (0);
+	for (i = 0; i < nwins; i++)
+		if (wins[i] == e->xany.window)
+			break;
+	if (i == nwins)
+		return (0);
+	if ((e->type == MapNotify) == (i % 2 == (r + 1) % 2))
+		seen[i] = 1;
+
+	for (i = n = 0; i < nwins; i++)
+		n += seen[i];
+	return (n == nwins);
+}
+
+static int
+xerror(Display *d, XErrorEvent *e)
+{
+	xerrors++;
+	return (0);
+}
+
+static void
+key(KeySym sym, int down)
+{
+	KeyCode	 kc;
+
+	if ((kc = XKeysymToKeycode(dpy, sym)) == 0)
+		errx(1, "no key for %s", XKeysymToString(sym));
+	XTestFakeKeyEvent(dpy, kc, down, CurrentTime);
+}
+
+static int
+ctl_open(void)
+{
+	struct sockaddr_un	 sun;
+	struct timeval		 tv = { TIMEOUT, 0 };
+	const char		*path;
+	int			 fd;
+
+	if ((path = getenv("CWM_SOCKET")) == NULL)
+		errx(1, "CWM_SOCKET not set");
+	bzero(&sun, sizeof(sun));
+	sun.sun_family = AF_UNIX;
+	if (strlcpy(sun.sun_path, path, sizeof(sun.sun_path)) >=
+	    sizeof(sun.sun_path))
+		errx(1, "%s: path too long", path);
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+		err(1, "socket");
+	if (connect(fd, (struct sockaddr *)&sun, sizeof(sun)) == -1)
+		err(1, "%s", path);
+	(void)setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	return (fd);
+}
+
+/*
+ * Send a command and wait for its status line.
+ */
+static void
+ctl_cmd(int fd, const char *fmt, ...)
+{
+	va_list	 ap;
+	char	 buf[BUFSIZ];
+	int	 len;
+
+	va_start(ap, fmt);
+	len = vsnprintf(buf, sizeof(buf) - 1, fmt, ap);
+	va_end(ap);
+	if (len < 0 || len >= sizeof(buf) - 1)
+		errx(1, "command too long");
+	buf[len++] = '\n';
+	if (write(fd, buf, len) != len)
+		err(1, "control socket");
+
+	do {
+		if (ctl_line(fd, buf, sizeof(buf)) == NULL)
+			errx(1, "control socket closed");
+	} while (strncmp(buf, "{\"status\":", 10) != 0);
+	if (strncmp(buf, "{\"status\":\"ok\"}", 15) != 0)
+		errx(1, "%.*s: %s", (int)strcspn(fmt, " "), fmt, buf);
+}
+
+/*
+ * Read a line a byte at a time; no buffering to get in the way of poll.
+ */
+static char *
+ctl_line(int fd, char *buf, size_t len)
+{
+	size_t	 i = 0;
+
+	while (i < len - 1) {
+		if (read(fd, &buf[i], 1) != 1)
+			return (NULL);
+		if (buf[i++] == '\n')
+			break;
+	}
+	buf[i] = '\0';
+	return (buf);
+}
+
+/*
+ * ops operations took total seconds; n of them were timed, in t.
+ */
+static void
+report(const char *name, double *t, int n, int ops, double total)
+{
+	qsort(t, n, sizeof(double), dcmp);
+	printf("{\"scenario\":\"%s\",\"windows\":%d,\"ops\":%d,"
+	    "\"samples\":%d,\"total_ms\":%.3f,\"ops_per_s\":%.1f,"
+	    "\"p50_ms\":%.3f,\"p90_ms\":%.3f,\"p99_ms\":%.3f,"
+	    "\"max_ms\":%.3f}\n", name, nwins, ops, n, total * 1e3,
+	    ops / total, t[n / 2] * 1e3, t[n * 9 / 10] * 1e3,
+	    t[n * 99 / 100] * 1e3, t[n - 1] * 1e3);
+	fflush(stdout);
+}
+
+static void
+skip(const char *name, const char *why)
+{
+	printf("{\"scenario\":\"%s\",\"skipped\":\"%s\"}\n", name, why);
+	fflush(stdout);
+}
+
+static double
+now(void)
+{
+	struct timespec	 ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static int
+dcmp(const void *a, const void *b)
+{
+	double	 x = *(const double *)a, y = *(const double *)b;
+
+	return ((x > y) - (x < y));
+}
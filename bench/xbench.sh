@@ -0,0 +1,42 @@
+#!/bin/sh
+#
+# Run a benchmark, bench/xbench by default, against ./cwm with
+# bench/cwmrc under a fresh Xvfb.  Prints a JSON line naming the commit,
+# then the benchmark's lines.
+#
+#	usage: xbench.sh [command [argument ...]]
+
+set -e
+cd "$(dirname "$0")/.."
+
+tmp=$(mktemp -d)
+xvfb= wm=
+trap 'kill $wm $xvfb 2>/dev/null; rm -rf "$tmp"' EXIT INT TERM
+
+# Xvfb picks a free display and writes it to fd 3 once it is up.
+Xvfb -displayfd 3 -screen 0 1920x1080x24 -nolisten tcp \
+    3>"$tmp/display" >"$tmp/xvfb.log" 2>&1 &
+xvfb=$!
+i=0
+until [ -s "$tmp/display" ]; do
+	i=$((i + 1))
+	[ $i -lt 100 ] || { cat "$tmp/xvfb.log" >&2; exit 1; }
+	sleep 0.1
+done
+DISPLAY=:$(cat "$tmp/display")
+CWM_SOCKET=$tmp/cwm.sock
+export DISPLAY CWM_SOCKET
+
+HOME=$tmp CWM_SNAPSHOT= ./cwm -c bench/cwmrc &
+wm=$!
+i=0
+until [ -S "$CWM_SOCKET" ]; do
+	i=$((i + 1))
+	[ $i -lt 100 ] || { echo "cwm did not start" >&2; exit 1; }
+	sleep 0.1
+done
+
+printf '{"commit":"%s","date":"%s"}\n' \
+    "$(git rev-parse --short HEAD 2>/dev/null)" "$(date -u +%FT%TZ)"
+[ $# -gt 0 ] || set -- bench/xbench
+"$@"
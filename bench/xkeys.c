@@ -0,0 +1,371 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Key press to effect latency: keys typed through XTEST into a running
+ * cwm, normally the one bench/xbench.sh starts under Xvfb, each timed
+ * until the client sees what the binding does.
+ *
+ *	usage: xkeys [-n nwindows] [-r rounds] [keys[,keys ...]:effect ...]
+ *
+ * keys are written as in .cwmrc, with C, M, S and 4 for Control, Meta,
+ * Shift and Mod4.  A round presses the next of the keys given, so that
+ * "CM-1,CM-2" goes back and forth.  The effects are
+ *
+ *	active	_NET_ACTIVE_WINDOW is set
+ *	desktop	_NET_CURRENT_DESKTOP is set
+ *	menu	the menu window maps; it is closed with Escape, untimed
+ *
+ * The default is M-Tab:active CM-1,CM-2:desktop M-slash:menu; the two
+ * group keys are bound to grouponly in bench/cwmrc, so each shows a
+ * group.  nwindows windows are mapped first, for cycling to go through.
+ * Each binding prints a JSON line with the latency distribution, in
+ * milliseconds.
+ */
+
+#include <sys/param.h>
+
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <X11/keysym.h>
+#include <X11/extensions/XTest.h>
+
+#include <err.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TIMEOUT		5	/* seconds to wait for any one effect */
+#define MAXKEYS		8
+
+enum { EFFECT_ACTIVE, EFFECT_DESKTOP, EFFECT_MENU };
+
+struct keys {
+	KeySym		 sym;
+	KeySym		 mods[4];
+	int		 nmods;
+};
+
+struct binding {
+	const char	*spec;
+	struct keys	 keys[MAXKEYS];
+	int		 nkeys;
+	int		 effect;
+};
+
+static void		 parse(struct binding *, char *);
+static void		 run(struct binding *);
+static void		 press(struct keys *);
+static void		 key(KeySym, int);
+static void		 waitfor(int (*)(XEvent *, void *), void *,
+			    const char *);
+static int		 is_map(XEvent *, void *);
+static int		 is_rootprop(XEvent *, void *);
+static int		 is_menumap(XEvent *, void *);
+static int		 is_unmap(XEvent *, void *);
+static double		 now(void);
+static int		 dcmp(const void *, const void *);
+
+static const char	*effects[] = { "active", "desktop", "menu" };
+static const char	*defaults[] = {
+	"M-Tab:active", "CM-1,CM-2:desktop", "M-slash:menu"
+};
+
+static Display		*dpy;
+static Window		 root;
+static Window		*wins;
+static int		 nwins = 8, rounds = 500;
+static double		*lat;
+static Atom		 a_active, a_desktop;
+
+int
+main(int argc, char *argv[])
+{
+	struct binding	*b;
+	char		*spec;
+	int		 ch, i, nb;
+
+	while ((ch = getopt(argc, argv, "n:r:")) != -1) {
+		switch (ch) {
+		case 'n':
+			nwins = atoi(optarg);
+			break;
+		case 'r':
+			rounds = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: xkeys [-n nwindows] "
+			    "[-r rounds] [keys[,keys ...]:effect ...]\n");
+			exit(1);
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	if (nwins < 2 || rounds < 1)
+		errx(1, "need at least two windows and one round");
+
+	if ((dpy = XOpenDisplay(NULL)) == NULL)
+		errx(1, "cannot open display");
+	root = DefaultRootWindow(dpy);
+	if (!XTestQueryExtension(dpy, &i, &i, &i, &i))
+		errx(1, "no XTEST");
+	a_active = XInternAtom(dpy, "_NET_ACTIVE_WINDOW", False);
+	a_desktop = XInternAtom(dpy, "_NET_CURRENT_DESKTOP", False);
+	XSelectInput(dpy, root, SubstructureNotifyMask |
+	    PropertyChangeMask);
+
+	/* Parse them all before taking any time. */
+	nb = argc > 0 ? argc : sizeof(defaults) / sizeof(defaults[0]);
+	if ((b = calloc(nb, sizeof(*b))) == NULL ||
+	    (lat = calloc(rounds, sizeof(*lat))) == NULL ||
+	    (wins = calloc(nwins, sizeof(*wins))) == NULL)
+		err(1, NULL);
+	for (i = 0; i < nb; i++) {
+		if ((spec = strdup(argc > 0 ? argv[i] : defaults[i])) == NULL)
+			err(1, NULL);
+		parse(&b[i], spec);
+	}
+
+	for (i = 0; i < nwins; i++) {
+		wins[i] = XCreateSimpleWindow(dpy, root, 0, 0, 200, 100, 0,
+		    0, 0);
+		XSelectInput(dpy, wins[i], StructureNotifyMask);
+		XStoreName(dpy, wins[i], "xkeys");
+		XMapWindow(dpy, wins[i]);
+		XFlush(dpy);
+		waitfor(is_map, &wins[i], "map");
+	}
+
+	for (i = 0; i < nb; i++)
+		run(&b[i]);
+
+	XCloseDisplay(dpy);
+	return (0);
+}
+
+/*
+ * "CM-1,CM-2:desktop": the keys, then the effect.
+ */
+static void
+parse(struct binding *b, char *spec)
+{
+	struct keys	*k;
+	char		*effect, *s, *p;
+	int		 i;
+
+	if ((b->spec = strdup(spec)) == NULL)
+		err(1, NULL);
+	if ((effect = strrchr(spec, ':')) == NULL)
+		errx(1, "%s: no effect", b->spec);
+	*effect++ = '\0';
+	for (i = 0; i < sizeof(effects) / sizeof(effects[0]); i++)
+		if (strcmp(effect, effects[i]) == 0)
+			break;
+	if (i == sizeof(effects) / sizeof(effects[0]))
+		errx(1, "%s: unknown effect", b->spec);
+	b->effect = i;
+
+	while ((s = strsep(&spec, ",")) != NULL) {
+		if (b->nkeys == MAXKEYS)
+			errx(1, "%s: too many keys", b->spec);
+		k = &b->keys[b->nkeys++];
+		if ((p = strchr(s, '-')) != NULL && p[1] != '\0') {
+			for (; s < p; s++) {
+				if (k->nmods == 4)
+					errx(1, "%s: too many modifiers",
+					    b->spec);
+				switch (*s) {
+				case 'C':
+					k->mods[k->nmods++] = XK_Control_L;
+					break;
+				case 'M':
+					k->mods[k->nmods++] = XK_Alt_L;
+					break;
+				case 'S':
+					k->mods[k->nmods++] = XK_Shift_L;
+					break;
+				case '4':
+					k->mods[k->nmods++] = XK_Super_L;
+					break;
+				default:
+					errx(1, "%s: bad modifier %c",
+					    b->spec, *s);
+				}
+			}
+			s = p + 1;
+		}
+		if ((k->sym = XStringToKeysym(s)) == NoSymbol)
+			errx(1, "%s: unknown key %s", b->spec, s);
+	}
+}
+
+static void
+run(struct binding *b)
+{
+	XEvent	 e;
+	Window	 menu;
+	double	 t0, total = 0;
+	int	 r;
+
+	for (r = 0; r < rounds; r++) {
+		/* Whatever the last round stirred up is not this one's. */
+		XSync(dpy, False);
+		while (XPending(dpy))
+			XNextEvent(dpy, &e);
+
+		t0 = now();
+		press(&b->keys[r % b->nkeys]);
+		switch (b->effect) {
+		case EFFECT_ACTIVE:
+			waitfor(is_rootprop, &a_active, b->spec);
+			break;
+		case EFFECT_DESKTOP:
+			waitfor(is_rootprop, &a_desktop, b->spec);
+			break;
+		case EFFECT_MENU:
+			menu = None;
+			waitfor(is_menumap, &menu, b->spec);
+			break;
+		}
+		lat[r] = now() - t0;
+		total += lat[r];
+
+		if (b->effect == EFFECT_MENU) {
+			key(XK_Escape, True);
+			key(XK_Escape, False);
+			XFlush(dpy);
+			waitfor(is_unmap, &menu, b->spec);
+		}
+	}
+
+	qsort(lat, rounds, sizeof(double), dcmp);
+	printf("{\"binding\":\"%s\",\"rounds\":%d,\"mean_ms\":%.3f,"
+	    "\"min_ms\":%.3f,\"p10_ms\":%.3f,\"p25_ms\":%.3f,"
+	    "\"p50_ms\":%.3f,\"p75_ms\":%.3f,\"p90_ms\":%.3f,"
+	    "\"p99_ms\":%.3f,\"max_ms\":%.3f}\n", b->spec, rounds,
+	    total / rounds * 1e3, lat[0] * 1e3, lat[rounds / 10] * 1e3,
+	    lat[rounds / 4] * 1e3, lat[rounds / 2] * 1e3,
+	    lat[rounds * 3 / 4] * 1e3, lat[rounds * 9 / 10] * 1e3,
+	    lat[rounds * 99 / 100] * 1e3, lat[rounds - 1] * 1e3);
+	fflush(stdout);
+}
+
+/* Modifiers down, the key down and up, modifiers up. */
+static void
+press(struct keys *k)
+{
+	int	 i;
+
+	for (i = 0; i < k->nmods; i++)
+		key(k->mods[i], True);
+	key(k->sym, True);
+	key(k->sym, False);
+	for (i = k->nmods - 1; i >= 0; i--)
+		key(k->mods[i], False);
+	XFlush(dpy);
+}
+
+static void
+key(KeySym sym, int down)
+{
+	KeyCode	 kc;
+
+	if ((kc = XKeysymToKeycode(dpy, sym)) == 0)
+		errx(1, "no key for %s", XKeysymToString(sym));
+	XTestFakeKeyEvent(dpy, kc, down, CurrentTime);
+}
+
+/*
+ * Take events until match says so, or give up after TIMEOUT.
+ */
+static void
+waitfor(int (*match)(XEvent *, void *), void *arg, const char *what)
+{
+	struct pollfd	 pfd;
+	XEvent		 e;
+	double		 end = now() + TIMEOUT;
+
+	pfd.fd = ConnectionNumber(dpy);
+	pfd.events = POLLIN;
+	for (;;) {
+		while (XPending(dpy)) {
+			XNextEvent(dpy, &e);
+			if (match(&e, arg))
+				return;
+		}
+		if (now() > end)
+			errx(1, "%s: timed out", what);
+		(void)poll(&pfd, 1, 100);
+	}
+}
+
+static int
+is_map(XEvent *e, void *arg)
+{
+	Window	 w = *(Window *)arg;
+
+	return (e->type == MapNotify && e->xmap.event == w &&
+	    e->xmap.window == w);
+}
+
+static int
+is_rootprop(XEvent *e, void *arg)
+{
+	return (e->type == PropertyNotify && e->xproperty.window == root &&
+	    e->xproperty.atom == *(Atom *)arg);
+}
+
+/* The menu is the top level window mapped that is not ours. */
+static int
+is_menumap(XEvent *e, void *arg)
+{
+	int	 i;
+
+	if (e->type != MapNotify || e->xmap.event != root)
+		return (0);
+	for (i = 0; i < nwins; i++)
+		if (wins[i] == e->xmap.window)
+			return (0);
+	*(Window *)arg = e->xmap.window;
+	return (1);
+}
+
+static int
+is_unmap(XEvent *e, void *arg)
+{
+	return (e->type == UnmapNotify &&
+	    e->xunmap.window == *(Window *)arg);
+}
+
+static double
+now(void)
+{
+	struct timespec	 ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static int
+dcmp(const void *a, const void *b)
+{
+	double	 x = *(const double *)a, y = *(const double *)b;
+
+	return ((x > y) - (x < y));
+}
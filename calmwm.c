@@ -48,6 +48,8 @@ int				 HasXinerama, HasRandr, Randr_ev;
 struct conf			 Conf;
 
 static void	sigchld_cb(int);
+static void	sigusr1_cb(int);
+static void	sigusr2_cb(int);
 static void	dpy_init(const char *);
 static int	x_errorhandler(Display *, XErrorEvent *);
 static int	x_wmerrorhandler(Display *, XErrorEvent *);
@@ -79,17 +81,29 @@ main(int argc, char **argv)
 
 	if (signal(SIGCHLD, sigchld_cb) == SIG_ERR)
 		err(1, "signal");
+	if (signal(SIGUSR1, sigusr1_cb) == SIG_ERR)
+		err(1, "signal");
+	if (signal(SIGUSR2, sigusr2_cb) == SIG_ERR)
+		err(1, "signal");
 
+	trace_init();
 	dpy_init(display_name);
 
 	bzero(&Conf, sizeof(Conf));
 	conf_setup(&Conf, conf_file);
 	xu_getatoms();
+	rec_init();
 	x_setup();
+	ctl_init();
+	snap_init();
 
 	xev_loop();
 
+	snap_teardown();
+	ctl_teardown();
 	x_teardown();
+	rec_teardown();
+	log_flush();
 
 	return (0);
 }
@@ -252,6 +266,26 @@ sigchld_cb(int which)
 	errno = save_errno;
 }
 
+/* Memory statistics to stderr, from the event loop. */
+static void
+sigusr1_cb(int which)
+{
+	extern volatile sig_atomic_t	xev_dumpstats;
+
+	xev_dumpstats = 1;
+	xev_wakeup();
+}
+
+/* The trace timeline to ~/cwm-trace.json, from the event loop. */
+static void
+sigusr2_cb(int which)
+{
+	extern volatile sig_atomic_t	xev_dumptrace;
+
+	xev_dumptrace = 1;
+	xev_wakeup();
+}
+
 __dead void
 usage(void)
 {
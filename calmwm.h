@@ -41,6 +41,8 @@
 #endif
 
 #define	CONFFILE	".cwmrc"
+#define	PATHCACHEFILE	".cwm_pathcache"
+#define	DESKTOPCACHEFILE ".cwm_desktop"
 #define	WMNAME	 	"CWM"
 
 #define CHILDMASK	(SubstructureRedirectMask|SubstructureNotifyMask)
@@ -102,27 +104,113 @@ struct gap {
 	int		 right;
 };
 
-struct winname {
-	TAILQ_ENTRY(winname)	 entry;
-	char			*name;
+#define CACHELINE		64
+
+/* Log levels, see log.c; those above CWM_LOG_LEVEL are compiled out. */
+#define CWM_LOG_ERR		0
+#define CWM_LOG_WARN		1
+#define CWM_LOG_INFO		2
+#define CWM_LOG_DEBUG		3
+#ifndef CWM_LOG_LEVEL
+#if DEBUG
+#define CWM_LOG_LEVEL		CWM_LOG_DEBUG
+#else
+#define CWM_LOG_LEVEL		CWM_LOG_INFO
+#endif
+#endif
+
+#define log_level(_level, ...) do {					\
+	if ((_level) <= CWM_LOG_LEVEL)					\
+		log_write((_level), __VA_ARGS__);			\
+} while (0)
+#define log_err(...)		log_level(CWM_LOG_ERR, __VA_ARGS__)
+#define log_warn(...)		log_level(CWM_LOG_WARN, __VA_ARGS__)
+#define log_info(...)		log_level(CWM_LOG_INFO, __VA_ARGS__)
+#define log_debug(...)		log_level(CWM_LOG_DEBUG, __VA_ARGS__)
+
+/* Operations whose X requests and round trips are counted, see xop.c. */
+enum {
+	XOP_MAP,
+	XOP_CLIENT_NEW,
+	XOP_CLIENT_DELETE,
+	XOP_CLIENT_CYCLE,
+	XOP_CLIENT_PTRSAVE,
+	XOP_CLIENT_SETNAME,
+	XOP_GROUP_HIDE,
+	XOP_GROUP_SHOW,
+	XOP_MENU_OPEN,
+	XOP_NOPS
 };
-TAILQ_HEAD(winname_q, winname);
 
-struct client_ctx {
-	TAILQ_ENTRY(client_ctx) entry;
-	TAILQ_ENTRY(client_ctx) group_entry;
-	TAILQ_ENTRY(client_ctx) mru_entry;
-	struct screen_ctx	*sc;
-	Window			 win;
-	XSizeHints		*size;
+/* A span of the trace timeline, see trace.c. */
+struct trace_span {
+	const char		*name;
+	u_long			 arg;
+	unsigned long long	 start;
+};
+
+/*
+ * The Xlib calls that wait for a reply count a round trip; each macro
+ * expands to the function of the same name, as a macro does not expand
+ * itself again.
+ */
+extern u_long		 xop_nreplies;
+#define XOP_REPLY(_call)	(xop_nreplies++, (_call))
+#define XAllocNamedColor(...)	XOP_REPLY(XAllocNamedColor(__VA_ARGS__))
+#define XGetAtomName(...)	XOP_REPLY(XGetAtomName(__VA_ARGS__))
+#define XGetClassHint(...)	XOP_REPLY(XGetClassHint(__VA_ARGS__))
+#define XGetInputFocus(...)	XOP_REPLY(XGetInputFocus(__VA_ARGS__))
+#define XGetTextProperty(...)	XOP_REPLY(XGetTextProperty(__VA_ARGS__))
+#define XGetTransientForHint(...)					\
+	XOP_REPLY(XGetTransientForHint(__VA_ARGS__))
+#define XGetWMHints(...)	XOP_REPLY(XGetWMHints(__VA_ARGS__))
+#define XGetWMNormalHints(...)	XOP_REPLY(XGetWMNormalHints(__VA_ARGS__))
+#define XGetWindowAttributes(...)					\
+	XOP_REPLY(XGetWindowAttributes(__VA_ARGS__))
+#define XGetWindowProperty(...)	XOP_REPLY(XGetWindowProperty(__VA_ARGS__))
+#define XGrabKeyboard(...)	XOP_REPLY(XGrabKeyboard(__VA_ARGS__))
+#define XGrabPointer(...)	XOP_REPLY(XGrabPointer(__VA_ARGS__))
+#define XInternAtom(...)	XOP_REPLY(XInternAtom(__VA_ARGS__))
+#define XInternAtoms(...)	XOP_REPLY(XInternAtoms(__VA_ARGS__))
+#define XQueryPointer(...)	XOP_REPLY(XQueryPointer(__VA_ARGS__))
+#define XQueryTree(...)		XOP_REPLY(XQueryTree(__VA_ARGS__))
+#define XSync(...)		XOP_REPLY(XSync(__VA_ARGS__))
+#define XineramaQueryScreens(...)					\
+	XOP_REPLY(XineramaQueryScreens(__VA_ARGS__))
+
+/* See pool.c. */
+struct pool {
+	const char		*name;
+	size_t			 size;
+	size_t			 align;
+	struct pool_item	*freelist;
+	struct pool_slab	*slabs;
+	u_long			 nget;
+	u_long			 nput;
+	u_long			 nout;
+	u_long			 nslab;
+};
+#define POOL_INITIALIZER(_name, _size)	{ (_name), (_size) }
+#define POOL_INITIALIZER_ALIGN(_name, _size, _align)			\
+	{ (_name), (_size), (_align) }
+
+#define WIN_MAXTITLELEN		256
+
+struct client_geom {
+	int			 x;	/* x position */
+	int			 y;	/* y position */
+	int			 width;	/* width */
+	int			 height;/* height */
+};
+
+/*
+ * The parts of a client seldom looked at, kept out of line so that
+ * walking the client lists only touches struct client_ctx.
+ */
+struct client_cold {
+	XSizeHints		 size;
 	Colormap		 cmap;
-	u_int			 bwidth; /* border width */
-	struct {
-		int		 x;	/* x position */
-		int		 y;	/* y position */
-		int		 width;	/* width */
-		int		 height;/* height */
-	} geom, savegeom;
+	struct client_geom	 savegeom;
 	struct {
 		int		 basew;	/* desired width */
 		int		 baseh;	/* desired height */
@@ -142,6 +230,35 @@ struct client_ctx {
 #define CLIENT_PROTO_DELETE		 0x0001
 #define CLIENT_PROTO_TAKEFOCUS		 0x0002
 	int			 xproto;
+	int			 state;
+	int			 stackingorder;
+#define CLIENT_HIGHLIGHT_GROUP		0x0001
+#define CLIENT_HIGHLIGHT_UNGROUP	0x0002
+	int			 highlight;
+	/* Title history, a ring from nameq[namehead] on; interned. */
+#define CLIENT_MAXNAMEQLEN		5
+	char			*nameq[CLIENT_MAXNAMEQLEN];
+	int			 namehead;
+	int			 nameqlen;
+	char			*label;
+	char			*matchname;
+	char			*app_class;	/* interned */
+	char			*app_name;	/* interned */
+};
+
+/*
+ * What event dispatch, focus, cycling and placement look at, in two
+ * cache lines; see bench/clients.c.
+ */
+struct client_ctx {
+	TAILQ_ENTRY(client_ctx) entry;
+	TAILQ_ENTRY(client_ctx) group_entry;
+	TAILQ_ENTRY(client_ctx) mru_entry;
+	struct screen_ctx	*sc;
+	struct group_ctx	*group;
+	Window			 win;
+	struct client_geom	 geom;
+	u_int			 bwidth; /* border width */
 #define CLIENT_HIDDEN			0x0001
 #define CLIENT_IGNORE			0x0002
 #define CLIENT_VMAXIMIZED		0x0004
@@ -151,28 +268,20 @@ struct client_ctx {
 #define CLIENT_MAXFLAGS			(CLIENT_VMAXIMIZED | CLIENT_HMAXIMIZED)
 #define CLIENT_MAXIMIZED		(CLIENT_VMAXIMIZED | CLIENT_HMAXIMIZED)
 	int			 flags;
-	int			 state;
 	int			 active;
-	int			 stackingorder;
-#define CLIENT_HIGHLIGHT_GROUP		0x0001
-#define CLIENT_HIGHLIGHT_UNGROUP	0x0002
-	int			 highlight;
-	struct winname_q	 nameq;
-#define CLIENT_MAXNAMEQLEN		5
-	int			 nameqlen;
 	char			*name;
-	char			*label;
-	char			*matchname;
-	struct group_ctx	*group;
-	char			*app_class;
-	char			*app_name;
+	struct client_cold	*cold;
 };
 TAILQ_HEAD(client_ctx_q, client_ctx);
 TAILQ_HEAD(cycle_entry_q, client_ctx);
 
+/* The title i changes back, 0 being the current one. */
+#define CLIENT_NAME(_cc, _i)						\
+	((_cc)->cold->nameq[((_cc)->cold->namehead +			\
+	    (_cc)->cold->nameqlen - 1 - (_i)) % CLIENT_MAXNAMEQLEN])
+
 struct winmatch {
 	TAILQ_ENTRY(winmatch)	entry;
-#define WIN_MAXTITLELEN		256
 	char			title[WIN_MAXTITLELEN];
 };
 TAILQ_HEAD(winmatch_q, winmatch);
@@ -189,8 +298,8 @@ TAILQ_HEAD(group_ctx_q, group_ctx);
 
 struct autogroupwin {
 	TAILQ_ENTRY(autogroupwin)	 entry;
-	char				*class;
-	char				*name;
+	char				*class;	/* interned */
+	char				*name;	/* interned */
 	int 				 num;
 };
 TAILQ_HEAD(autogroupwin_q, autogroupwin);
@@ -231,6 +340,7 @@ struct keybinding {
 	int			 keysym;
 	int			 keycode;
 #define KBFLAG_NEEDCLIENT	 0x0001
+#define KBFLAG_INTERACTIVE	 0x0002	/* waits for the user */
 	int			 flags;
 };
 TAILQ_HEAD(keybinding_q, keybinding);
@@ -258,14 +368,41 @@ TAILQ_HEAD(cmd_q, cmd);
 struct menu {
 	TAILQ_ENTRY(menu)	 entry;
 	TAILQ_ENTRY(menu)	 resultentry;
-#define MENU_MAXENTRY		 50
-	char			 text[MENU_MAXENTRY + 1];
-	char			 print[MENU_MAXENTRY + 1];
+	char			*text;
+	char			*print;
 	void			*ctx;
 	short			 dummy;
 	short			 abort;
+	short			 descend;	/* chosen, fills the search */
+};
+
+/*
+ * A TAILQ_HEAD(menu_q, menu) that also holds the storage of its
+ * entries, see menuq.c.
+ */
+struct menu_q {
+	struct menu		*tqh_first;
+	struct menu		**tqh_last;
+	struct menu_chunk	*chunks;
+};
+
+/* An application from a .desktop file, see desktop.c. */
+struct desktop_app {
+	const char		*name;
+	const char		*exec;
+	const char		*keywords;
+};
+
+/*
+ * Entries arriving while a menu is open: fd becomes readable when
+ * fill() has more to add to the menu.  fill() returns 0 once there
+ * is nothing left to come.
+ */
+struct menu_feed {
+	int			 fd;
+	int			(*fill)(struct menu_q *, void *);
+	void			*arg;
 };
-TAILQ_HEAD(menu_q, menu);
 
 struct conf {
 	struct keybinding_q	 keybindingq;
@@ -275,6 +412,7 @@ struct conf {
 	struct cmd_q		 cmdq;
 	struct mousebinding_q	 mousebindingq;
 #define	CONF_STICKY_GROUPS		0x0001
+#define	CONF_PATHCACHE			0x0002
 	int			 flags;
 #define CONF_BWIDTH			1
 	int			 bwidth;
@@ -282,6 +420,10 @@ struct conf {
 	int			 mamount;
 #define	CONF_SNAPDIST			0
 	int			 snapdist;
+#define	CONF_FILTERTHREADS		0
+	int			 filterthreads;
+#define	CONF_WATCHDOG			250
+	int			 watchdog;	/* ms */
 	struct gap		 gap;
 	struct color		 color[CWM_COLOR_MAX];
 	char			 termpath[MAXPATHLEN];
@@ -358,13 +500,19 @@ void			 group_sticky_toggle_enter(struct client_ctx *);
 void			 group_sticky_toggle_exit(struct client_ctx *);
 void			 group_update_names(struct screen_ctx *);
 
+void			 search_match_app(struct menu_q *, struct menu_q *,
+			     char *);
 void			 search_match_client(struct menu_q *, struct menu_q *,
 			     char *);
+void			 search_match_path(struct menu_q *, struct menu_q *,
+			     char *);
 void			 search_match_exec(struct menu_q *, struct menu_q *,
 			     char *);
 void			 search_match_text(struct menu_q *, struct menu_q *,
 			     char *);
-void			 search_print_client(struct menu *, int);
+void			 search_print_client(struct menu *, int, char *, size_t);
+void			 search_merge(struct menu_q *, struct menu_q *);
+void			 search_sort(struct menu_q *);
 
 XineramaScreenInfo	*screen_find_xinerama(struct screen_ctx *, int, int);
 struct screen_ctx	*screen_fromroot(Window);
@@ -372,6 +520,7 @@ void			 screen_init_xinerama(struct screen_ctx *);
 void			 screen_update_geometry(struct screen_ctx *, int, int);
 void			 screen_updatestackingorder(struct screen_ctx *);
 
+void			 kbfunc_app_search(struct client_ctx *, union arg *);
 void			 kbfunc_client_cycle(struct client_ctx *, union arg *);
 void			 kbfunc_client_cyclegroup(struct client_ctx *,
 			     union arg *);
@@ -426,11 +575,65 @@ void			 mousefunc_window_resize(struct client_ctx *, void *);
 struct menu  		*menu_filter(struct screen_ctx *, struct menu_q *,
 			     char *, char *, int,
 			     void (*)(struct menu_q *, struct menu_q *, char *),
-			     void (*)(struct menu *, int));
+			     void (*)(struct menu *, int, char *, size_t));
+struct menu  		*menu_filter_feed(struct screen_ctx *,
+			     struct menu_q *, char *, char *, int,
+			     void (*)(struct menu_q *, struct menu_q *, char *),
+			     void (*)(struct menu *, int, char *, size_t),
+			     struct menu_feed *, int);
 void			 menu_init(struct screen_ctx *);
+void			 menu_stats(FILE *);
 
 int			 parse_config(const char *, struct conf *);
 
+void			 intern_dump(int);
+char			*intern_get(const char *);
+void			 intern_put(char *);
+
+void			 pool_dump(int);
+void			*pool_get(struct pool *);
+void			 pool_put(struct pool *, void *);
+
+void			 menuq_init(struct menu_q *);
+void			 menuq_clear(struct menu_q *);
+struct menu		*menuq_entry(struct menu_q *, void *, const char *);
+struct menu		*menuq_add(struct menu_q *, void *, const char *, ...)
+			    __attribute__((__format__ (printf, 3, 4)));
+char			*menuq_strdup(struct menu_q *, const char *);
+
+void			 complete_feed(struct menu_feed *);
+int			 complete_expand(const char *, char *, size_t);
+void			 complete_match(struct menu_q *, char *);
+
+int			 desktop_fill(struct menu_q *);
+
+int			 hosts_fill(struct menu_q *);
+
+void			 pathcache_start(struct menu_feed *,
+			     struct menu_q *);
+void			 pathcache_stop(struct menu_feed *);
+
+struct pollfd;
+#define CTL_MAXCONNS		 16
+#define CTL_MAXFDS		 (1 + CTL_MAXCONNS)
+/* Events sent to control socket subscribers. */
+enum {
+	CTL_EV_ADD,
+	CTL_EV_REMOVE,
+	CTL_EV_FOCUS,
+	CTL_EV_TITLE,
+	CTL_EV_LABEL,
+	CTL_EV_CLIENTGROUP,
+	CTL_EV_GROUP,
+	CTL_EV_NEVENTS
+};
+void			 ctl_dispatch(struct pollfd *, int);
+void			 ctl_event_client(int, struct client_ctx *);
+void			 ctl_event_group(struct screen_ctx *, struct group_ctx *);
+void			 ctl_init(void);
+int			 ctl_pollfds(struct pollfd *);
+void			 ctl_teardown(void);
+
 void			 conf_bindname(struct conf *, char *, char *);
 void			 conf_clear(struct conf *);
 void			 conf_client(struct client_ctx *);
@@ -441,6 +644,7 @@ void			 conf_gap(struct conf *, struct screen_ctx *);
 void			 conf_grab(struct conf *, struct keybinding *);
 void			 conf_grab_mouse(struct client_ctx *);
 void			 conf_init(struct conf *);
+int			 conf_kbfunc(const char *, struct keybinding *);
 void			 conf_mousebind(struct conf *, char *, char *);
 void			 conf_reload(struct conf *);
 void			 conf_setup(struct conf *, const char *);
@@ -455,7 +659,40 @@ void			 font_init(struct screen_ctx *, const char *, XftColor *);
 int			 font_width(struct screen_ctx *, const char *, int);
 XftFont			*font_make(struct screen_ctx *, const char *);
 
+void			 log_flush(void);
+int			 log_pending(void);
+void			 log_write(int, const char *, ...)
+			    __attribute__((__format__ (printf, 2, 3)));
+
+void			 rec_class(Window, const char *, const char *);
+void			 rec_event(XEvent *);
+void			 rec_flush(void);
+void			 rec_geom(Window, XWindowAttributes *);
+void			 rec_init(void);
+void			 rec_name(Window, const char *);
+void			 rec_teardown(void);
+
+void			 snap_init(void);
+void			 snap_teardown(void);
+void			 snap_update(void);
+
+void			 trace_begin(struct trace_span *, const char *, u_long);
+void			 trace_dump(int);
+void			 trace_end(struct trace_span *);
+void			 trace_init(void);
+void			 trace_write(void);
+
+void			 watchdog_begin(const char *, int, u_long);
+void			 watchdog_end(void);
+
 void			 xev_loop(void);
+void			 xev_stats(FILE *);
+void			 xev_wakeup(void);
+
+void			 xop_begin(int);
+void			 xop_dump(int);
+void			 xop_end(int);
+void			 xop_stats(FILE *);
 
 void			 xu_btn_grab(Window, int, u_int);
 void			 xu_btn_ungrab(Window, int, u_int);
@@ -465,7 +702,8 @@ void			 xu_getatoms(void);
 unsigned long		 xu_getcolor(struct screen_ctx *, char *);
 int			 xu_getprop(Window, Atom, Atom, long, u_char **);
 int			 xu_getstate(struct client_ctx *, int *);
-int			 xu_getstrprop(Window, Atom, char **);
+int			 xu_getstrprop(Window, Atom, char **, char *,
+			     size_t);
 void			 xu_key_grab(Window, int, int);
 void			 xu_key_ungrab(Window, int, int);
 void			 xu_ptr_getpos(Window, int *, int *);
@@ -477,14 +715,31 @@ void			 xu_sendmsg(Window, Atom, long);
 void			 xu_setstate(struct client_ctx *, int);
 void			 xu_setwmname(struct screen_ctx *);
 
+void			 u_dumpstats(int);
 void			 u_exec(char *);
 void			 u_spawn(char *);
 
 void			*xcalloc(size_t, size_t);
 void			 xfree(void *);
 void			*xmalloc(size_t);
+void			 xmalloc_dump(int);
+void			 xmalloc_stats(FILE *);
+void			*xrealloc(void *, size_t);
 char			*xstrdup(const char *);
 
+#ifdef XMALLOC_STATS
+/* Allocations are accounted to the file making them, see xmalloc.c. */
+void			*xcalloc_tag(size_t, size_t, const char *);
+void			*xmalloc_tag(size_t, const char *);
+void			*xrealloc_tag(void *, size_t, const char *);
+char			*xstrdup_tag(const char *, const char *);
+
+#define xcalloc(_n, _s)		xcalloc_tag((_n), (_s), __FILE__)
+#define xmalloc(_s)		xmalloc_tag((_s), __FILE__)
+#define xrealloc(_p, _s)	xrealloc_tag((_p), (_s), __FILE__)
+#define xstrdup(_s)		xstrdup_tag((_s), __FILE__)
+#endif
+
 /* Externs */
 extern Display				*X_Dpy;
 
@@ -21,7 +21,6 @@
 #include <sys/param.h>
 #include <sys/queue.h>
 
-#include <assert.h>
 #include <err.h>
 #include <errno.h>
 #include <stdlib.h>
@@ -40,7 +39,11 @@ static void			 client_gethints(struct client_ctx *);
 static void			 client_freehints(struct client_ctx *);
 static int			 client_inbound(struct client_ctx *, int, int);
 
-static char		 emptystring[] = "";
+/* Two cache lines each, so that lists of them walk cleanly. */
+static struct pool	 client_pool = POOL_INITIALIZER_ALIGN("client",
+			    sizeof(struct client_ctx), CACHELINE);
+static struct pool	 client_cold_pool = POOL_INITIALIZER("client_cold",
+			    sizeof(struct client_cold));
 struct client_ctx	*_curcc = NULL;
 
 struct client_ctx *
@@ -63,37 +66,40 @@ client_new(Window win, struct screen_ctx *sc, int mapped)
 	XWMHints		*wmhints;
 	int			 state;
 	XineramaScreenInfo	*xine;
+	struct trace_span	 ts;
 	int			 xmax, ymax;
 
 	if (win == None)
 		return (NULL);
 
-	cc = xcalloc(1, sizeof(*cc));
+	trace_begin(&ts, "client_new", win);
+	xop_begin(XOP_CLIENT_NEW);
+	cc = pool_get(&client_pool);
+	cc->cold = pool_get(&client_cold_pool);
 
 	XGrabServer(X_Dpy);
 
-	cc->state = mapped ? NormalState : IconicState;
+	cc->cold->state = mapped ? NormalState : IconicState;
 	cc->sc = sc;
 	cc->win = win;
-	cc->size = XAllocSizeHints();
 
 	client_getsizehints(cc);
 
-	TAILQ_INIT(&cc->nameq);
 	client_setname(cc);
 
 	conf_client(cc);
 
 	/* Saved pointer position */
-	cc->ptr.x = -1;
-	cc->ptr.y = -1;
+	cc->cold->ptr.x = -1;
+	cc->cold->ptr.y = -1;
 
 	XGetWindowAttributes(X_Dpy, cc->win, &wattr);
 	cc->geom.x = wattr.x;
 	cc->geom.y = wattr.y;
 	cc->geom.width = wattr.width;
 	cc->geom.height = wattr.height;
-	cc->cmap = wattr.colormap;
+	cc->cold->cmap = wattr.colormap;
+	rec_geom(cc->win, &wattr);
 
 	xine = screen_find_xinerama(sc, cc->geom.x, cc->geom.y);
 	if (xine != NULL) {
@@ -134,13 +140,14 @@ client_new(Window win, struct screen_ctx *sc, int mapped)
 	xu_configure(cc);
 
 	(state == IconicState) ? client_hide(cc) : client_unhide(cc);
-	xu_setstate(cc, cc->state);
+	xu_setstate(cc, cc->cold->state);
 
 	XSync(X_Dpy, False);
 	XUngrabServer(X_Dpy);
 
 	TAILQ_INSERT_TAIL(&sc->mruq, cc, mru_entry);
 	TAILQ_INSERT_TAIL(&Clientq, cc, entry);
+	ctl_event_client(CTL_EV_ADD, cc);
 	/* append to the client list */
 	XChangeProperty(X_Dpy, sc->rootwin, _NET_CLIENT_LIST, XA_WINDOW, 32,
 	    PropModeAppend,  (unsigned char *)&cc->win, 1);
@@ -150,6 +157,8 @@ client_new(Window win, struct screen_ctx *sc, int mapped)
 
 	if (mapped)
 		group_autogroup(cc);
+	xop_end(XOP_CLIENT_NEW);
+	trace_end(&ts);
 
 	return (cc);
 }
@@ -159,10 +168,13 @@ client_delete(struct client_ctx *cc)
 {
 	struct screen_ctx	*sc = cc->sc;
 	struct client_ctx	*tcc;
-	struct winname		*wn;
 	Window			*winlist;
+	struct trace_span	 ts;
 	int			 i, j;
 
+	trace_begin(&ts, "client_delete", cc->win);
+	xop_begin(XOP_CLIENT_DELETE);
+	ctl_event_client(CTL_EV_REMOVE, cc);
 	group_client_delete(cc);
 
 	XGrabServer(X_Dpy);
@@ -195,17 +207,16 @@ client_delete(struct client_ctx *cc)
 	if (_curcc == cc)
 		client_none(sc);
 
-	XFree(cc->size);
-
-	while ((wn = TAILQ_FIRST(&cc->nameq)) != NULL) {
-		TAILQ_REMOVE(&cc->nameq, wn, entry);
-		if (wn->name != emptystring)
-			xfree(wn->name);
-		xfree(wn);
-	}
+	for (i = 0; i < cc->cold->nameqlen; i++)
+		intern_put(cc->cold->nameq[i]);
+	if (cc->cold->label != NULL)
+		xfree(cc->cold->label);
 
 	client_freehints(cc);
-	xfree(cc);
+	pool_put(&client_cold_pool, cc->cold);
+	pool_put(&client_pool, cc);
+	xop_end(XOP_CLIENT_DELETE);
+	trace_end(&ts);
 }
 
 void
@@ -235,7 +246,7 @@ client_setactive(struct client_ctx *cc, int fg)
 	sc = cc->sc;
 
 	if (fg) {
-		XInstallColormap(X_Dpy, cc->cmap);
+		XInstallColormap(X_Dpy, cc->cold->cmap);
 		XSetInputFocus(X_Dpy, cc->win,
 		    RevertToPointerRoot, CurrentTime);
 		conf_grab_mouse(cc);
@@ -254,6 +265,7 @@ client_setactive(struct client_ctx *cc, int fg)
 		XChangeProperty(X_Dpy, sc->rootwin, _NET_ACTIVE_WINDOW,
 		    XA_WINDOW, 32, PropModeReplace,
 		    (unsigned char *)&cc->win, 1);
+		ctl_event_client(CTL_EV_FOCUS, cc);
 	}
 
 	cc->active = fg;
@@ -300,19 +312,19 @@ client_maximize(struct client_ctx *cc)
 
 	if ((cc->flags & CLIENT_MAXFLAGS) == CLIENT_MAXIMIZED) {
 		cc->flags &= ~CLIENT_MAXIMIZED;
-		cc->geom = cc->savegeom;
+		cc->geom = cc->cold->savegeom;
 		cc->bwidth = Conf.bwidth;
 		goto resize;
 	}
 
 	if ((cc->flags & CLIENT_VMAXIMIZED) == 0) {
-		cc->savegeom.height = cc->geom.height;
-		cc->savegeom.y = cc->geom.y;
+		cc->cold->savegeom.height = cc->geom.height;
+		cc->cold->savegeom.y = cc->geom.y;
 	}
 
 	if ((cc->flags & CLIENT_HMAXIMIZED) == 0) {
-		cc->savegeom.width = cc->geom.width;
-		cc->savegeom.x = cc->geom.x;
+		cc->cold->savegeom.width = cc->geom.width;
+		cc->cold->savegeom.x = cc->geom.x;
 	}
 
 	if (HasXinerama) {
@@ -354,8 +366,8 @@ client_vertmaximize(struct client_ctx *cc)
 		return;
 
 	if (cc->flags & CLIENT_VMAXIMIZED) {
-		cc->geom.y = cc->savegeom.y;
-		cc->geom.height = cc->savegeom.height;
+		cc->geom.y = cc->cold->savegeom.y;
+		cc->geom.height = cc->cold->savegeom.height;
 		cc->bwidth = Conf.bwidth;
 		if (cc->flags & CLIENT_HMAXIMIZED)
 			cc->geom.width -= cc->bwidth * 2;
@@ -363,8 +375,8 @@ client_vertmaximize(struct client_ctx *cc)
 		goto resize;
 	}
 
-	cc->savegeom.y = cc->geom.y;
-	cc->savegeom.height = cc->geom.height;
+	cc->cold->savegeom.y = cc->geom.y;
+	cc->cold->savegeom.height = cc->geom.height;
 
 	/* if this will make us fully maximized then remove boundary */
 	if ((cc->flags & CLIENT_MAXFLAGS) == CLIENT_HMAXIMIZED) {
@@ -402,8 +414,8 @@ client_horizmaximize(struct client_ctx *cc)
 		return;
 
 	if (cc->flags & CLIENT_HMAXIMIZED) {
-		cc->geom.x = cc->savegeom.x;
-		cc->geom.width = cc->savegeom.width;
+		cc->geom.x = cc->cold->savegeom.x;
+		cc->geom.width = cc->cold->savegeom.width;
 		cc->bwidth = Conf.bwidth;
 		if (cc->flags & CLIENT_VMAXIMIZED)
 			cc->geom.height -= cc->bwidth * 2;
@@ -411,8 +423,8 @@ client_horizmaximize(struct client_ctx *cc)
 		goto resize;
 	} 
 
-	cc->savegeom.x = cc->geom.x;
-	cc->savegeom.width = cc->geom.width;
+	cc->cold->savegeom.x = cc->geom.x;
+	cc->cold->savegeom.width = cc->geom.width;
 
 	/* if this will make us fully maximized then remove boundary */
 	if ((cc->flags & CLIENT_MAXFLAGS) == CLIENT_VMAXIMIZED) {
@@ -451,10 +463,10 @@ client_leftmaximize(struct client_ctx *cc)
 		return;
 
 	if (cc->flags & CLIENT_VMAXIMIZED) {
-		cc->geom.x = cc->savegeom.x;
-		cc->geom.y = cc->savegeom.y;
-		cc->geom.width = cc->savegeom.width;
-		cc->geom.height = cc->savegeom.height;
+		cc->geom.x = cc->cold->savegeom.x;
+		cc->geom.y = cc->cold->savegeom.y;
+		cc->geom.width = cc->cold->savegeom.width;
+		cc->geom.height = cc->cold->savegeom.height;
 		cc->bwidth = Conf.bwidth;
 		// XXX
 		if (cc->flags & CLIENT_HMAXIMIZED)
@@ -463,10 +475,10 @@ client_leftmaximize(struct client_ctx *cc)
 		goto resize;
 	}
 
-	cc->savegeom.x = cc->geom.x;
-	cc->savegeom.y = cc->geom.y;
-	cc->savegeom.width = cc->geom.width;
-	cc->savegeom.height = cc->geom.height;
+	cc->cold->savegeom.x = cc->geom.x;
+	cc->cold->savegeom.y = cc->geom.y;
+	cc->cold->savegeom.width = cc->geom.width;
+	cc->cold->savegeom.height = cc->geom.height;
 	client_ptrsave(cc);
 
 	/* if this will make us fully maximized then remove boundary */
@@ -513,10 +525,10 @@ client_rightmaximize(struct client_ctx *cc)
 		return;
 
 	if (cc->flags & CLIENT_VMAXIMIZED) {
-		cc->geom.x = cc->savegeom.x;
-		cc->geom.y = cc->savegeom.y;
-		cc->geom.width = cc->savegeom.width;
-		cc->geom.height = cc->savegeom.height;
+		cc->geom.x = cc->cold->savegeom.x;
+		cc->geom.y = cc->cold->savegeom.y;
+		cc->geom.width = cc->cold->savegeom.width;
+		cc->geom.height = cc->cold->savegeom.height;
 		cc->bwidth = Conf.bwidth;
 		// XXX
 		if (cc->flags & CLIENT_HMAXIMIZED)
@@ -525,10 +537,10 @@ client_rightmaximize(struct client_ctx *cc)
 		goto resize;
 	}
 
-	cc->savegeom.x = cc->geom.x;
-	cc->savegeom.y = cc->geom.y;
-	cc->savegeom.width = cc->geom.width;
-	cc->savegeom.height = cc->geom.height;
+	cc->cold->savegeom.x = cc->geom.x;
+	cc->cold->savegeom.y = cc->geom.y;
+	cc->cold->savegeom.width = cc->geom.width;
+	cc->cold->savegeom.height = cc->geom.height;
 	client_ptrsave(cc);
 
 	/* if this will make us fully maximized then remove boundary */
@@ -596,14 +608,14 @@ client_raise(struct client_ctx *cc)
 void
 client_ptrwarp(struct client_ctx *cc)
 {
-	int	 x = cc->ptr.x, y = cc->ptr.y;
+	int	 x = cc->cold->ptr.x, y = cc->cold->ptr.y;
 
 	if (x == -1 || y == -1) {
 		x = cc->geom.width / 2;
 		y = cc->geom.height / 2;
 	}
 
-	(cc->state == IconicState) ? client_unhide(cc) : client_raise(cc);
+	(cc->cold->state == IconicState) ? client_unhide(cc) : client_raise(cc);
 	xu_ptr_setpos(cc->win, x, y);
 }
 
@@ -612,14 +624,16 @@ client_ptrsave(struct client_ctx *cc)
 {
 	int	 x, y;
 
+	xop_begin(XOP_CLIENT_PTRSAVE);
 	xu_ptr_getpos(cc->win, &x, &y);
 	if (client_inbound(cc, x, y)) {
-		cc->ptr.x = x;
-		cc->ptr.y = y;
+		cc->cold->ptr.x = x;
+		cc->cold->ptr.y = y;
 	} else {
-		cc->ptr.x = -1;
-		cc->ptr.y = -1;
+		cc->cold->ptr.x = -1;
+		cc->cold->ptr.y = -1;
 	}
+	xop_end(XOP_CLIENT_PTRSAVE);
 }
 
 void
@@ -641,7 +655,7 @@ client_unhide(struct client_ctx *cc)
 {
 	XMapRaised(X_Dpy, cc->win);
 
-	cc->highlight = 0;
+	cc->cold->highlight = 0;
 	cc->flags &= ~CLIENT_HIDDEN;
 	xu_setstate(cc, NormalState);
 	client_draw_border(cc);
@@ -654,7 +668,7 @@ client_draw_border(struct client_ctx *cc)
 	unsigned long		 pixel;
 
 	if (cc->active)
-		switch (cc->highlight) {
+		switch (cc->cold->highlight) {
 		case CLIENT_HIGHLIGHT_GROUP:
 			pixel = sc->color[CWM_COLOR_BORDER_GROUP].pixel;
 			break;
@@ -685,9 +699,9 @@ client_update(struct client_ctx *cc)
 
 	for (i = 0; i < n; i++)
 		if (p[i] == WM_DELETE_WINDOW)
-			cc->xproto |= CLIENT_PROTO_DELETE;
+			cc->cold->xproto |= CLIENT_PROTO_DELETE;
 		else if (p[i] == WM_TAKE_FOCUS)
-			cc->xproto |= CLIENT_PROTO_TAKEFOCUS;
+			cc->cold->xproto |= CLIENT_PROTO_TAKEFOCUS;
 
 	XFree(p);
 }
@@ -695,48 +709,64 @@ client_update(struct client_ctx *cc)
 void
 client_send_delete(struct client_ctx *cc)
 {
-	if (cc->xproto & CLIENT_PROTO_DELETE)
+	if (cc->cold->xproto & CLIENT_PROTO_DELETE)
 		xu_sendmsg(cc->win, WM_PROTOCOLS, WM_DELETE_WINDOW);
 	else
 		XKillClient(X_Dpy, cc->win);
 }
 
+/*
+ * Keep the last few titles, the current one last.
+ */
 void
 client_setname(struct client_ctx *cc)
 {
-	struct winname	*wn;
-	char		*newname;
-
-	if (!xu_getstrprop(cc->win, _NET_WM_NAME, &newname))
-		if (!xu_getstrprop(cc->win, XA_WM_NAME, &newname))
-			newname = emptystring;
-
-	TAILQ_FOREACH(wn, &cc->nameq, entry)
-		if (strcmp(wn->name, newname) == 0) {
-			/* Move to the last since we got a hit. */
-			TAILQ_REMOVE(&cc->nameq, wn, entry);
-			TAILQ_INSERT_TAIL(&cc->nameq, wn, entry);
-			goto match;
+	char		 buf[WIN_MAXTITLELEN], *name, *newname;
+	char		*oldname = cc->name;
+	int		 i, j, k;
+
+	/* Most titles fit in buf; longer ones are kept whole all the same. */
+	xop_begin(XOP_CLIENT_SETNAME);
+	if (!xu_getstrprop(cc->win, _NET_WM_NAME, &name, buf, sizeof(buf)))
+		(void)xu_getstrprop(cc->win, XA_WM_NAME, &name, buf,
+		    sizeof(buf));
+	xop_end(XOP_CLIENT_SETNAME);
+	rec_name(cc->win, name);
+	newname = intern_get(name);
+	if (name != buf)
+		xfree(name);
+
+	for (i = 0; i < cc->cold->nameqlen; i++) {
+		j = (cc->cold->namehead + i) % CLIENT_MAXNAMEQLEN;
+		if (cc->cold->nameq[j] != newname)
+			continue;
+		intern_put(newname);
+		/* Move to the last since we got a hit. */
+		for (; i < cc->cold->nameqlen - 1; i++, j = k) {
+			k = (j + 1) % CLIENT_MAXNAMEQLEN;
+			cc->cold->nameq[j] = cc->cold->nameq[k];
 		}
+		cc->cold->nameq[j] = newname;
+		goto match;
+	}
 
-	wn = xmalloc(sizeof(*wn));
-	wn->name = newname;
-	TAILQ_INSERT_TAIL(&cc->nameq, wn, entry);
-	cc->nameqlen++;
+	if (cc->cold->nameqlen < CLIENT_MAXNAMEQLEN) {
+		cc->cold->nameq[(cc->cold->namehead + cc->cold->nameqlen) %
+		    CLIENT_MAXNAMEQLEN] = newname;
+		cc->cold->nameqlen++;
+	} else {
+		/* The oldest goes, the slot is the newest now. */
+		intern_put(cc->cold->nameq[cc->cold->namehead]);
+		cc->cold->nameq[cc->cold->namehead] = newname;
+		cc->cold->namehead = (cc->cold->namehead + 1) %
+		    CLIENT_MAXNAMEQLEN;
+	}
 
 match:
-	cc->name = wn->name;
-
-	/* Now, do some garbage collection. */
-	if (cc->nameqlen > CLIENT_MAXNAMEQLEN) {
-		wn = TAILQ_FIRST(&cc->nameq);
-		assert(wn != NULL);
-		TAILQ_REMOVE(&cc->nameq, wn, entry);
-		if (wn->name != emptystring)
-			xfree(wn->name);
-		xfree(wn);
-		cc->nameqlen--;
-	}
+	cc->name = newname;
+	/* A new client's first title comes with its add event. */
+	if (oldname != NULL && newname != oldname)
+		ctl_event_client(CTL_EV_TITLE, cc);
 }
 
 void
@@ -808,7 +838,7 @@ client_placecalc(struct client_ctx *cc)
 	struct screen_ctx	*sc = cc->sc;
 	int			 xslack, yslack;
 
-	if (cc->size->flags & (USPosition|PPosition)) {
+	if (cc->cold->size.flags & (USPosition|PPosition)) {
 		/*
 		 * Ignore XINERAMA screens, just make sure it's somewhere
 		 * in the virtual desktop. else it stops people putting xterms
@@ -818,10 +848,10 @@ client_placecalc(struct client_ctx *cc)
 		 */
 		xslack = sc->xmax - cc->geom.width - cc->bwidth * 2;
 		yslack = sc->ymax - cc->geom.height - cc->bwidth * 2;
-		if (cc->size->x > 0)
-			cc->geom.x = MIN(cc->size->x, xslack);
-		if (cc->size->y > 0)
-			cc->geom.y = MIN(cc->size->y, yslack);
+		if (cc->cold->size.x > 0)
+			cc->geom.x = MIN(cc->cold->size.x, xslack);
+		if (cc->cold->size.y > 0)
+			cc->geom.y = MIN(cc->cold->size.y, yslack);
 	} else {
 		XineramaScreenInfo	*info;
 		int			 xmouse, ymouse, xorig, yorig;
@@ -894,41 +924,43 @@ client_getsizehints(struct client_ctx *cc)
 {
 	long		 tmp;
 
-	if (!XGetWMNormalHints(X_Dpy, cc->win, cc->size, &tmp))
-		cc->size->flags = PSize;
+	if (!XGetWMNormalHints(X_Dpy, cc->win, &cc->cold->size, &tmp))
+		cc->cold->size.flags = PSize;
 
-	if (cc->size->flags & PBaseSize) {
-		cc->hint.basew = cc->size->base_width;
-		cc->hint.baseh = cc->size->base_height;
-	} else if (cc->size->flags & PMinSize) {
-		cc->hint.basew = cc->size->min_width;
-		cc->hint.baseh = cc->size->min_height;
+	if (cc->cold->size.flags & PBaseSize) {
+		cc->cold->hint.basew = cc->cold->size.base_width;
+		cc->cold->hint.baseh = cc->cold->size.base_height;
+	} else if (cc->cold->size.flags & PMinSize) {
+		cc->cold->hint.basew = cc->cold->size.min_width;
+		cc->cold->hint.baseh = cc->cold->size.min_height;
 	}
-	if (cc->size->flags & PMinSize) {
-		cc->hint.minw = cc->size->min_width;
-		cc->hint.minh = cc->size->min_height;
-	} else if (cc->size->flags & PBaseSize) {
-		cc->hint.minw = cc->size->base_width;
-		cc->hint.minh = cc->size->base_height;
+	if (cc->cold->size.flags & PMinSize) {
+		cc->cold->hint.minw = cc->cold->size.min_width;
+		cc->cold->hint.minh = cc->cold->size.min_height;
+	} else if (cc->cold->size.flags & PBaseSize) {
+		cc->cold->hint.minw = cc->cold->size.base_width;
+		cc->cold->hint.minh = cc->cold->size.base_height;
 	}
-	if (cc->size->flags & PMaxSize) {
-		cc->hint.maxw = cc->size->max_width;
-		cc->hint.maxh = cc->size->max_height;
+	if (cc->cold->size.flags & PMaxSize) {
+		cc->cold->hint.maxw = cc->cold->size.max_width;
+		cc->cold->hint.maxh = cc->cold->size.max_height;
 	}
-	if (cc->size->flags & PResizeInc) {
-		cc->hint.incw = cc->size->width_inc;
-		cc->hint.inch = cc->size->height_inc;
+	if (cc->cold->size.flags & PResizeInc) {
+		cc->cold->hint.incw = cc->cold->size.width_inc;
+		cc->cold->hint.inch = cc->cold->size.height_inc;
 	}
-	cc->hint.incw = MAX(1, cc->hint.incw);
-	cc->hint.inch = MAX(1, cc->hint.inch);
-
-	if (cc->size->flags & PAspect) {
-		if (cc->size->min_aspect.x > 0)
-			cc->hint.mina = (float)cc->size->min_aspect.y /
-			    cc->size->min_aspect.x;
-		if (cc->size->max_aspect.y > 0)
-			cc->hint.maxa = (float)cc->size->max_aspect.x /
-			    cc->size->max_aspect.y;
+	cc->cold->hint.incw = MAX(1, cc->cold->hint.incw);
+	cc->cold->hint.inch = MAX(1, cc->cold->hint.inch);
+
+	if (cc->cold->size.flags & PAspect) {
+		if (cc->cold->size.min_aspect.x > 0)
+			cc->cold->hint.mina =
+			    (float)cc->cold->size.min_aspect.y /
+			    cc->cold->size.min_aspect.x;
+		if (cc->cold->size.max_aspect.y > 0)
+			cc->cold->hint.maxa =
+			    (float)cc->cold->size.max_aspect.x /
+			    cc->cold->size.max_aspect.y;
 	}
 }
 void
@@ -936,48 +968,48 @@ client_applysizehints(struct client_ctx *cc)
 {
 	Bool		 baseismin;
 
-	baseismin = (cc->hint.basew == cc->hint.minw) &&
-	    (cc->hint.baseh == cc->hint.minh);
+	baseismin = (cc->cold->hint.basew == cc->cold->hint.minw) &&
+	    (cc->cold->hint.baseh == cc->cold->hint.minh);
 
 	/* temporarily remove base dimensions, ICCCM 4.1.2.3 */
 	if (!baseismin) {
-		cc->geom.width -= cc->hint.basew;
-		cc->geom.height -= cc->hint.baseh;
+		cc->geom.width -= cc->cold->hint.basew;
+		cc->geom.height -= cc->cold->hint.baseh;
 	}
 
 	/* adjust for aspect limits */
-	if (cc->hint.mina > 0 && cc->hint.maxa > 0) {
-		if (cc->hint.maxa <
+	if (cc->cold->hint.mina > 0 && cc->cold->hint.maxa > 0) {
+		if (cc->cold->hint.maxa <
 		    (float)cc->geom.width / cc->geom.height)
-			cc->geom.width = cc->geom.height * cc->hint.maxa;
-		else if (cc->hint.mina <
+			cc->geom.width = cc->geom.height * cc->cold->hint.maxa;
+		else if (cc->cold->hint.mina <
 		    (float)cc->geom.height / cc->geom.width)
-			cc->geom.height = cc->geom.width * cc->hint.mina;
+			cc->geom.height = cc->geom.width * cc->cold->hint.mina;
 	}
 
 	/* remove base dimensions for increment */
 	if (baseismin) {
-		cc->geom.width -= cc->hint.basew;
-		cc->geom.height -= cc->hint.baseh;
+		cc->geom.width -= cc->cold->hint.basew;
+		cc->geom.height -= cc->cold->hint.baseh;
 	}
 
 	/* adjust for increment value */
-	cc->geom.width -= cc->geom.width % cc->hint.incw;
-	cc->geom.height -= cc->geom.height % cc->hint.inch;
+	cc->geom.width -= cc->geom.width % cc->cold->hint.incw;
+	cc->geom.height -= cc->geom.height % cc->cold->hint.inch;
 
 	/* restore base dimensions */
-	cc->geom.width += cc->hint.basew;
-	cc->geom.height += cc->hint.baseh;
+	cc->geom.width += cc->cold->hint.basew;
+	cc->geom.height += cc->cold->hint.baseh;
 
 	/* adjust for min width/height */
-	cc->geom.width = MAX(cc->geom.width, cc->hint.minw);
-	cc->geom.height = MAX(cc->geom.height, cc->hint.minh);
+	cc->geom.width = MAX(cc->geom.width, cc->cold->hint.minw);
+	cc->geom.height = MAX(cc->geom.height, cc->cold->hint.minh);
 
 	/* adjust for max width/height */
-	if (cc->hint.maxw)
-		cc->geom.width = MIN(cc->geom.width, cc->hint.maxw);
-	if (cc->hint.maxh)
-		cc->geom.height = MIN(cc->geom.height, cc->hint.maxh);
+	if (cc->cold->hint.maxw)
+		cc->geom.width = MIN(cc->geom.width, cc->cold->hint.maxw);
+	if (cc->cold->hint.maxh)
+		cc->geom.height = MIN(cc->geom.height, cc->cold->hint.maxh);
 }
 
 static void
@@ -987,10 +1019,15 @@ client_gethints(struct client_ctx *cc)
 	struct mwm_hints	*mwmh;
 
 	if (XGetClassHint(X_Dpy, cc->win, &xch)) {
-		if (xch.res_name != NULL)
-			cc->app_name = xch.res_name;
-		if (xch.res_class != NULL)
-			cc->app_class = xch.res_class;
+		rec_class(cc->win, xch.res_name, xch.res_class);
+		if (xch.res_name != NULL) {
+			cc->cold->app_name = intern_get(xch.res_name);
+			XFree(xch.res_name);
+		}
+		if (xch.res_class != NULL) {
+			cc->cold->app_class = intern_get(xch.res_class);
+			XFree(xch.res_class);
+		}
 	}
 
 	if (xu_getprop(cc->win, _MOTIF_WM_HINTS, _MOTIF_WM_HINTS,
@@ -1004,10 +1041,10 @@ client_gethints(struct client_ctx *cc)
 static void
 client_freehints(struct client_ctx *cc)
 {
-	if (cc->app_name != NULL)
-		XFree(cc->app_name);
-	if (cc->app_class != NULL)
-		XFree(cc->app_class);
+	if (cc->cold->app_name != NULL)
+		intern_put(cc->cold->app_name);
+	if (cc->cold->app_class != NULL)
+		intern_put(cc->cold->app_class);
 }
 
 void
@@ -0,0 +1,483 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Copyright (c) 2004 Martin Murray <mmurray@monkey.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Path completion for the exec menu.  Once the search has a '/' in it,
+ * the executables and subdirectories of the directory typed so far are
+ * offered instead of what is in $PATH.  Choosing a subdirectory makes
+ * it the search rather than running it.
+ *
+ * Directories are listed on threads of their own and the listings
+ * handed back through a pipe, which the exec menu watches as a feed.
+ * The last few listings are kept, most recently used first; one that
+ * is used again after a little while is checked against the
+ * directory's mtime in the background, and shown as it is meanwhile.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include <dirent.h>
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "calmwm.h"
+
+#define COMPLETE_NDIRS		16
+#define COMPLETE_MAXPENDING	8
+#define COMPLETE_RECHECK	2	/* seconds */
+
+struct complete_dir {
+	TAILQ_ENTRY(complete_dir) entry;
+	char			*path;
+	char			*names;	/* NUL separated, sorted */
+	size_t			 namelen;
+	int			 nnames;
+	dev_t			 dev;
+	ino_t			 ino;
+	struct timespec		 mtime;
+	time_t			 checked;
+	int			 pending;
+};
+TAILQ_HEAD(complete_dir_q, complete_dir);
+
+/* A listing being fetched; the worker fills in the rest. */
+struct complete_req {
+	TAILQ_ENTRY(complete_req) entry;
+	char			*path;
+	dev_t			 dev;
+	ino_t			 ino;
+	struct timespec		 mtime;
+	char			*names;
+	size_t			 namelen;
+	int			 nnames;
+	int			 unchanged;
+	int			 failed;
+};
+TAILQ_HEAD(complete_req_q, complete_req);
+
+static struct complete_dir	*complete_find(const char *);
+static int			 complete_fill(struct menu_q *, void *);
+static void			 complete_list(struct complete_req *);
+static int			 complete_namecmp(const void *, const void *);
+static void			 complete_request(struct complete_dir *);
+static void			*complete_worker(void *);
+
+/* Main thread only. */
+static struct complete_dir_q	 complete_dirq =
+				    TAILQ_HEAD_INITIALIZER(complete_dirq);
+static int			 complete_ndirs;
+static int			 complete_npending;
+static struct menu		*complete_mv;
+static int			 complete_nmv;
+static char			*complete_text;
+static size_t			 complete_ntext;
+
+/* Finished requests, and the pipe telling the menu about them. */
+static pthread_mutex_t		 complete_mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct complete_req_q	 complete_doneq =
+				    TAILQ_HEAD_INITIALIZER(complete_doneq);
+static int			 complete_fd[2] = { -1, -1 };
+
+/*
+ * Set up feed to pick up listings as they come in.  Without a pipe
+ * the menu goes on without completion; the next menu tries again.
+ */
+void
+complete_feed(struct menu_feed *feed)
+{
+	int	 i;
+
+	feed->fill = complete_fill;
+	feed->arg = NULL;
+
+	if (complete_fd[0] == -1) {
+		if (pipe(complete_fd) == -1) {
+			warn("complete_feed: pipe");
+			complete_fd[0] = complete_fd[1] = -1;
+			feed->fd = -1;
+			return;
+		}
+		for (i = 0; i < 2; i++) {
+			(void)fcntl(complete_fd[i], F_SETFD, FD_CLOEXEC);
+			(void)fcntl(complete_fd[i], F_SETFL, O_NONBLOCK);
+		}
+	}
+
+	feed->fd = complete_fd[0];
+}
+
+/*
+ * Expand a leading ~ to $HOME.
+ */
+int
+complete_expand(const char *in, char *out, size_t len)
+{
+	char	*home;
+	int	 l;
+
+	if (in[0] == '~' && (in[1] == '/' || in[1] == '\0') &&
+	    (home = getenv("HOME")) != NULL)
+		l = snprintf(out, len, "%s%s", home, in + 1);
+	else
+		l = snprintf(out, len, "%s", in);
+
+	return ((l == -1 || l >= len) ? -1 : 0);
+}
+
+/*
+ * Put the entries of the directory part of search that start with the
+ * rest of it in resultq.  If the directory has not been listed yet,
+ * ask for it and come back with nothing; the feed brings us back here.
+ */
+void
+complete_match(struct menu_q *resultq, char *search)
+{
+	struct complete_dir	*cd;
+	struct menu		*mi;
+	char			 path[MAXPATHLEN], *base, *p, *t;
+	size_t			 dirlen, baselen, len;
+	int			 i, n;
+
+	TAILQ_INIT(resultq);
+
+	if ((base = strrchr(search, '/')) == NULL)
+		return;
+	base++;
+	dirlen = base - search;
+	baselen = strlen(base);
+
+	if (dirlen >= sizeof(path))
+		return;
+	(void)memcpy(path, search, dirlen);
+	path[dirlen] = '\0';
+	if (path[0] == '~') {
+		char	 typed[MAXPATHLEN];
+
+		(void)strlcpy(typed, path, sizeof(typed));
+		if (complete_expand(typed, path, sizeof(path)) == -1)
+			return;
+	}
+
+	if ((cd = complete_find(path)) == NULL) {
+		cd = xcalloc(1, sizeof(*cd));
+		cd->path = xstrdup(path);
+		TAILQ_INSERT_HEAD(&complete_dirq, cd, entry);
+		complete_ndirs++;
+	} else {
+		TAILQ_REMOVE(&complete_dirq, cd, entry);
+		TAILQ_INSERT_HEAD(&complete_dirq, cd, entry);
+	}
+	if (!cd->pending && time(NULL) - cd->checked >= COMPLETE_RECHECK)
+		complete_request(cd);
+
+	/* Forget the least recently used, unless still being listed. */
+	while (complete_ndirs > COMPLETE_NDIRS) {
+		TAILQ_FOREACH_REVERSE(cd, &complete_dirq, complete_dir_q,
+		    entry)
+			if (!cd->pending)
+				break;
+		if (cd == NULL)
+			break;
+		TAILQ_REMOVE(&complete_dirq, cd, entry);
+		complete_ndirs--;
+		xfree(cd->names);
+		xfree(cd->path);
+		xfree(cd);
+	}
+
+	cd = TAILQ_FIRST(&complete_dirq);
+	if (cd->names == NULL)
+		return;
+
+	/* Enough for every name with the directory in front. */
+	if (complete_nmv < cd->nnames) {
+		xfree(complete_mv);
+		complete_nmv = cd->nnames;
+		complete_mv = xcalloc(complete_nmv, sizeof(*complete_mv));
+	}
+	len = cd->namelen + cd->nnames * dirlen;
+	if (complete_ntext < len) {
+		xfree(complete_text);
+		complete_ntext = len;
+		complete_text = xmalloc(complete_ntext);
+	}
+
+	t = complete_text;
+	for (p = cd->names, i = n = 0; i < cd->nnames;
+	    p += strlen(p) + 1, i++) {
+		if (strncmp(p, base, baselen) != 0)
+			continue;
+		/* dot files only when asked for */
+		if (p[0] == '.' && base[0] != '.')
+			continue;
+
+		mi = &complete_mv[n++];
+		bzero(mi, sizeof(*mi));
+		mi->text = t;
+		(void)memcpy(t, search, dirlen);
+		t += dirlen;
+		len = strlen(p) + 1;
+		(void)memcpy(t, p, len);
+		t += len;
+		/* A directory is gone into, not run. */
+		mi->descend = p[len - 2] == '/';
+		TAILQ_INSERT_TAIL(resultq, mi, resultentry);
+	}
+}
+
+static struct complete_dir *
+complete_find(const char *path)
+{
+	struct complete_dir	*cd;
+
+	TAILQ_FOREACH(cd, &complete_dirq, entry)
+		if (strcmp(cd->path, path) == 0)
+			return (cd);
+
+	return (NULL);
+}
+
+static void
+complete_request(struct complete_dir *cd)
+{
+	struct complete_req	*req;
+	pthread_attr_t		 attr;
+	pthread_t		 tid;
+	sigset_t		 set, oset;
+	int			 ret;
+
+	/* Nobody would hear back. */
+	if (complete_fd[0] == -1 ||
+	    complete_npending >= COMPLETE_MAXPENDING)
+		return;
+
+	req = xcalloc(1, sizeof(*req));
+	req->path = xstrdup(cd->path);
+	/* Have it only check the mtime of what we already have. */
+	if (cd->names != NULL) {
+		req->dev = cd->dev;
+		req->ino = cd->ino;
+		req->mtime = cd->mtime;
+	}
+
+	(void)pthread_attr_init(&attr);
+	(void)pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	(void)sigfillset(&set);
+	(void)pthread_sigmask(SIG_SETMASK, &set, &oset);
+	ret = pthread_create(&tid, &attr, complete_worker, req);
+	(void)pthread_sigmask(SIG_SETMASK, &oset, NULL);
+	(void)pthread_attr_destroy(&attr);
+
+	if (ret != 0) {
+		xfree(req->path);
+		xfree(req);
+		return;
+	}
+	cd->pending = 1;
+	complete_npending++;
+}
+
+/*
+ * Take in the listings that are done.
+ */
+static int
+complete_fill(struct menu_q *menuq, void *arg)
+{
+	struct complete_req_q	 doneq;
+	struct complete_req	*req;
+	struct complete_dir	*cd;
+	char			 buf[64];
+
+	while (read(complete_fd[0], buf, sizeof(buf)) > 0)
+		;
+
+	TAILQ_INIT(&doneq);
+	(void)pthread_mutex_lock(&complete_mtx);
+	while ((req = TAILQ_FIRST(&complete_doneq)) != NULL) {
+		TAILQ_REMOVE(&complete_doneq, req, entry);
+		TAILQ_INSERT_TAIL(&doneq, req, entry);
+	}
+	(void)pthread_mutex_unlock(&complete_mtx);
+
+	while ((req = TAILQ_FIRST(&doneq)) != NULL) {
+		TAILQ_REMOVE(&doneq, req, entry);
+		complete_npending--;
+
+		if ((cd = complete_find(req->path)) != NULL) {
+			cd->pending = 0;
+			cd->checked = time(NULL);
+			if (req->failed) {
+				xfree(cd->names);
+				cd->names = xcalloc(1, 1);
+				cd->namelen = 0;
+				cd->nnames = 0;
+			} else if (!req->unchanged) {
+				xfree(cd->names);
+				cd->names = req->names;
+				cd->namelen = req->namelen;
+				cd->nnames = req->nnames;
+				cd->dev = req->dev;
+				cd->ino = req->ino;
+				cd->mtime = req->mtime;
+				req->names = NULL;
+			}
+		}
+		xfree(req->names);
+		xfree(req->path);
+		xfree(req);
+	}
+
+	/* Keep listening for as long as the menu is open. */
+	return (1);
+}
+
+static void *
+complete_worker(void *arg)
+{
+	struct complete_req	*req = arg;
+
+	complete_list(req);
+
+	(void)pthread_mutex_lock(&complete_mtx);
+	TAILQ_INSERT_TAIL(&complete_doneq, req, entry);
+	(void)pthread_mutex_unlock(&complete_mtx);
+	(void)write(complete_fd[1], "", 1);
+
+	return (NULL);
+}
+
+/*
+ * List the executables and subdirectories of req->path, the latter
+ * with a '/' added; unless it has not changed since last time.
+ */
+static void
+complete_list(struct complete_req *req)
+{
+	DIR		*dirp;
+	struct dirent	*dp;
+	struct stat	 sb;
+	char		**nv = NULL, *p;
+	size_t		 len, total = 0;
+	int		 fd, i, isdir, nalloc = 0, n = 0;
+
+	if ((fd = open(req->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1 ||
+	    fstat(fd, &sb) == -1) {
+		if (fd != -1)
+			(void)close(fd);
+		req->failed = 1;
+		return;
+	}
+	if (sb.st_dev == req->dev && sb.st_ino == req->ino &&
+	    sb.st_mtim.tv_sec == req->mtime.tv_sec &&
+	    sb.st_mtim.tv_nsec == req->mtime.tv_nsec) {
+		(void)close(fd);
+		req->unchanged = 1;
+		return;
+	}
+	req->dev = sb.st_dev;
+	req->ino = sb.st_ino;
+	req->mtime = sb.st_mtim;
+
+	if ((dirp = fdopendir(fd)) == NULL) {
+		(void)close(fd);
+		req->failed = 1;
+		return;
+	}
+
+	while ((dp = readdir(dirp)) != NULL) {
+		if (strcmp(dp->d_name, ".") == 0 ||
+		    strcmp(dp->d_name, "..") == 0)
+			continue;
+
+		switch (dp->d_type) {
+		case DT_DIR:
+			isdir = 1;
+			break;
+		case DT_REG:
+			isdir = 0;
+			break;
+		case DT_LNK:
+		case DT_UNKNOWN:
+			if (fstatat(fd, dp->d_name, &sb, 0) == -1)
+				continue;
+			if (S_ISDIR(sb.st_mode))
+				isdir = 1;
+			else if (S_ISREG(sb.st_mode))
+				isdir = 0;
+			else
+				continue;
+			break;
+		default:
+			continue;
+		}
+		if (!isdir &&
+		    faccessat(fd, dp->d_name, X_OK, AT_EACCESS) != 0)
+			continue;
+
+		if (n == nalloc) {
+			nalloc = MAX(nalloc * 2, 64);
+			nv = xrealloc(nv, nalloc * sizeof(*nv));
+		}
+		len = strlen(dp->d_name);
+		nv[n] = xmalloc(len + 2);
+		(void)memcpy(nv[n], dp->d_name, len);
+		nv[n][len] = isdir ? '/' : '\0';
+		nv[n][len + 1] = '\0';
+		total += strlen(nv[n]) + 1;
+		n++;
+	}
+	(void)closedir(dirp);
+
+	qsort(nv, n, sizeof(*nv), complete_namecmp);
+
+	req->names = p = xmalloc(total + 1);
+	for (i = 0; i < n; i++) {
+		len = strlen(nv[i]) + 1;
+		(void)memcpy(p, nv[i], len);
+		p += len;
+		xfree(nv[i]);
+	}
+	*p = '\0';
+	req->namelen = total;
+	req->nnames = n;
+	xfree(nv);
+}
+
+/* Same order as search_sort(). */
+static int
+complete_namecmp(const void *a, const void *b)
+{
+	const char	*sa = *(const char **)a;
+	const char	*sb = *(const char **)b;
+	int		 r;
+
+	if ((r = strcasecmp(sa, sb)) != 0)
+		return (r);
+	return (strcmp(sa, sb));
+}
@@ -93,9 +93,12 @@ conf_reload(struct conf *c)
 {
 	struct screen_ctx	*sc;
 	struct client_ctx	*cc;
+	struct trace_span	 ts;
 
+	trace_begin(&ts, "conf_reload", 0);
 	if (parse_config(c->conf_path, c) == -1) {
 		warnx("config file %s has errors, not reloading", c->conf_path);
+		trace_end(&ts);
 		return;
 	}
 
@@ -107,6 +110,7 @@ conf_reload(struct conf *c)
 	}
 	TAILQ_FOREACH(cc, &Clientq, entry)
 		client_draw_border(cc);
+	trace_end(&ts);
 }
 
 static struct {
@@ -193,6 +197,8 @@ conf_init(struct conf *c)
 	c->bwidth = CONF_BWIDTH;
 	c->mamount = CONF_MAMOUNT;
 	c->snapdist = CONF_SNAPDIST;
+	c->filterthreads = CONF_FILTERTHREADS;
+	c->watchdog = CONF_WATCHDOG;
 
 	TAILQ_INIT(&c->ignoreq);
 	TAILQ_INIT(&c->cmdq);
@@ -238,9 +244,9 @@ conf_clear(struct conf *c)
 
 	while ((ag = TAILQ_FIRST(&c->autogroupq)) != NULL) {
 		TAILQ_REMOVE(&c->autogroupq, ag, entry);
-		xfree(ag->class);
+		intern_put(ag->class);
 		if (ag->name)
-			xfree(ag->name);
+			intern_put(ag->name);
 		xfree(ag);
 	}
 
@@ -318,12 +324,14 @@ static struct {
 } name_to_kbfunc[] = {
 	{ "lower", kbfunc_client_lower, KBFLAG_NEEDCLIENT, {0} },
 	{ "raise", kbfunc_client_raise, KBFLAG_NEEDCLIENT, {0} },
-	{ "search", kbfunc_client_search, 0, {0} },
-	{ "menusearch", kbfunc_menu_search, 0, {0} },
+	{ "search", kbfunc_client_search, KBFLAG_INTERACTIVE, {0} },
+	{ "menusearch", kbfunc_menu_search, KBFLAG_INTERACTIVE, {0} },
+	{ "appsearch", kbfunc_app_search, KBFLAG_INTERACTIVE, {0} },
 	{ "hide", kbfunc_client_hide, KBFLAG_NEEDCLIENT, {0} },
-	{ "cycle", kbfunc_client_cycle, 0, {.i = CWM_CYCLE} },
-	{ "rcycle", kbfunc_client_cycle, 0, {.i = CWM_RCYCLE} },
-	{ "label", kbfunc_client_label, KBFLAG_NEEDCLIENT, {0} },
+	{ "cycle", kbfunc_client_cycle, KBFLAG_INTERACTIVE, {.i = CWM_CYCLE} },
+	{ "rcycle", kbfunc_client_cycle, KBFLAG_INTERACTIVE, {.i = CWM_RCYCLE} },
+	{ "label", kbfunc_client_label,
+	    KBFLAG_NEEDCLIENT|KBFLAG_INTERACTIVE, {0} },
 	{ "delete", kbfunc_client_delete, KBFLAG_NEEDCLIENT, {0} },
 	{ "group1", kbfunc_client_group, 0, {.i = 1} },
 	{ "group2", kbfunc_client_group, 0, {.i = 2} },
@@ -364,8 +372,10 @@ static struct {
 	{ "nogroup", kbfunc_client_nogroup, 0, {0} },
 	{ "cyclegroup", kbfunc_client_cyclegroup, 0, {.i = CWM_CYCLE} },
 	{ "rcyclegroup", kbfunc_client_cyclegroup, 0, {.i = CWM_RCYCLE} },
-	{ "cycleingroup", kbfunc_client_cycle, KBFLAG_NEEDCLIENT, {.i = CWM_CYCLE|CWM_INGROUP} },
-	{ "rcycleingroup", kbfunc_client_cycle, KBFLAG_NEEDCLIENT, {.i = CWM_RCYCLE|CWM_INGROUP} },
+	{ "cycleingroup", kbfunc_client_cycle,
+	    KBFLAG_NEEDCLIENT|KBFLAG_INTERACTIVE, {.i = CWM_CYCLE|CWM_INGROUP} },
+	{ "rcycleingroup", kbfunc_client_cycle,
+	    KBFLAG_NEEDCLIENT|KBFLAG_INTERACTIVE, {.i = CWM_RCYCLE|CWM_INGROUP} },
 	{ "grouptoggle", kbfunc_client_grouptoggle, KBFLAG_NEEDCLIENT, {0}},
 	{ "maximize", kbfunc_client_maximize, KBFLAG_NEEDCLIENT, {0} },
 	{ "vmaximize", kbfunc_client_vmaximize, KBFLAG_NEEDCLIENT, {0} },
@@ -375,9 +385,9 @@ static struct {
 	{ "freeze", kbfunc_client_freeze, KBFLAG_NEEDCLIENT, {0} },
 	{ "reload", kbfunc_reload, 0, {0} },
 	{ "quit", kbfunc_quit_wm, 0, {0} },
-	{ "exec", kbfunc_exec, 0, {.i = CWM_EXEC_PROGRAM} },
-	{ "exec_wm", kbfunc_exec, 0, {.i = CWM_EXEC_WM} },
-	{ "ssh", kbfunc_ssh, 0, {0} },
+	{ "exec", kbfunc_exec, KBFLAG_INTERACTIVE, {.i = CWM_EXEC_PROGRAM} },
+	{ "exec_wm", kbfunc_exec, KBFLAG_INTERACTIVE, {.i = CWM_EXEC_WM} },
+	{ "ssh", kbfunc_ssh, KBFLAG_INTERACTIVE, {0} },
 	{ "terminal", kbfunc_term, 0, {0} },
 	{ "lock", kbfunc_lock, 0, {0} },
 	{ "moveup", kbfunc_moveresize, KBFLAG_NEEDCLIENT,
@@ -532,6 +542,27 @@ conf_bindname(struct conf *c, char *name, char *binding)
 	TAILQ_INSERT_TAIL(&c->keybindingq, current_binding, entry);
 }
 
+/*
+ * Fill in kb with the function bound to name, as bind would; for the
+ * control socket.
+ */
+int
+conf_kbfunc(const char *name, struct keybinding *kb)
+{
+	int	 iter;
+
+	for (iter = 0; iter < nitems(name_to_kbfunc); iter++) {
+		if (strcmp(name_to_kbfunc[iter].tag, name) != 0)
+			continue;
+
+		kb->callback = name_to_kbfunc[iter].handler;
+		kb->flags = name_to_kbfunc[iter].flags;
+		kb->argument = name_to_kbfunc[iter].argument;
+		return (0);
+	}
+	return (-1);
+}
+
 static void
 conf_unbind(struct conf *c, struct keybinding *unbind)
 {
@@ -0,0 +1,795 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * The control socket, ~/cwm-<display>.sock.  Requests are lines of a
+ * command name and its arguments; the answer to each is zero or more
+ * JSON lines followed by a status line, {"status":"ok"} or
+ * {"status":"error","error":"..."}.  Besides the commands below, any
+ * function that can be bound to a key may be run, on the clients named
+ * by its argument.  A connection may subscribe to events, which are
+ * then written to it as they happen.  All sockets are non-blocking and
+ * served from the event loop's poll(2) alongside the X connection, so a
+ * slow or stuck reader only ever loses its own connection.
+ */
+
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "calmwm.h"
+
+#define CTL_SOCKET	"cwm-%s.sock"
+#define CTL_LINELEN	1024
+#define CTL_MAXOUT	(1024 * 1024)	/* unread answers before hanging up */
+#define CTL_MAXMATCH	256		/* clients one request acts on */
+
+struct ctl_conn {
+	TAILQ_ENTRY(ctl_conn)	 entry;
+	int			 fd;
+	int			 eof;
+	int			 hangup;
+	u_int			 events;	/* subscribed to, by bit */
+	char			 in[CTL_LINELEN];
+	size_t			 inlen;
+	char			*out;
+	size_t			 outlen;
+	size_t			 outoff;
+};
+TAILQ_HEAD(ctl_conn_q, ctl_conn);
+
+struct ctl_cmd {
+	const char	*name;
+	const char	*(*func)(struct ctl_conn *, FILE *, char *);
+};
+
+static void		 ctl_accept(void);
+static void		 ctl_close(struct ctl_conn *);
+static void		 ctl_read(struct ctl_conn *);
+static void		 ctl_write(struct ctl_conn *);
+static void		 ctl_request(struct ctl_conn *, char *);
+static void		 ctl_queue(struct ctl_conn *, const char *, size_t);
+static void		 ctl_event(u_int, const char *, size_t);
+static void		 ctl_json_str(FILE *, const char *);
+static int		 ctl_match(const char *, Window *, int);
+static const char	*ctl_kbfunc(FILE *, char *, char *);
+static const char	*ctl_clients(struct ctl_conn *, FILE *,
+			     char *);
+static const char	*ctl_focus(struct ctl_conn *, FILE *,
+			     char *);
+static const char	*ctl_geom(struct ctl_conn *, FILE *,
+			     char *);
+static const char	*ctl_stats(struct ctl_conn *, FILE *,
+			     char *);
+static const char	*ctl_subscribe(struct ctl_conn *, FILE *,
+			     char *);
+
+static const struct ctl_cmd	ctl_cmds[] = {
+	{ "clients",	ctl_clients },
+	{ "focus",	ctl_focus },
+	{ "geom",	ctl_geom },
+	{ "stats",	ctl_stats },
+	{ "subscribe",	ctl_subscribe },
+};
+
+static const char	*ctl_events[CTL_EV_NEVENTS] = {
+	[CTL_EV_ADD] = "add",
+	[CTL_EV_REMOVE] = "remove",
+	[CTL_EV_FOCUS] = "focus",
+	[CTL_EV_TITLE] = "title",
+	[CTL_EV_LABEL] = "label",
+	[CTL_EV_CLIENTGROUP] = "clientgroup",
+	[CTL_EV_GROUP] = "group",
+};
+
+static struct ctl_conn_q ctl_conns = TAILQ_HEAD_INITIALIZER(ctl_conns);
+static int		 ctl_nconns;
+static int		 ctl_nsubs;
+static int		 ctl_fd = -1;
+static char		 ctl_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+static struct timespec	 ctl_start;
+
+/*
+ * Listen on $CWM_SOCKET, or ~/cwm-<display>.sock; an empty CWM_SOCKET
+ * turns the socket off.  Failing to listen is not fatal.
+ */
+void
+ctl_init(void)
+{
+	struct sockaddr_un	 sun;
+	const char		*path, *home, *dpy;
+	mode_t			 mask;
+	int			 len;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &ctl_start);
+
+	if ((path = getenv("CWM_SOCKET")) != NULL) {
+		if (path[0] == '\0')
+			return;
+		len = strlcpy(ctl_path, path, sizeof(ctl_path));
+	} else {
+		if ((home = getenv("HOME")) == NULL)
+			return;
+		dpy = DisplayString(X_Dpy);
+		if ((path = strrchr(dpy, ':')) != NULL)
+			dpy = path + 1;
+		len = snprintf(ctl_path, sizeof(ctl_path), "%s/" CTL_SOCKET,
+		    home, dpy);
+	}
+	if (len < 0 || len >= sizeof(ctl_path)) {
+		warnx("control socket path too long");
+		ctl_path[0] = '\0';
+		return;
+	}
+
+	bzero(&sun, sizeof(sun));
+	sun.sun_family = AF_UNIX;
+	(void)strlcpy(sun.sun_path, ctl_path, sizeof(sun.sun_path));
+
+	if ((ctl_fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) {
+		warn("control socket");
+		return;
+	}
+	/* Only one window manager runs per display: it is a stale one. */
+	(void)unlink(ctl_path);
+	mask = umask(0077);
+	if (bind(ctl_fd, (struct sockaddr *)&sun, sizeof(sun)) == -1 ||
+	    listen(ctl_fd, 8) == -1) {
+		warn("%s", ctl_path);
+		(void)umask(mask);
+		(void)close(ctl_fd);
+		ctl_fd = -1;
+		ctl_path[0] = '\0';
+		return;
+	}
+	(void)umask(mask);
+	(void)fcntl(ctl_fd, F_SETFL, O_NONBLOCK);
+	(void)fcntl(ctl_fd, F_SETFD, FD_CLOEXEC);
+	log_info("control socket %s", ctl_path);
+}
+
+void
+ctl_teardown(void)
+{
+	struct ctl_conn	*c;
+
+	while ((c = TAILQ_FIRST(&ctl_conns)) != NULL)
+		ctl_close(c);
+	if (ctl_fd != -1) {
+		(void)close(ctl_fd);
+		ctl_fd = -1;
+	}
+	if (ctl_path[0] != '\0')
+		(void)unlink(ctl_path);
+}
+
+/*
+ * Fill in the descriptors to poll, at most CTL_MAXFDS, and return how
+ * many there are.
+ */
+int
+ctl_pollfds(struct pollfd *pfd)
+{
+	struct ctl_conn	*c, *next;
+	int		 n = 0;
+
+	if (ctl_fd == -1)
+		return (0);
+
+	for (c = TAILQ_FIRST(&ctl_conns); c != NULL; c = next) {
+		next = TAILQ_NEXT(c, entry);
+		if (c->hangup)
+			ctl_close(c);
+	}
+
+	pfd[n].fd = ctl_fd;
+	pfd[n].events = POLLIN;
+	pfd[n++].revents = 0;
+	TAILQ_FOREACH(c, &ctl_conns, entry) {
+		pfd[n].fd = c->fd;
+		pfd[n].events = c->eof ? 0 : POLLIN;
+		if (c->outoff < c->outlen)
+			pfd[n].events |= POLLOUT;
+		pfd[n++].revents = 0;
+	}
+	return (n);
+}
+
+/*
+ * Serve the descriptors ctl_pollfds() filled in, once poll(2) is done.
+ */
+void
+ctl_dispatch(struct pollfd *pfd, int n)
+{
+	struct ctl_conn	*c, *next;
+	int		 i;
+
+	if (n == 0)
+		return;
+
+	/* The connections are in the order ctl_pollfds() saw them. */
+	for (c = TAILQ_FIRST(&ctl_conns), i = 1; c != NULL && i < n;
+	    c = next, i++) {
+		next = TAILQ_NEXT(c, entry);
+		/* Subscribers stay after end of file, until hung up. */
+		if ((pfd[i].revents & (POLLERR | POLLNVAL)) ||
+		    (c->eof && (pfd[i].revents & POLLHUP))) {
+			ctl_close(c);
+			continue;
+		}
+		if (pfd[i].revents & (POLLIN | POLLHUP))
+			ctl_read(c);
+		else if (pfd[i].revents & POLLOUT)
+			ctl_write(c);
+	}
+	if (pfd[0].revents & POLLIN)
+		ctl_accept();
+}
+
+static void
+ctl_accept(void)
+{
+	struct ctl_conn	*c;
+	int		 fd;
+
+	if ((fd = accept(ctl_fd, NULL, NULL)) == -1)
+		return;
+	if (ctl_nconns == CTL_MAXCONNS) {
+		log_warn("control socket: too many connections");
+		(void)close(fd);
+		return;
+	}
+	(void)fcntl(fd, F_SETFL, O_NONBLOCK);
+	(void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+	c = xcalloc(1, sizeof(*c));
+	c->fd = fd;
+	TAILQ_INSERT_TAIL(&ctl_conns, c, entry);
+	ctl_nconns++;
+}
+
+static void
+ctl_close(struct ctl_conn *c)
+{
+	TAILQ_REMOVE(&ctl_conns, c, entry);
+	ctl_nconns--;
+	if (c->events != 0)
+		ctl_nsubs--;
+	(void)close(c->fd);
+	xfree(c->out);
+	xfree(c);
+}
+
+/*
+ * Read what there is and answer each complete line.  At end of file,
+ * the connection stays until the answers are written, or for good if
+ * it subscribed to events.
+ */
+static void
+ctl_read(struct ctl_conn *c)
+{
+	char	*line, *nl;
+	ssize_t	 n;
+
+	n = read(c->fd, c->in + c->inlen, sizeof(c->in) - 1 - c->inlen);
+	if (n == -1) {
+		if (errno != EAGAIN && errno != EINTR)
+			ctl_close(c);
+		return;
+	}
+	c->inlen += n;
+	/* The last line may go without a newline. */
+	if (n == 0) {
+		c->eof = 1;
+		if (c->inlen > 0)
+			c->in[c->inlen++] = '\n';
+	}
+
+	line = c->in;
+	while ((nl = memchr(line, '\n', c->inlen - (line - c->in))) != NULL) {
+		*nl = '\0';
+		ctl_request(c, line);
+		line = nl + 1;
+	}
+	c->inlen -= line - c->in;
+	(void)memmove(c->in, line, c->inlen);
+
+	if (c->inlen == sizeof(c->in) - 1) {
+		log_warn("control socket: request too long");
+		ctl_close(c);
+		return;
+	}
+	ctl_write(c);
+}
+
+static void
+ctl_write(struct ctl_conn *c)
+{
+	ssize_t	 n;
+
+	if (c->outoff < c->outlen) {
+		n = send(c->fd, c->out + c->outoff, c->outlen - c->outoff,
+		    MSG_NOSIGNAL);
+		if (n == -1) {
+			if (errno != EAGAIN && errno != EINTR)
+				ctl_close(c);
+			return;
+		}
+		c->outoff += n;
+	}
+	if (c->outoff < c->outlen)
+		return;
+
+	c->outoff = c->outlen = 0;
+	if (c->eof && c->events == 0)
+		ctl_close(c);
+}
+
+/*
+ * Run one request and queue its answer.
+ */
+static void
+ctl_request(struct ctl_conn *c, char *line)
+{
+	const struct ctl_cmd	*cmd = NULL;
+	const char		*error;
+	FILE			*f;
+	char			*name, *buf = NULL;
+	size_t			 i, len = 0;
+
+	line[strcspn(line, "\r")] = '\0';
+	name = line + strspn(line, " \t");
+	line = name + strcspn(name, " \t");
+	if (*line != '\0')
+		*line++ = '\0';
+	line += strspn(line, " \t");
+	if (*name == '\0')
+		return;
+
+	if ((f = open_memstream(&buf, &len)) == NULL)
+		err(1, "open_memstream");
+	for (i = 0; i < nitems(ctl_cmds); i++)
+		if (strcmp(name, ctl_cmds[i].name) == 0)
+			cmd = &ctl_cmds[i];
+	if (cmd != NULL)
+		error = (*cmd->func)(c, f, line);
+	else
+		error = ctl_kbfunc(f, name, line);
+
+	if (error == NULL)
+		fprintf(f, "{\"status\":\"ok\"}\n");
+	else {
+		fprintf(f, "{\"status\":\"error\",\"error\":");
+		ctl_json_str(f, error);
+		fprintf(f, "}\n");
+	}
+	if (fclose(f) == EOF)
+		err(1, "open_memstream");
+
+	ctl_queue(c, buf, len);
+	free(buf);		/* from open_memstream(3), not xmalloc() */
+}
+
+/*
+ * Add to what is waiting to be written; ctl_write() writes it once
+ * poll(2) says the reader is ready.
+ */
+static void
+ctl_queue(struct ctl_conn *c, const char *buf, size_t len)
+{
+	if (c->hangup)
+		return;
+
+	/* A reader this far behind is not reading. */
+	if (c->outlen + len > CTL_MAXOUT) {
+		log_warn("control socket: reader too slow");
+		c->hangup = 1;
+		return;
+	}
+	c->out = xrealloc(c->out, c->outlen + len);
+	(void)memcpy(c->out + c->outlen, buf, len);
+	c->outlen += len;
+}
+
+/*
+ * Tell whoever subscribed to ev what happened to cc.
+ */
+void
+ctl_event_client(int ev, struct client_ctx *cc)
+{
+	FILE	*f;
+	char	*buf = NULL;
+	size_t	 len = 0;
+
+	if (ctl_nsubs == 0)
+		return;
+
+	if ((f = open_memstream(&buf, &len)) == NULL)
+		err(1, "open_memstream");
+	fprintf(f, "{\"event\":\"%s\",\"window\":\"0x%lx\"",
+	    ctl_events[ev], cc->win);
+	switch (ev) {
+	case CTL_EV_ADD:
+		fprintf(f, ",\"screen\":%u,\"group\":%d,\"name\":",
+		    cc->sc->which, cc->group != NULL ? cc->group->shortcut : 0);
+		ctl_json_str(f, cc->name != NULL ? cc->name : "");
+		fprintf(f, ",\"class\":");
+		ctl_json_str(f, cc->cold->app_class != NULL ?
+		    cc->cold->app_class : "");
+		break;
+	case CTL_EV_FOCUS:
+		fprintf(f, ",\"screen\":%u", cc->sc->which);
+		break;
+	case CTL_EV_TITLE:
+		fprintf(f, ",\"name\":");
+		ctl_json_str(f, cc->name != NULL ? cc->name : "");
+		break;
+	case CTL_EV_LABEL:
+		fprintf(f, ",\"label\":");
+		ctl_json_str(f, cc->cold->label != NULL ?
+		    cc->cold->label : "");
+		break;
+	case CTL_EV_CLIENTGROUP:
+		fprintf(f, ",\"group\":%d",
+		    cc->group != NULL ? cc->group->shortcut : 0);
+		break;
+	}
+	fprintf(f, "}\n");
+	if (fclose(f) == EOF)
+		err(1, "open_memstream");
+
+	ctl_event(ev, buf, len);
+	free(buf);
+}
+
+/*
+ * Likewise for a group shown or hidden.
+ */
+void
+ctl_event_group(struct screen_ctx *sc, struct group_ctx *gc)
+{
+	FILE	*f;
+	char	*buf = NULL;
+	size_t	 len = 0;
+	int	 i = gc->shortcut - 1;
+
+	if (ctl_nsubs == 0)
+		return;
+
+	if ((f = open_memstream(&buf, &len)) == NULL)
+		err(1, "open_memstream");
+	fprintf(f, "{\"event\":\"%s\",\"screen\":%u,\"group\":%d,"
+	    "\"name\":", ctl_events[CTL_EV_GROUP], sc->which, gc->shortcut);
+	ctl_json_str(f, i < sc->group_nonames ? sc->group_names[i] : "");
+	fprintf(f, ",\"hidden\":%s}\n", gc->hidden ? "true" : "false");
+	if (fclose(f) == EOF)
+		err(1, "open_memstream");
+
+	ctl_event(CTL_EV_GROUP, buf, len);
+	free(buf);
+}
+
+static void
+ctl_event(u_int ev, const char *buf, size_t len)
+{
+	struct ctl_conn	*c;
+
+	TAILQ_FOREACH(c, &ctl_conns, entry)
+		if (c->events & (1 << ev))
+			ctl_queue(c, buf, len);
+}
+
+static void
+ctl_json_str(FILE *f, const char *s)
+{
+	u_char	 ch;
+
+	fputc('"', f);
+	for (; (ch = *s) != '\0'; s++) {
+		if (ch == '"' || ch == '\\')
+			fprintf(f, "\\%c", ch);
+		else if (ch < 0x20)
+			fprintf(f, "\\u%04x", ch);
+		else
+			fputc(ch, f);
+	}
+	fputc('"', f);
+}
+
+/*
+ * Find the clients spec names, at most max of them: a window id, or
+ * label:, class: or name: and the client's label, class or title.
+ * Returns how many, or -1 if spec is none of these.
+ */
+static int
+ctl_match(const char *spec, Window *wins, int max)
+{
+	struct client_ctx	*cc;
+	const char		*arg, *s;
+	char			*ep;
+	u_long			 win = None;
+	int			 field, n = 0;
+	enum { BYWIN, BYLABEL, BYCLASS, BYNAME };
+
+	if ((arg = strchr(spec, ':')) != NULL)
+		arg++;
+	if (strncmp(spec, "label:", 6) == 0)
+		field = BYLABEL;
+	else if (strncmp(spec, "class:", 6) == 0)
+		field = BYCLASS;
+	else if (strncmp(spec, "name:", 5) == 0)
+		field = BYNAME;
+	else {
+		field = BYWIN;
+		errno = 0;
+		win = strtoul(spec, &ep, 0);
+		if (spec[0] == '\0' || *ep != '\0' || errno == ERANGE)
+			return (-1);
+	}
+
+	TAILQ_FOREACH(cc, &Clientq, entry) {
+		switch (field) {
+		case BYWIN:
+			if (cc->win != win)
+				continue;
+			break;
+		case BYLABEL:
+		case BYCLASS:
+		case BYNAME:
+			s = (field == BYLABEL) ? cc->cold->label :
+			    (field == BYCLASS) ? cc->cold->app_class : cc->name;
+			if (s == NULL || strcmp(s, arg) != 0)
+				continue;
+			break;
+		}
+		if (n == max)
+			break;
+		wins[n++] = cc->win;
+	}
+	return (n);
+}
+
+/*
+ * A function that can be bound, by name.  Those wanting a client get
+ * each client args names, or the current one; the others get the
+ * screen of the first, or the first screen.  Functions waiting for
+ * the user, menus and cycling, are refused.
+ */
+static const char *
+ctl_kbfunc(FILE *f, char *name, char *args)
+{
+	struct keybinding	 kb;
+	struct client_ctx	*cc, fakecc;
+	Window			 wins[CTL_MAXMATCH];
+	int			 i, n = 0;
+
+	if (conf_kbfunc(name, &kb) == -1)
+		return ("unknown command");
+	if (kb.flags & KBFLAG_INTERACTIVE)
+		return ("interactive function");
+
+	if (*args != '\0' && (n = ctl_match(args, wins, nitems(wins))) <= 0)
+		return (n == 0 ? "no such client" : "bad client");
+	if (n == 0 && (cc = client_current()) != NULL)
+		wins[n++] = cc->win;
+
+	if (!(kb.flags & KBFLAG_NEEDCLIENT)) {
+		cc = &fakecc;
+		cc->sc = TAILQ_FIRST(&Screenq);
+		if (n > 0)
+			cc->sc = client_find(wins[0])->sc;
+		(*kb.callback)(cc, &kb.argument);
+		return (NULL);
+	}
+	if (n == 0)
+		return ("no client");
+	/* The functions may well change Clientq. */
+	for (i = 0; i < n; i++)
+		if ((cc = client_find(wins[i])) != NULL)
+			(*kb.callback)(cc, &kb.argument);
+	return (NULL);
+}
+
+/*
+ * clients: one line per client, in the order they were managed.
+ */
+static const char *
+ctl_clients(struct ctl_conn *c, FILE *f, char *args)
+{
+	struct client_ctx	*cc;
+
+	if (*args != '\0')
+		return ("clients takes no arguments");
+
+	TAILQ_FOREACH(cc, &Clientq, entry) {
+		fprintf(f, "{\"window\":\"0x%lx\",\"screen\":%u,"
+		    "\"group\":%d,\"name\":", cc->win, cc->sc->which,
+		    cc->group != NULL ? cc->group->shortcut : 0);
+		ctl_json_str(f, cc->name != NULL ? cc->name : "");
+		fprintf(f, ",\"class\":");
+		ctl_json_str(f, cc->cold->app_class != NULL ?
+		    cc->cold->app_class : "");
+		fprintf(f, ",\"label\":");
+		ctl_json_str(f, cc->cold->label != NULL ?
+		    cc->cold->label : "");
+		fprintf(f, ",\"active\":%s,\"hidden\":%s,"
+		    "\"x\":%d,\"y\":%d,\"width\":%d,\"height\":%d}\n",
+		    cc == client_current() ? "true" : "false",
+		    cc->flags & CLIENT_HIDDEN ? "true" : "false",
+		    cc->geom.x, cc->geom.y, cc->geom.width, cc->geom.height);
+	}
+	return (NULL);
+}
+
+/*
+ * focus client: show it and move the pointer there, as choosing it
+ * from the window menu does.
+ */
+static const char *
+ctl_focus(struct ctl_conn *c, FILE *f, char *args)
+{
+	struct client_ctx	*cc, *old_cc;
+	Window			 win;
+	int			 n;
+
+	if ((n = ctl_match(args, &win, 1)) <= 0)
+		return (n == 0 ? "no such client" : "bad client");
+	cc = client_find(win);
+
+	old_cc = client_current();
+	if (cc->flags & CLIENT_HIDDEN)
+		client_unhide(cc);
+	if (old_cc != NULL)
+		client_ptrsave(old_cc);
+	client_ptrwarp(cc);
+	return (NULL);
+}
+
+/*
+ * geom client WxH+X+Y: move and resize, any part of the geometry
+ * left out staying as it is.
+ */
+static const char *
+ctl_geom(struct ctl_conn *c, FILE *f, char *args)
+{
+	struct client_ctx	*cc;
+	Window			 wins[CTL_MAXMATCH];
+	char			*geom;
+	u_int			 w, h;
+	int			 i, n, x, y, mask;
+
+	geom = args + strcspn(args, " \t");
+	if (*geom != '\0')
+		*geom++ = '\0';
+	geom += strspn(geom, " \t");
+	if ((mask = XParseGeometry(geom, &x, &y, &w, &h)) == 0)
+		return ("bad geometry");
+	if ((n = ctl_match(args, wins, nitems(wins))) <= 0)
+		return (n == 0 ? "no such client" : "bad client");
+
+	for (i = 0; i < n; i++) {
+		cc = client_find(wins[i]);
+		if (cc->flags & CLIENT_FREEZE)
+			continue;
+		if (mask & XValue)
+			cc->geom.x = (mask & XNegative) ?
+			    cc->sc->xmax - cc->geom.width + x : x;
+		if (mask & YValue)
+			cc->geom.y = (mask & YNegative) ?
+			    cc->sc->ymax - cc->geom.height + y : y;
+		if (mask & WidthValue)
+			cc->geom.width = MAX(w, 1);
+		if (mask & HeightValue)
+			cc->geom.height = MAX(h, 1);
+		cc->flags &= ~CLIENT_MAXIMIZED;
+		client_resize(cc);
+	}
+	return (NULL);
+}
+
+/*
+ * subscribe [event ...]: from now on, a line for each of these events,
+ * or all of them.
+ */
+static const char *
+ctl_subscribe(struct ctl_conn *c, FILE *f, char *args)
+{
+	char	*ev;
+	u_int	 events = 0;
+	int	 i;
+
+	while ((ev = strsep(&args, " \t")) != NULL) {
+		if (*ev == '\0')
+			continue;
+		for (i = 0; i < CTL_EV_NEVENTS; i++)
+			if (strcmp(ev, ctl_events[i]) == 0)
+				break;
+		if (i == CTL_EV_NEVENTS)
+			return ("unknown event");
+		events |= 1 << i;
+	}
+	if (events == 0)
+		events = (1 << CTL_EV_NEVENTS) - 1;
+
+	if (c->events == 0)
+		ctl_nsubs++;
+	c->events = events;
+	return (NULL);
+}
+
+/*
+ * stats: uptime, events, clients per screen and group, menus, X
+ * requests and allocations.
+ */
+static const char *
+ctl_stats(struct ctl_conn *c, FILE *f, char *args)
+{
+	struct screen_ctx	*sc;
+	struct client_ctx	*cc;
+	struct group_ctx	*gc;
+	struct timespec		 now;
+	int			 i, n;
+
+	if (*args != '\0')
+		return ("stats takes no arguments");
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	fprintf(f, "{\"stat\":\"uptime\",\"seconds\":%.3f,\"pid\":%ld}\n",
+	    (now.tv_sec - ctl_start.tv_sec) +
+	    (now.tv_nsec - ctl_start.tv_nsec) / 1e9, (long)getpid());
+
+	xev_stats(f);
+
+	TAILQ_FOREACH(sc, &Screenq, entry) {
+		n = 0;
+		TAILQ_FOREACH(cc, &Clientq, entry)
+			if (cc->sc == sc)
+				n++;
+		fprintf(f, "{\"stat\":\"screen\",\"screen\":%u,"
+		    "\"clients\":%d,\"groups\":[", sc->which, n);
+		for (i = 0; i < CALMWM_NGROUPS; i++) {
+			gc = &sc->groups[i];
+			n = 0;
+			TAILQ_FOREACH(cc, &gc->clients, group_entry)
+				n++;
+			fprintf(f, "%s{\"group\":%d,\"name\":", i ? "," : "",
+			    gc->shortcut);
+			ctl_json_str(f, i < sc->group_nonames ?
+			    sc->group_names[i] : "");
+			fprintf(f, ",\"clients\":%d,\"hidden\":%s}", n,
+			    gc->hidden ? "true" : "false");
+		}
+		fprintf(f, "]}\n");
+	}
+
+	menu_stats(f);
+	xop_stats(f);
+	xmalloc_stats(f);
+
+	return (NULL);
+}
@@ -0,0 +1,734 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Copyright (c) 2004 Martin Murray <mmurray@monkey.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Applications from the XDG .desktop files, for the application
+ * launcher menu.
+ *
+ * The Name, Exec and Keywords of every entry are kept in a catalog
+ * file, together with the modification time of each applications
+ * directory they came from.  Opening the menu only stats those
+ * directories; the ones that changed are read again, the others are
+ * copied over from the old catalog, and the result is mapped.
+ *
+ * The catalog holds every entry found, sorted by name; entries that
+ * are hidden, or shadowed by one with the same desktop file id in a
+ * more important directory, are just not marked for showing.
+ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include <dirent.h>
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "calmwm.h"
+
+#define DESKTOP_MAGIC		"CWMDESK1"
+#define DESKTOP_MAXDIRS		1024
+#define DESKTOP_MAXFILE		(64 * 1024)
+
+struct desktop_hdr {
+	char		 magic[8];
+	uint32_t	 ndirs;
+	uint32_t	 napps;
+	uint32_t	 strslen;
+	uint32_t	 pad;
+};
+
+/* Offsets are into the strings, which follow the records. */
+struct desktop_dirrec {
+	uint64_t	 dev;
+	uint64_t	 ino;
+	int64_t		 sec;
+	int64_t		 nsec;
+	uint32_t	 path;
+	uint32_t	 pad;
+};
+
+struct desktop_apprec {
+	uint32_t	 dir;
+	uint32_t	 id;
+	uint32_t	 name;
+	uint32_t	 exec;
+	uint32_t	 keywords;
+#define DESKTOP_HIDDEN		0x0001
+#define DESKTOP_SHOW		0x0002
+	uint32_t	 flags;
+};
+
+/* A catalog, mapped or being built. */
+struct desktop_cat {
+	struct desktop_dirrec	*dirs;
+	uint32_t		 ndirs, dirsize;
+	struct desktop_apprec	*apps;
+	uint32_t		 napps, appsize;
+	char			*strs;
+	uint32_t		 strslen, strsize;
+};
+
+static struct desktop_apprec *desktop_addapp(struct desktop_cat *);
+static uint32_t		 desktop_addstr(struct desktop_cat *, const char *);
+static void		 desktop_adddir(struct desktop_cat *, const char *,
+			     struct stat *);
+static int		 desktop_build(struct desktop_cat *,
+			     struct desktop_cat *);
+static int		 desktop_cmpid(const void *, const void *);
+static int		 desktop_cmpname(const void *, const void *);
+static void		 desktop_copydir(struct desktop_cat *,
+			     struct desktop_cat *, uint32_t);
+static void		 desktop_freecat(struct desktop_cat *);
+static int		 desktop_getfile(char *, size_t);
+static int		 desktop_map(const char *);
+static void		 desktop_parse(struct desktop_cat *, const char *,
+			     int, const char *);
+static void		 desktop_scandir(struct desktop_cat *, const char *,
+			     const char *, char **, int *);
+static void		 desktop_topdirs(char **, int *);
+static void		 desktop_unescape(char *, int);
+static void		 desktop_unmap(void);
+static int		 desktop_write(struct desktop_cat *, const char *);
+
+/* The catalog in use; mapped, or built here if it could not be saved. */
+static char			*desktop_map_addr;
+static size_t			 desktop_map_len;
+static struct desktop_cat	 desktop_own;
+static struct desktop_cat	 desktop_cur;
+static struct desktop_app	*desktop_apps;
+
+/* For the comparison functions. */
+static struct desktop_cat	*desktop_sortcat;
+
+/*
+ * Add a menu entry for every application, sorted by name.
+ */
+int
+desktop_fill(struct menu_q *menuq)
+{
+	struct desktop_cat	 new;
+	struct desktop_apprec	*ar;
+	struct desktop_app	*app;
+	char			 filename[MAXPATHLEN];
+	uint32_t		 i, n;
+
+	if (desktop_getfile(filename, sizeof(filename)) == -1)
+		return (-1);
+
+	if (desktop_map_addr == NULL)
+		(void)desktop_map(filename);
+
+	bzero(&new, sizeof(new));
+	if (desktop_build(&desktop_cur, &new) &&
+	    (desktop_write(&new, filename) == -1 ||
+	    desktop_map(filename) == -1)) {
+		desktop_unmap();
+		desktop_own = desktop_cur = new;
+	} else
+		desktop_freecat(&new);
+
+	for (i = n = 0; i < desktop_cur.napps; i++)
+		if (desktop_cur.apps[i].flags & DESKTOP_SHOW)
+			n++;
+
+	xfree(desktop_apps);
+	desktop_apps = xcalloc(MAX(n, 1), sizeof(*desktop_apps));
+
+	for (i = 0, app = desktop_apps; i < desktop_cur.napps; i++) {
+		ar = &desktop_cur.apps[i];
+		if ((ar->flags & DESKTOP_SHOW) == 0)
+			continue;
+		app->name = desktop_cur.strs + ar->name;
+		app->exec = desktop_cur.strs + ar->exec;
+		app->keywords = desktop_cur.strs + ar->keywords;
+
+		(void)menuq_add(menuq, app, "%s", app->name);
+		app++;
+	}
+
+	return (0);
+}
+
+static int
+desktop_getfile(char *buf, size_t len)
+{
+	char	*home;
+	int	 l;
+
+	if ((home = getenv("HOME")) == NULL)
+		return (-1);
+
+	l = snprintf(buf, len, "%s/%s", home, DESKTOPCACHEFILE);
+	if (l == -1 || l >= len)
+		return (-1);
+
+	return (0);
+}
+
+/*
+ * Map the catalog in filename, replacing the current one if it is
+ * sound.
+ */
+static int
+desktop_map(const char *filename)
+{
+	struct desktop_hdr	 hdr;
+	struct desktop_cat	 cat;
+	struct stat		 sb;
+	char			*addr;
+	size_t			 len;
+	uint32_t		 i;
+	int			 fd;
+
+	if ((fd = open(filename, O_RDONLY | O_CLOEXEC)) == -1)
+		return (-1);
+	if (fstat(fd, &sb) == -1 || sb.st_size < sizeof(hdr)) {
+		(void)close(fd);
+		return (-1);
+	}
+	len = sb.st_size;
+	addr = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+	(void)close(fd);
+	if (addr == MAP_FAILED)
+		return (-1);
+
+	(void)memcpy(&hdr, addr, sizeof(hdr));
+	if (memcmp(hdr.magic, DESKTOP_MAGIC, sizeof(hdr.magic)) != 0 ||
+	    hdr.ndirs > DESKTOP_MAXDIRS || hdr.strslen == 0 ||
+	    len != sizeof(hdr) + (size_t)hdr.ndirs * sizeof(*cat.dirs) +
+	    (size_t)hdr.napps * sizeof(*cat.apps) + hdr.strslen)
+		goto bad;
+
+	bzero(&cat, sizeof(cat));
+	cat.dirs = (struct desktop_dirrec *)(addr + sizeof(hdr));
+	cat.ndirs = hdr.ndirs;
+	cat.apps = (struct desktop_apprec *)(cat.dirs + cat.ndirs);
+	cat.napps = hdr.napps;
+	cat.strs = (char *)(cat.apps + cat.napps);
+	cat.strslen = hdr.strslen;
+
+	/* Don't trust anything in there. */
+	if (cat.strs[cat.strslen - 1] != '\0')
+		goto bad;
+	for (i = 0; i < cat.ndirs; i++)
+		if (cat.dirs[i].path >= cat.strslen)
+			goto bad;
+	for (i = 0; i < cat.napps; i++)
+		if (cat.apps[i].dir >= cat.ndirs ||
+		    cat.apps[i].id >= cat.strslen ||
+		    cat.apps[i].name >= cat.strslen ||
+		    cat.apps[i].exec >= cat.strslen ||
+		    cat.apps[i].keywords >= cat.strslen)
+			goto bad;
+
+	desktop_unmap();
+	desktop_map_addr = addr;
+	desktop_map_len = len;
+	desktop_cur = cat;
+
+	return (0);
+bad:
+	(void)munmap(addr, len);
+	return (-1);
+}
+
+static void
+desktop_unmap(void)
+{
+	if (desktop_map_addr != NULL)
+		(void)munmap(desktop_map_addr, desktop_map_len);
+	desktop_map_addr = NULL;
+	desktop_freecat(&desktop_own);
+	bzero(&desktop_cur, sizeof(desktop_cur));
+}
+
+/*
+ * Build a new catalog into new, taking what has not changed from old.
+ * Returns 1 if the new one differs.
+ */
+static int
+desktop_build(struct desktop_cat *old, struct desktop_cat *new)
+{
+	struct stat	 sb;
+	char		*tops[DESKTOP_MAXDIRS], *work[DESKTOP_MAXDIRS];
+	const char	*path;
+	uint32_t	 i, j, len;
+	int		 changed = 0, ntops, nwork, w, t;
+
+	ntops = 0;
+	desktop_topdirs(tops, &ntops);
+
+	for (t = 0; t < ntops; t++) {
+		nwork = 0;
+		work[nwork++] = xstrdup(tops[t]);
+
+		for (w = 0; w < nwork; w++) {
+			path = work[w];
+
+			/* Seen already, through another top directory. */
+			for (j = 0; j < new->ndirs; j++)
+				if (strcmp(new->strs + new->dirs[j].path,
+				    path) == 0)
+					break;
+			if (j < new->ndirs || new->ndirs >= DESKTOP_MAXDIRS)
+				continue;
+
+			if (stat(path, &sb) == -1 || !S_ISDIR(sb.st_mode))
+				continue;
+
+			for (i = 0; i < old->ndirs; i++)
+				if (strcmp(old->strs + old->dirs[i].path,
+				    path) == 0)
+					break;
+
+			if (i < old->ndirs && old->dirs[i].dev == sb.st_dev &&
+			    old->dirs[i].ino == sb.st_ino &&
+			    old->dirs[i].sec == sb.st_mtim.tv_sec &&
+			    old->dirs[i].nsec == sb.st_mtim.tv_nsec) {
+				desktop_copydir(old, new, i);
+				/* Its subdirectories are in there as well. */
+				len = strlen(path);
+				for (j = 0; j < old->ndirs; j++) {
+					const char *p = old->strs +
+					    old->dirs[j].path;
+
+					if (nwork < DESKTOP_MAXDIRS &&
+					    strncmp(p, path, len) == 0 &&
+					    p[len] == '/' &&
+					    strchr(p + len + 1, '/') == NULL)
+						work[nwork++] = xstrdup(p);
+				}
+			} else {
+				changed = 1;
+				desktop_adddir(new, path, &sb);
+				desktop_scandir(new, tops[t], path, work,
+				    &nwork);
+			}
+		}
+
+		for (w = 0; w < nwork; w++)
+			xfree(work[w]);
+	}
+
+	for (t = 0; t < ntops; t++)
+		xfree(tops[t]);
+
+	/* Directories that went away. */
+	if (new->ndirs != old->ndirs)
+		changed = 1;
+	if (!changed)
+		return (0);
+
+	/* The first of each desktop file id wins, in directory order. */
+	desktop_sortcat = new;
+	qsort(new->apps, new->napps, sizeof(*new->apps), desktop_cmpid);
+	for (i = 0; i < new->napps; i++) {
+		if (i > 0 && strcmp(new->strs + new->apps[i].id,
+		    new->strs + new->apps[i - 1].id) == 0)
+			continue;
+		if ((new->apps[i].flags & DESKTOP_HIDDEN) == 0)
+			new->apps[i].flags |= DESKTOP_SHOW;
+	}
+	qsort(new->apps, new->napps, sizeof(*new->apps), desktop_cmpname);
+
+	return (1);
+}
+
+/*
+ * $XDG_DATA_HOME and $XDG_DATA_DIRS, most important first.
+ */
+static void
+desktop_topdirs(char **tops, int *ntops)
+{
+	char	*dirs, *dirscpy, *dir, *home, buf[MAXPATHLEN];
+	int	 l;
+
+	if ((dir = getenv("XDG_DATA_HOME")) != NULL && *dir != '\0')
+		l = snprintf(buf, sizeof(buf), "%s/applications", dir);
+	else if ((home = getenv("HOME")) != NULL)
+		l = snprintf(buf, sizeof(buf), "%s/.local/share/applications",
+		    home);
+	else
+		l = -1;
+	if (l != -1 && l < sizeof(buf))
+		tops[(*ntops)++] = xstrdup(buf);
+
+	if ((dirs = getenv("XDG_DATA_DIRS")) == NULL || *dirs == '\0')
+		dirs = "/usr/local/share:/usr/share";
+	dirscpy = dirs = xstrdup(dirs);
+	while ((dir = strsep(&dirscpy, ":")) != NULL &&
+	    *ntops < DESKTOP_MAXDIRS) {
+		if (*dir == '\0')
+			continue;
+		l = snprintf(buf, sizeof(buf), "%s/applications", dir);
+		if (l != -1 && l < sizeof(buf))
+			tops[(*ntops)++] = xstrdup(buf);
+	}
+	xfree(dirs);
+}
+
+static void
+desktop_adddir(struct desktop_cat *cat, const char *path, struct stat *sb)
+{
+	struct desktop_dirrec	*dr;
+
+	if (cat->ndirs == cat->dirsize) {
+		cat->dirsize = MAX(cat->dirsize * 2, 16);
+		cat->dirs = xrealloc(cat->dirs,
+		    cat->dirsize * sizeof(*cat->dirs));
+	}
+	dr = &cat->dirs[cat->ndirs++];
+	bzero(dr, sizeof(*dr));
+	dr->dev = sb->st_dev;
+	dr->ino = sb->st_ino;
+	dr->sec = sb->st_mtim.tv_sec;
+	dr->nsec = sb->st_mtim.tv_nsec;
+	dr->path = desktop_addstr(cat, path);
+}
+
+static struct desktop_apprec *
+desktop_addapp(struct desktop_cat *cat)
+{
+	struct desktop_apprec	*ar;
+
+	if (cat->napps == cat->appsize) {
+		cat->appsize = MAX(cat->appsize * 2, 64);
+		cat->apps = xrealloc(cat->apps,
+		    cat->appsize * sizeof(*cat->apps));
+	}
+	ar = &cat->apps[cat->napps++];
+	bzero(ar, sizeof(*ar));
+	ar->dir = cat->ndirs - 1;
+
+	return (ar);
+}
+
+static uint32_t
+desktop_addstr(struct desktop_cat *cat, const char *s)
+{
+	uint32_t	 off;
+	size_t		 len = strlen(s) + 1;
+
+	if (cat->strslen + len > cat->strsize) {
+		cat->strsize = MAX(cat->strsize * 2, cat->strslen + len + 4096);
+		cat->strs = xrealloc(cat->strs, cat->strsize);
+	}
+	off = cat->strslen;
+	(void)memcpy(cat->strs + off, s, len);
+	cat->strslen += len;
+
+	return (off);
+}
+
+/* Carry directory i of old over to new, entries and all. */
+static void
+desktop_copydir(struct desktop_cat *old, struct desktop_cat *new,
+    uint32_t i)
+{
+	struct desktop_dirrec	*dr;
+	struct desktop_apprec	*oar, *ar;
+	uint32_t		 j;
+
+	dr = &old->dirs[i];
+	if (new->ndirs == new->dirsize) {
+		new->dirsize = MAX(new->dirsize * 2, 16);
+		new->dirs = xrealloc(new->dirs,
+		    new->dirsize * sizeof(*new->dirs));
+	}
+	new->dirs[new->ndirs] = *dr;
+	new->dirs[new->ndirs].path = desktop_addstr(new, old->strs + dr->path);
+	new->ndirs++;
+
+	for (j = 0; j < old->napps; j++) {
+		oar = &old->apps[j];
+		if (oar->dir != i)
+			continue;
+		ar = desktop_addapp(new);
+		ar->id = desktop_addstr(new, old->strs + oar->id);
+		ar->name = desktop_addstr(new, old->strs + oar->name);
+		ar->exec = desktop_addstr(new, old->strs + oar->exec);
+		ar->keywords = desktop_addstr(new, old->strs + oar->keywords);
+		ar->flags = oar->flags & DESKTOP_HIDDEN;
+	}
+}
+
+/*
+ * Read the .desktop files in path, and queue its subdirectories.
+ */
+static void
+desktop_scandir(struct desktop_cat *cat, const char *top, const char *path,
+    char **work, int *nwork)
+{
+	DIR		*dirp;
+	struct dirent	*dp;
+	struct stat	 sb;
+	char		 id[MAXPATHLEN], sub[MAXPATHLEN], *p;
+	size_t		 len, toplen = strlen(top);
+	int		 fd, isdir, l;
+
+	if ((fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1)
+		return;
+	if ((dirp = fdopendir(fd)) == NULL) {
+		(void)close(fd);
+		return;
+	}
+
+	while ((dp = readdir(dirp)) != NULL) {
+		if (dp->d_name[0] == '.')
+			continue;
+
+		/* Symlinked directories are not followed, no loops. */
+		isdir = 0;
+		if (dp->d_type == DT_DIR)
+			isdir = 1;
+		else if (dp->d_type == DT_UNKNOWN &&
+		    fstatat(fd, dp->d_name, &sb, AT_SYMLINK_NOFOLLOW) == 0)
+			isdir = S_ISDIR(sb.st_mode);
+		if (isdir) {
+			l = snprintf(sub, sizeof(sub), "%s/%s", path,
+			    dp->d_name);
+			if (l != -1 && l < sizeof(sub) &&
+			    *nwork < DESKTOP_MAXDIRS)
+				work[(*nwork)++] = xstrdup(sub);
+			continue;
+		}
+
+		len = strlen(dp->d_name);
+		if (len <= 8 || strcmp(dp->d_name + len - 8, ".desktop") != 0)
+			continue;
+
+		/* The id is the path below the top directory, with '-'. */
+		l = snprintf(id, sizeof(id), "%s%s%s",
+		    path[toplen] == '/' ? path + toplen + 1 : "",
+		    path[toplen] == '/' ? "/" : "", dp->d_name);
+		if (l == -1 || l >= sizeof(id))
+			continue;
+		for (p = id; *p != '\0'; p++)
+			if (*p == '/')
+				*p = '-';
+
+		desktop_parse(cat, id, fd, dp->d_name);
+	}
+	(void)closedir(dirp);
+}
+
+/*
+ * Pick Name, Exec and Keywords out of the [Desktop Entry] group.
+ */
+static void
+desktop_parse(struct desktop_cat *cat, const char *id, int dirfd,
+    const char *file)
+{
+	struct desktop_apprec	*ar;
+	char			*buf, *p, *eol, *key, *val, *end;
+	char			*name = NULL, *exec = NULL, *keywords = NULL;
+	ssize_t			 n;
+	int			 fd, ingroup = 0, hidden = 0, isapp = 0;
+
+	if ((fd = openat(dirfd, file, O_RDONLY | O_CLOEXEC)) == -1)
+		return;
+	buf = xmalloc(DESKTOP_MAXFILE + 1);
+	n = read(fd, buf, DESKTOP_MAXFILE);
+	(void)close(fd);
+	if (n <= 0) {
+		xfree(buf);
+		return;
+	}
+	buf[n] = '\0';
+
+	for (p = buf; p < buf + n; p = eol + 1) {
+		if ((eol = strchr(p, '\n')) == NULL)
+			eol = buf + n;
+		*eol = '\0';
+		if (eol > p && eol[-1] == '\r')
+			eol[-1] = '\0';
+
+		if (*p == '[') {
+			ingroup = (strcmp(p, "[Desktop Entry]") == 0);
+			continue;
+		}
+		if (!ingroup || *p == '#' || (val = strchr(p, '=')) == NULL)
+			continue;
+
+		/* Trim around the '='; localized keys are left alone. */
+		key = p;
+		for (end = val; end > key && (end[-1] == ' ' ||
+		    end[-1] == '\t'); end--)
+			;
+		*end = '\0';
+		for (val++; *val == ' ' || *val == '\t'; val++)
+			;
+
+		if (strcmp(key, "Name") == 0)
+			name = val;
+		else if (strcmp(key, "Exec") == 0)
+			exec = val;
+		else if (strcmp(key, "Keywords") == 0)
+			keywords = val;
+		else if (strcmp(key, "Type") == 0)
+			isapp = (strcmp(val, "Application") == 0);
+		else if ((strcmp(key, "NoDisplay") == 0 ||
+		    strcmp(key, "Hidden") == 0) && strcmp(val, "true") == 0)
+			hidden = 1;
+	}
+
+	if (!isapp || name == NULL || exec == NULL ||
+	    *name == '\0' || *exec == '\0')
+		hidden = 1;
+
+	if (name != NULL)
+		desktop_unescape(name, 0);
+	if (exec != NULL)
+		desktop_unescape(exec, 1);
+	if (keywords != NULL)
+		desktop_unescape(keywords, 0);
+
+	ar = desktop_addapp(cat);
+	ar->id = desktop_addstr(cat, id);
+	ar->name = desktop_addstr(cat, name != NULL ? name : "");
+	ar->exec = desktop_addstr(cat, exec != NULL ? exec : "");
+	ar->keywords = desktop_addstr(cat, keywords != NULL ? keywords : "");
+	ar->flags = hidden ? DESKTOP_HIDDEN : 0;
+
+	xfree(buf);
+}
+
+/*
+ * Undo string escapes in place; for Exec also drop the field codes,
+ * there being no files or URLs to pass.
+ */
+static void
+desktop_unescape(char *s, int exec)
+{
+	char	*d = s;
+
+	for (; *s != '\0'; s++) {
+		if (*s == '\\' && s[1] != '\0') {
+			switch (*++s) {
+			case 's':
+			case 'n':
+			case 't':
+			case 'r':
+				*d++ = ' ';
+				break;
+			default:
+				*d++ = *s;
+				break;
+			}
+		} else if (exec && *s == '%' && s[1] != '\0') {
+			if (*++s == '%')
+				*d++ = '%';
+		} else
+			*d++ = *s;
+	}
+	*d = '\0';
+}
+
+static int
+desktop_write(struct desktop_cat *cat, const char *filename)
+{
+	struct desktop_hdr	 hdr;
+	FILE			*fp;
+	char			 tmpname[MAXPATHLEN];
+	int			 fd, l;
+
+	l = snprintf(tmpname, sizeof(tmpname), "%s.XXXXXXXXXX", filename);
+	if (l == -1 || l >= sizeof(tmpname))
+		return (-1);
+	if ((fd = mkstemp(tmpname)) == -1) {
+		warn("%s", tmpname);
+		return (-1);
+	}
+	if ((fp = fdopen(fd, "w")) == NULL) {
+		warn("%s", tmpname);
+		(void)close(fd);
+		(void)unlink(tmpname);
+		return (-1);
+	}
+
+	/* Never empty, so the catalog always has a string table. */
+	if (cat->strslen == 0)
+		(void)desktop_addstr(cat, "");
+
+	bzero(&hdr, sizeof(hdr));
+	(void)memcpy(hdr.magic, DESKTOP_MAGIC, sizeof(hdr.magic));
+	hdr.ndirs = cat->ndirs;
+	hdr.napps = cat->napps;
+	hdr.strslen = cat->strslen;
+
+	(void)fwrite(&hdr, sizeof(hdr), 1, fp);
+	if (cat->ndirs > 0)
+		(void)fwrite(cat->dirs, sizeof(*cat->dirs), cat->ndirs, fp);
+	if (cat->napps > 0)
+		(void)fwrite(cat->apps, sizeof(*cat->apps), cat->napps, fp);
+	(void)fwrite(cat->strs, 1, cat->strslen, fp);
+
+	if (fclose(fp) == EOF || rename(tmpname, filename) == -1) {
+		warn("%s", filename);
+		(void)unlink(tmpname);
+		return (-1);
+	}
+
+	return (0);
+}
+
+static void
+desktop_freecat(struct desktop_cat *cat)
+{
+	xfree(cat->dirs);
+	xfree(cat->apps);
+	xfree(cat->strs);
+	bzero(cat, sizeof(*cat));
+}
+
+/* By id, then by directory so the more important one comes first. */
+static int
+desktop_cmpid(const void *a, const void *b)
+{
+	const struct desktop_apprec	*aa = a, *ab = b;
+	int				 r;
+
+	if ((r = strcmp(desktop_sortcat->strs + aa->id,
+	    desktop_sortcat->strs + ab->id)) != 0)
+		return (r);
+	return (aa->dir < ab->dir ? -1 : aa->dir > ab->dir);
+}
+
+/* Same order as search_sort(). */
+static int
+desktop_cmpname(const void *a, const void *b)
+{
+	const struct desktop_apprec	*aa = a, *ab = b;
+	const char			*na, *nb;
+	int				 r;
+
+	na = desktop_sortcat->strs + aa->name;
+	nb = desktop_sortcat->strs + ab->name;
+	if ((r = strcasecmp(na, nb)) != 0)
+		return (r);
+	return (strcmp(na, nb));
+}
@@ -65,6 +65,7 @@ group_add(struct group_ctx *gc, struct client_ctx *cc)
 
 	TAILQ_INSERT_TAIL(&gc->clients, cc, group_entry);
 	cc->group = gc;
+	ctl_event_client(CTL_EV_CLIENTGROUP, cc);
 }
 
 static void
@@ -80,13 +81,17 @@ group_remove(struct client_ctx *cc)
 
 	TAILQ_REMOVE(&cc->group->clients, cc, group_entry);
 	cc->group = NULL;
+	ctl_event_client(CTL_EV_CLIENTGROUP, cc);
 }
 
 static void
 group_hide(struct screen_ctx *sc, struct group_ctx *gc)
 {
 	struct client_ctx	*cc;
+	struct trace_span	 ts;
 
+	trace_begin(&ts, "group_hide", gc->shortcut);
+	xop_begin(XOP_GROUP_HIDE);
 	screen_updatestackingorder(sc);
 
 	gc->nhidden = 0;
@@ -94,10 +99,13 @@ group_hide(struct screen_ctx *sc, struct group_ctx *gc)
 	TAILQ_FOREACH(cc, &gc->clients, group_entry) {
 		client_hide(cc);
 		gc->nhidden++;
-		if (cc->stackingorder > gc->highstack)
-			gc->highstack = cc->stackingorder;
+		if (cc->cold->stackingorder > gc->highstack)
+			gc->highstack = cc->cold->stackingorder;
 	}
 	gc->hidden = 1;		/* XXX: equivalent to gc->nhidden > 0 */
+	xop_end(XOP_GROUP_HIDE);
+	ctl_event_group(sc, gc);
+	trace_end(&ts);
 }
 
 static void
@@ -105,13 +113,16 @@ group_show(struct screen_ctx *sc, struct group_ctx *gc)
 {
 	struct client_ctx	*cc;
 	Window			*winlist;
+	struct trace_span	 ts;
 	u_int			 i;
 	int			 lastempty = -1;
 
+	trace_begin(&ts, "group_show", gc->shortcut);
+	xop_begin(XOP_GROUP_SHOW);
 	gc->highstack = 0;
 	TAILQ_FOREACH(cc, &gc->clients, group_entry) {
-		if (cc->stackingorder > gc->highstack)
-			gc->highstack = cc->stackingorder;
+		if (cc->cold->stackingorder > gc->highstack)
+			gc->highstack = cc->cold->stackingorder;
 	}
 	winlist = (Window *) xcalloc(sizeof(*winlist), (gc->highstack + 1));
 
@@ -120,7 +131,7 @@ group_show(struct screen_ctx *sc, struct group_ctx *gc)
 	 * top-to-bottom.
 	 */
 	TAILQ_FOREACH(cc, &gc->clients, group_entry) {
-		winlist[gc->highstack - cc->stackingorder] = cc->win;
+		winlist[gc->highstack - cc->cold->stackingorder] = cc->win;
 		client_unhide(cc);
 	}
 
@@ -140,6 +151,9 @@ group_show(struct screen_ctx *sc, struct group_ctx *gc)
 
 	gc->hidden = 0;
 	group_setactive(sc, gc->shortcut - 1);
+	xop_end(XOP_GROUP_SHOW);
+	ctl_event_group(sc, gc);
+	trace_end(&ts);
 }
 
 void
@@ -193,11 +207,11 @@ group_make_autogroup(struct conf *conf, char *val, int no)
 
 	if ((p = strchr(val, ',')) == NULL) {
 		aw->name = NULL;
-		aw->class = xstrdup(val);
+		aw->class = intern_get(val);
 	} else {
 		*(p++) = '\0';
-		aw->name = xstrdup(val);
-		aw->class = xstrdup(p);
+		aw->name = intern_get(val);
+		aw->class = intern_get(p);
 	}
 	aw->num = no;
 
@@ -242,10 +256,10 @@ group_sticky_toggle_enter(struct client_ctx *cc)
 
 	if (gc == cc->group) {
 		group_remove(cc);
-		cc->highlight = CLIENT_HIGHLIGHT_UNGROUP;
+		cc->cold->highlight = CLIENT_HIGHLIGHT_UNGROUP;
 	} else {
 		group_add(gc, cc);
-		cc->highlight = CLIENT_HIGHLIGHT_GROUP;
+		cc->cold->highlight = CLIENT_HIGHLIGHT_GROUP;
 	}
 
 	client_draw_border(cc);
@@ -254,7 +268,7 @@ group_sticky_toggle_enter(struct client_ctx *cc)
 void
 group_sticky_toggle_exit(struct client_ctx *cc)
 {
-	cc->highlight = 0;
+	cc->cold->highlight = 0;
 	client_draw_border(cc);
 }
 
@@ -371,7 +385,7 @@ group_menu(XButtonEvent *e)
 	int			 i;
 
 	sc = screen_fromroot(e->root);
-	TAILQ_INIT(&menuq);
+	menuq_init(&menuq);
 
 	for (i = 0; i < CALMWM_NGROUPS; i++) {
 		gc = &sc->groups[i];
@@ -379,15 +393,12 @@ group_menu(XButtonEvent *e)
 		if (TAILQ_EMPTY(&gc->clients))
 			continue;
 
-		mi = xcalloc(1, sizeof(*mi));
 		if (gc->hidden)
-			(void)snprintf(mi->text, sizeof(mi->text), "%d: [%s]",
+			(void)menuq_add(&menuq, gc, "%d: [%s]",
 			    gc->shortcut, sc->group_names[i]);
 		else
-			(void)snprintf(mi->text, sizeof(mi->text), "%d: %s",
+			(void)menuq_add(&menuq, gc, "%d: %s",
 			    gc->shortcut, sc->group_names[i]);
-		mi->ctx = gc;
-		TAILQ_INSERT_TAIL(&menuq, mi, entry);
 	}
 
 	if (TAILQ_EMPTY(&menuq))
@@ -403,10 +414,7 @@ group_menu(XButtonEvent *e)
 	(gc->hidden) ? group_show(sc, gc) : group_hide(sc, gc);
 
 cleanup:
-	while ((mi = TAILQ_FIRST(&menuq)) != NULL) {
-		TAILQ_REMOVE(&menuq, mi, entry);
-		xfree(mi);
-	}
+	menuq_clear(&menuq);
 }
 
 void
@@ -433,7 +441,7 @@ group_autogroup(struct client_ctx *cc)
 	int			 no = -1;
 	long			*grpno;
 
-	if (cc->app_class == NULL || cc->app_name == NULL)
+	if (cc->cold->app_class == NULL || cc->cold->app_name == NULL)
 		return;
 
 	if (xu_getprop(cc->win, _NET_WM_DESKTOP, XA_CARDINAL,
@@ -446,10 +454,11 @@ group_autogroup(struct client_ctx *cc)
 			no = *grpno + 1;
 		XFree(grpno);
 	} else {
+		/* Both sides are interned. */
 		TAILQ_FOREACH(aw, &Conf.autogroupq, entry) {
-			if (strcmp(aw->class, cc->app_class) == 0 &&
+			if (aw->class == cc->cold->app_class &&
 			    (aw->name == NULL ||
-			    strcmp(aw->name, cc->app_name) == 0)) {
+			    aw->name == cc->cold->app_name)) {
 				no = aw->num;
 				break;
 			}
@@ -514,6 +523,8 @@ group_update_names(struct screen_ctx *sc)
 
 	if (prop_ret != NULL)
 		XFree(prop_ret);
+	for (i = 0; i < sc->group_nonames; i++)
+		xfree(sc->group_names[i]);
 	if (sc->group_nonames != 0)
 		xfree(sc->group_names);
 
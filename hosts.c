@@ -0,0 +1,301 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Copyright (c) 2004 Martin Murray <mmurray@monkey.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Hosts for the ssh menu: the first name on each line of known_hosts,
+ * and the Host aliases from the ssh client configuration.  The files
+ * are mapped and parsed in place into a sorted index without
+ * duplicates, which is kept until one of them changes.
+ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "calmwm.h"
+
+#define KNOWN_HOSTS	".ssh/known_hosts"
+#define SSH_CONFIG	".ssh/config"
+#define HASH_MARKER	"|1|"
+
+struct hosts_file {
+	const char	*name;
+	void		 (*parse)(const char *, const char *);
+	int		 present;
+	dev_t		 dev;
+	ino_t		 ino;
+	off_t		 size;
+	struct timespec	 mtime;
+};
+
+static void		 hosts_add(const char *, size_t);
+static int		 hosts_cmp(const void *, const void *);
+static int		 hosts_changed(const char *);
+static void		 hosts_parse_config(const char *, const char *);
+static void		 hosts_parse_known(const char *, const char *);
+static void		 hosts_read(const char *, struct hosts_file *);
+static void		 hosts_rebuild(const char *);
+
+static struct hosts_file hosts_files[] = {
+	{ KNOWN_HOSTS,	hosts_parse_known },
+	{ SSH_CONFIG,	hosts_parse_config },
+};
+
+/* Names are kept NUL separated in one buffer; index points into it. */
+static char		*hosts_buf;
+static size_t		 hosts_buflen, hosts_bufsize;
+static char		**hosts_index;
+static size_t		 hosts_n;
+static int		 hosts_valid;
+
+/*
+ * Add a menu entry for every known host, in search_sort() order.
+ * Returns -1 if there are no files to read hosts from.
+ */
+int
+hosts_fill(struct menu_q *menuq)
+{
+	struct menu	*mi;
+	char		*home;
+	size_t		 i;
+	int		 present = 0;
+
+	if ((home = getenv("HOME")) == NULL)
+		return (-1);
+
+	if (!hosts_valid || hosts_changed(home))
+		hosts_rebuild(home);
+
+	for (i = 0; i < nitems(hosts_files); i++)
+		present |= hosts_files[i].present;
+	if (!present)
+		return (-1);
+
+	for (i = 0; i < hosts_n; i++) {
+		mi = menuq_entry(menuq, NULL, hosts_index[i]);
+		TAILQ_INSERT_TAIL(menuq, mi, entry);
+	}
+
+	return (0);
+}
+
+static int
+hosts_changed(const char *home)
+{
+	struct hosts_file	*hf;
+	struct stat		 sb;
+	char			 filename[MAXPATHLEN];
+	size_t			 i;
+	int			 l;
+
+	for (i = 0; i < nitems(hosts_files); i++) {
+		hf = &hosts_files[i];
+		l = snprintf(filename, sizeof(filename), "%s/%s", home,
+		    hf->name);
+		if (l == -1 || l >= sizeof(filename))
+			continue;
+		if (stat(filename, &sb) == -1) {
+			if (hf->present)
+				return (1);
+			continue;
+		}
+		if (!hf->present || hf->dev != sb.st_dev ||
+		    hf->ino != sb.st_ino || hf->size != sb.st_size ||
+		    hf->mtime.tv_sec != sb.st_mtim.tv_sec ||
+		    hf->mtime.tv_nsec != sb.st_mtim.tv_nsec)
+			return (1);
+	}
+
+	return (0);
+}
+
+static void
+hosts_rebuild(const char *home)
+{
+	char		*p, *end;
+	size_t		 i, j, n;
+
+	hosts_buflen = 0;
+	for (i = 0; i < nitems(hosts_files); i++)
+		hosts_read(home, &hosts_files[i]);
+
+	/* The buffer may have moved while growing; index it now. */
+	for (n = 0, p = hosts_buf, end = p + hosts_buflen; p < end;
+	    p += strlen(p) + 1)
+		n++;
+	xfree(hosts_index);
+	hosts_index = xcalloc(MAX(n, 1), sizeof(*hosts_index));
+	for (n = 0, p = hosts_buf; p < end; p += strlen(p) + 1)
+		hosts_index[n++] = p;
+
+	qsort(hosts_index, n, sizeof(*hosts_index), hosts_cmp);
+	for (i = j = 0; i < n; i++)
+		if (j == 0 || strcmp(hosts_index[j - 1], hosts_index[i]) != 0)
+			hosts_index[j++] = hosts_index[i];
+	hosts_n = j;
+	hosts_valid = 1;
+}
+
+static void
+hosts_read(const char *home, struct hosts_file *hf)
+{
+	struct stat	 sb;
+	char		 filename[MAXPATHLEN];
+	char		*map;
+	int		 fd, l;
+
+	hf->present = 0;
+
+	l = snprintf(filename, sizeof(filename), "%s/%s", home, hf->name);
+	if (l == -1 || l >= sizeof(filename))
+		return;
+	if ((fd = open(filename, O_RDONLY | O_CLOEXEC)) == -1)
+		return;
+	if (fstat(fd, &sb) == -1) {
+		(void)close(fd);
+		return;
+	}
+
+	hf->present = 1;
+	hf->dev = sb.st_dev;
+	hf->ino = sb.st_ino;
+	hf->size = sb.st_size;
+	hf->mtime = sb.st_mtim;
+
+	if (sb.st_size > 0) {
+		map = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map == MAP_FAILED)
+			warn("%s", filename);
+		else {
+			(*hf->parse)(map, map + sb.st_size);
+			(void)munmap(map, sb.st_size);
+		}
+	}
+	(void)close(fd);
+}
+
+/*
+ * known_hosts: the first name of each line, skipping hashed names,
+ * comments and revoked keys.
+ */
+static void
+hosts_parse_known(const char *p, const char *end)
+{
+	const char	*eol, *s;
+
+	for (; p < end; p = eol + 1) {
+		if ((eol = memchr(p, '\n', end - p)) == NULL)
+			eol = end;
+
+		while (p < eol && (*p == ' ' || *p == '\t'))
+			p++;
+		if (p == eol || *p == '#')
+			continue;
+		if (*p == '@') {
+			if (eol - p >= 9 && strncmp(p, "@revoked", 8) == 0)
+				continue;
+			/* other markers: skip to the host names */
+			while (p < eol && *p != ' ' && *p != '\t')
+				p++;
+			while (p < eol && (*p == ' ' || *p == '\t'))
+				p++;
+		}
+		if ((size_t)(eol - p) >= strlen(HASH_MARKER) &&
+		    strncmp(p, HASH_MARKER, strlen(HASH_MARKER)) == 0)
+			continue;
+
+		for (s = p; p < eol && *p != ',' && *p != ' ' && *p != '\t';
+		    p++)
+			;
+		hosts_add(s, p - s);
+	}
+}
+
+/*
+ * ssh_config: every Host pattern that names a single host.
+ */
+static void
+hosts_parse_config(const char *p, const char *end)
+{
+	const char	*eol, *s;
+
+	for (; p < end; p = eol + 1) {
+		if ((eol = memchr(p, '\n', end - p)) == NULL)
+			eol = end;
+
+		while (p < eol && (*p == ' ' || *p == '\t'))
+			p++;
+		if (eol - p < 5 || strncasecmp(p, "host", 4) != 0 ||
+		    (p[4] != ' ' && p[4] != '\t' && p[4] != '='))
+			continue;
+		p += 5;
+
+		while (p < eol) {
+			while (p < eol && (*p == ' ' || *p == '\t' ||
+			    *p == '=' || *p == '\r'))
+				p++;
+			if (p < eol && *p == '#')
+				break;
+			for (s = p; p < eol && *p != ' ' && *p != '\t' &&
+			    *p != '\r'; p++)
+				;
+			if (p > s && *s != '!' &&
+			    memchr(s, '*', p - s) == NULL &&
+			    memchr(s, '?', p - s) == NULL)
+				hosts_add(s, p - s);
+		}
+	}
+}
+
+static void
+hosts_add(const char *s, size_t len)
+{
+	if (len == 0 || len >= MAXHOSTNAMELEN || memchr(s, '\0', len) != NULL)
+		return;
+
+	if (hosts_buflen + len + 1 > hosts_bufsize) {
+		hosts_bufsize = MAX(hosts_bufsize * 2, 64 * 1024);
+		hosts_buf = xrealloc(hosts_buf, hosts_bufsize);
+	}
+	(void)memcpy(hosts_buf + hosts_buflen, s, len);
+	hosts_buf[hosts_buflen + len] = '\0';
+	hosts_buflen += len + 1;
+}
+
+/* Same order as search_sort(). */
+static int
+hosts_cmp(const void *a, const void *b)
+{
+	const char	*sa = *(const char **)a;
+	const char	*sb = *(const char **)b;
+	int		 r;
+
+	if ((r = strcasecmp(sa, sb)) != 0)
+		return (r);
+	return (strcmp(sa, sb));
+}
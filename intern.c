@@ -0,0 +1,198 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Copyright (c) 2004 Martin Murray <mmurray@monkey.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Interned strings.  Window classes, instances and titles repeat a lot
+ * across clients, so each distinct string is kept once, with a count
+ * of its users; two interned strings are equal if and only if they are
+ * the same pointer.  Short strings are kept in pools by size, so that
+ * strings coming and going, like titles, do not malloc.
+ */
+
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "calmwm.h"
+
+#define INTERN_MINBUCKETS	256
+
+struct intern {
+	struct intern		*next;
+	u_int			 hash;
+	u_int			 refs;
+	size_t			 len;
+	char			 str[1];
+};
+
+#define INTERN_SIZE(_len)	(offsetof(struct intern, str) + (_len) + 1)
+#define INTERN_HDR(_s)		\
+	((struct intern *)((_s) - offsetof(struct intern, str)))
+
+static struct intern	*intern_alloc(size_t);
+static void		 intern_grow(void);
+static u_int		 intern_hash(const char *, size_t);
+
+/* Size classes; anything longer comes from malloc. */
+static struct pool	 intern_pools[] = {
+	POOL_INITIALIZER("intern32", 32),
+	POOL_INITIALIZER("intern64", 64),
+	POOL_INITIALIZER("intern128", 128),
+	POOL_INITIALIZER("intern256", 256),
+	POOL_INITIALIZER("intern512", 512),
+};
+
+static struct intern	**intern_tab;
+static u_int		 intern_nbuckets;
+static u_int		 intern_n;
+
+/*
+ * Return the interned copy of s, with one more reference.
+ */
+char *
+intern_get(const char *s)
+{
+	struct intern	*in;
+	size_t		 len;
+	u_int		 h, b;
+
+	len = strlen(s);
+	h = intern_hash(s, len);
+
+	if (intern_tab != NULL) {
+		b = h & (intern_nbuckets - 1);
+		for (in = intern_tab[b]; in != NULL; in = in->next)
+			if (in->hash == h && in->len == len &&
+			    memcmp(in->str, s, len) == 0) {
+				in->refs++;
+				return (in->str);
+			}
+	}
+
+	if (intern_n >= intern_nbuckets)
+		intern_grow();
+
+	in = intern_alloc(len);
+	in->hash = h;
+	in->refs = 1;
+	in->len = len;
+	(void)memcpy(in->str, s, len + 1);
+
+	b = h & (intern_nbuckets - 1);
+	in->next = intern_tab[b];
+	intern_tab[b] = in;
+	intern_n++;
+
+	return (in->str);
+}
+
+void
+intern_put(char *s)
+{
+	struct intern	 *in = INTERN_HDR(s), **inp;
+	size_t		  i, size;
+
+	if (--in->refs > 0)
+		return;
+
+	for (inp = &intern_tab[in->hash & (intern_nbuckets - 1)];
+	    *inp != in; inp = &(*inp)->next)
+		;
+	*inp = in->next;
+	intern_n--;
+
+	size = INTERN_SIZE(in->len);
+	for (i = 0; i < nitems(intern_pools); i++)
+		if (size <= intern_pools[i].size) {
+			pool_put(&intern_pools[i], in);
+			return;
+		}
+	xfree(in);
+}
+
+void
+intern_dump(int fd)
+{
+	struct intern	*in;
+	size_t		 bytes = 0;
+	u_long		 refs = 0;
+	u_int		 i, chain, maxchain = 0;
+
+	for (i = 0; i < intern_nbuckets; i++) {
+		chain = 0;
+		for (in = intern_tab[i]; in != NULL; in = in->next) {
+			bytes += in->len + 1;
+			refs += in->refs;
+			chain++;
+		}
+		maxchain = MAX(maxchain, chain);
+	}
+	dprintf(fd, "intern: %u strings, %zu bytes, %lu refs, "
+	    "%u buckets, longest chain %u\n", intern_n, bytes, refs,
+	    intern_nbuckets, maxchain);
+}
+
+static struct intern *
+intern_alloc(size_t len)
+{
+	size_t	 i, size;
+
+	size = INTERN_SIZE(len);
+	for (i = 0; i < nitems(intern_pools); i++)
+		if (size <= intern_pools[i].size)
+			return (pool_get(&intern_pools[i]));
+	return (xmalloc(size));
+}
+
+/* Keep chains short: as many buckets as strings, doubling as needed. */
+static void
+intern_grow(void)
+{
+	struct intern	**tab, *in, *next;
+	u_int		  i, n, b;
+
+	n = MAX(intern_nbuckets * 2, INTERN_MINBUCKETS);
+	tab = xcalloc(n, sizeof(*tab));
+	for (i = 0; i < intern_nbuckets; i++)
+		for (in = intern_tab[i]; in != NULL; in = next) {
+			next = in->next;
+			b = in->hash & (n - 1);
+			in->next = tab[b];
+			tab[b] = in;
+		}
+	xfree(intern_tab);
+	intern_tab = tab;
+	intern_nbuckets = n;
+}
+
+/* FNV-1a */
+static u_int
+intern_hash(const char *s, size_t len)
+{
+	u_int	 h = 2166136261U;
+
+	while (len-- > 0) {
+		h ^= (u_char)*s++;
+		h *= 16777619U;
+	}
+	return (h);
+}
@@ -23,10 +23,8 @@
 #include <sys/param.h>
 #include <sys/queue.h>
 
-#include <dirent.h>
 #include <err.h>
 #include <errno.h>
-#include <paths.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -34,9 +32,6 @@
 
 #include "calmwm.h"
 
-#define KNOWN_HOSTS	".ssh/known_hosts"
-#define HASH_MARKER	"|1|"
-
 extern sig_atomic_t	xev_quit;
 
 void
@@ -107,8 +102,8 @@ kbfunc_moveresize(struct client_ctx *cc, union arg *arg)
 
 		client_move(cc);
 		xu_ptr_getpos(cc->win, &x, &y);
-		cc->ptr.y = y + my;
-		cc->ptr.x = x + mx;
+		cc->cold->ptr.y = y + my;
+		cc->cold->ptr.x = x + mx;
 		client_ptrwarp(cc);
 		break;
 	case CWM_RESIZE:
@@ -134,11 +129,11 @@ kbfunc_moveresize(struct client_ctx *cc, union arg *arg)
 		client_resize(cc);
 
 		/* Make sure the pointer stays within the window. */
-		xu_ptr_getpos(cc->win, &cc->ptr.x, &cc->ptr.y);
-		if (cc->ptr.x > cc->geom.width)
-			cc->ptr.x = cc->geom.width - cc->bwidth;
-		if (cc->ptr.y > cc->geom.height)
-			cc->ptr.y = cc->geom.height - cc->bwidth;
+		xu_ptr_getpos(cc->win, &cc->cold->ptr.x, &cc->cold->ptr.y);
+		if (cc->cold->ptr.x > cc->geom.width)
+			cc->cold->ptr.x = cc->geom.width - cc->bwidth;
+		if (cc->cold->ptr.y > cc->geom.height)
+			cc->cold->ptr.y = cc->geom.height - cc->bwidth;
 		client_ptrwarp(cc);
 		break;
 	case CWM_PTRMOVE:
@@ -177,14 +172,10 @@ kbfunc_client_search(struct client_ctx *cc, union arg *arg)
 	sc = cc->sc;
 	old_cc = client_current();
 
-	TAILQ_INIT(&menuq);
+	menuq_init(&menuq);
 
-	TAILQ_FOREACH(cc, &Clientq, entry) {
-		mi = xcalloc(1, sizeof(*mi));
-		(void)strlcpy(mi->text, cc->name, sizeof(mi->text));
-		mi->ctx = cc;
-		TAILQ_INSERT_TAIL(&menuq, mi, entry);
-	}
+	TAILQ_FOREACH(cc, &Clientq, entry)
+		(void)menuq_add(&menuq, cc, "%s", cc->name);
 
 	if ((mi = menu_filter(sc, &menuq, "window", NULL, 0,
 	    search_match_client, search_print_client)) != NULL) {
@@ -197,10 +188,7 @@ kbfunc_client_search(struct client_ctx *cc, union arg *arg)
 		client_ptrwarp(cc);
 	}
 
-	while ((mi = TAILQ_FIRST(&menuq)) != NULL) {
-		TAILQ_REMOVE(&menuq, mi, entry);
-		xfree(mi);
-	}
+	menuq_clear(&menuq);
 }
 
 void
@@ -212,23 +200,41 @@ kbfunc_menu_search(struct client_ctx *cc, union arg *arg)
 	struct menu_q		 menuq;
 
 	sc = cc->sc;
-	TAILQ_INIT(&menuq);
+	menuq_init(&menuq);
 
-	TAILQ_FOREACH(cmd, &Conf.cmdq, entry) {
-		mi = xcalloc(1, sizeof(*mi));
-		(void)strlcpy(mi->text, cmd->label, sizeof(mi->text));
-		mi->ctx = cmd;
-		TAILQ_INSERT_TAIL(&menuq, mi, entry);
-	}
+	TAILQ_FOREACH(cmd, &Conf.cmdq, entry)
+		(void)menuq_add(&menuq, cmd, "%s", cmd->label);
 
 	if ((mi = menu_filter(sc, &menuq, "application", NULL, 0,
 	    search_match_text, NULL)) != NULL)
 		u_spawn(((struct cmd *)mi->ctx)->image);
 
-	while ((mi = TAILQ_FIRST(&menuq)) != NULL) {
-		TAILQ_REMOVE(&menuq, mi, entry);
-		xfree(mi);
+	menuq_clear(&menuq);
+}
+
+void
+kbfunc_app_search(struct client_ctx *cc, union arg *arg)
+{
+	struct screen_ctx	*sc;
+	struct menu		*mi;
+	struct menu_q		 menuq;
+	char			*exec;
+
+	sc = cc->sc;
+	menuq_init(&menuq);
+
+	if (desktop_fill(&menuq) == -1)
+		return;
+
+	if ((mi = menu_filter(sc, &menuq, "app", NULL, 0,
+	    search_match_app, NULL)) != NULL) {
+		/* u_spawn() takes the string apart */
+		exec = xstrdup(((struct desktop_app *)mi->ctx)->exec);
+		u_spawn(exec);
+		xfree(exec);
 	}
+
+	menuq_clear(&menuq);
 }
 
 void
@@ -238,11 +244,13 @@ kbfunc_client_cycle(struct client_ctx *cc, union arg *arg)
 
 	sc = cc->sc;
 
+	xop_begin(XOP_CLIENT_CYCLE);
 	/* XXX for X apps that ignore events */
 	XGrabKeyboard(X_Dpy, sc->rootwin, True,
 	    GrabModeAsync, GrabModeAsync, CurrentTime);
 
 	client_cycle(sc, arg->i);
+	xop_end(XOP_CLIENT_CYCLE);
 }
 
 void
@@ -272,15 +280,14 @@ kbfunc_lock(struct client_ctx *cc, union arg *arg)
 void
 kbfunc_exec(struct client_ctx *cc, union arg *arg)
 {
-#define NPATHS 256
 	struct screen_ctx	*sc;
-	char			**ap, *paths[NPATHS], *path, *pathcpy, *label;
-	char			 tpath[MAXPATHLEN];
-	DIR			*dirp;
-	struct dirent		*dp;
+	char			*label;
 	struct menu		*mi;
 	struct menu_q		 menuq;
-	int			 l, i, j, cmd = arg->i;
+	struct menu_feed	 feeds[2];
+	struct trace_span	 ts;
+	char			 path[MAXPATHLEN];
+	int			 cmd = arg->i;
 
 	sc = cc->sc;
 	switch (cmd) {
@@ -295,72 +302,33 @@ kbfunc_exec(struct client_ctx *cc, union arg *arg)
 			/*NOTREACHED*/
 	}
 
-	TAILQ_INIT(&menuq);
-
-	if ((path = getenv("PATH")) == NULL)
-		path = _PATH_DEFPATH;
-	pathcpy = path = xstrdup(path);
-
-	for (ap = paths; ap < &paths[NPATHS - 1] &&
-	    (*ap = strsep(&pathcpy, ":")) != NULL;) {
-		if (**ap != '\0')
-			ap++;
-	}
-	*ap = NULL;
-	for (i = 0; i < NPATHS && paths[i] != NULL; i++) {
-		/* make sure this isn't a symlink to a path we already visited */
-		if ((l = readlink(paths[i], tpath, sizeof(tpath) - 1)) != -1) {
-			tpath[l] = '\0';
-			for (j = 0; j < NPATHS && paths[j] != NULL; ++j) {
-				if (!strcmp(paths[j], tpath))
-					break;
-			}
-			if (j < NPATHS || paths[j] != NULL)
-				continue;
-		}
-		/* check that this path isn't a repetition of an already visited one */
-		for (j = 0; j < i; ++j) {
-			if (!strcmp(paths[i], paths[j]))
-				break;
-		}
-		if (j < i)
-			continue;
-
-		if ((dirp = opendir(paths[i])) == NULL)
-			continue;
-
-		while ((dp = readdir(dirp)) != NULL) {
-			/* skip everything but regular files and symlinks */
-			if (dp->d_type != DT_REG && dp->d_type != DT_LNK)
-				continue;
-			(void)memset(tpath, '\0', sizeof(tpath));
-			l = snprintf(tpath, sizeof(tpath), "%s/%s", paths[i],
-			    dp->d_name);
-			/* check for truncation etc */
-			if (l == -1 || l >= (int)sizeof(tpath))
-				continue;
-			if (access(tpath, X_OK) == 0) {
-				mi = xcalloc(1, sizeof(*mi));
-				(void)strlcpy(mi->text,
-				    dp->d_name, sizeof(mi->text));
-				TAILQ_INSERT_TAIL(&menuq, mi, entry);
-			}
-		}
-		(void)closedir(dirp);
-	}
-	xfree(path);
-
-	if ((mi = menu_filter(sc, &menuq, label, NULL, 1,
-	    search_match_exec, NULL)) != NULL) {
+	menuq_init(&menuq);
+	trace_begin(&ts, "kbfunc_exec", cmd);
+	pathcache_start(&feeds[0], &menuq);
+	complete_feed(&feeds[1]);
+
+	/*
+	 * Entries are merged in sorted as each directory is read;
+	 * directories typed for path completion are listed likewise.
+	 */
+	mi = menu_filter_feed(sc, &menuq, label, NULL, 1,
+	    search_match_path, NULL, feeds, nitems(feeds));
+	pathcache_stop(&feeds[0]);
+	trace_end(&ts);
+
+	if (mi != NULL) {
 		if (mi->text[0] == '\0')
 			goto out;
+		if (complete_expand(mi->text, path, sizeof(path)) == -1)
+			goto out;
 		switch (cmd) {
 			case CWM_EXEC_PROGRAM:
-				u_spawn(mi->text);
+				u_spawn(path);
 				break;
 			case CWM_EXEC_WM:
-				u_exec(mi->text);
-				warn("%s", mi->text);
+				log_flush();
+				u_exec(path);
+				warn("%s", path);
 				break;
 			default:
 				err(1, "kb_func: egad, cmd changed value!");
@@ -368,12 +336,7 @@ kbfunc_exec(struct client_ctx *cc, union arg *arg)
 		}
 	}
 out:
-	if (mi != NULL && mi->dummy)
-		xfree(mi);
-	while ((mi = TAILQ_FIRST(&menuq)) != NULL) {
-		TAILQ_REMOVE(&menuq, mi, entry);
-		xfree(mi);
-	}
+	menuq_clear(&menuq);
 }
 
 void
@@ -382,54 +345,15 @@ kbfunc_ssh(struct client_ctx *cc, union arg *arg)
 	struct screen_ctx	*sc;
 	struct menu		*mi;
 	struct menu_q		 menuq;
-	FILE			*fp;
-	char			*buf, *lbuf, *p, *home;
-	char			 hostbuf[MAXHOSTNAMELEN], filename[MAXPATHLEN];
 	char			 cmd[256];
 	int			 l;
-	size_t			 len;
 
 	sc = cc->sc;
 
-	if ((home = getenv("HOME")) == NULL)
+	menuq_init(&menuq);
+	if (hosts_fill(&menuq) == -1)
 		return;
 
-	l = snprintf(filename, sizeof(filename), "%s/%s", home, KNOWN_HOSTS);
-	if (l == -1 || l >= sizeof(filename))
-		return;
-
-	if ((fp = fopen(filename, "r")) == NULL)
-		return;
-
-	TAILQ_INIT(&menuq);
-	lbuf = NULL;
-	while ((buf = fgetln(fp, &len))) {
-		if (buf[len - 1] == '\n')
-			buf[len - 1] = '\0';
-		else {
-			/* EOF without EOL, copy and add the NUL */
-			lbuf = xmalloc(len + 1);
-			(void)memcpy(lbuf, buf, len);
-			lbuf[len] = '\0';
-			buf = lbuf;
-		}
-		/* skip hashed hosts */
-		if (strncmp(buf, HASH_MARKER, strlen(HASH_MARKER)) == 0)
-			continue;
-		for (p = buf; *p != ',' && *p != ' ' && p != buf + len; p++) {
-			/* do nothing */
-		}
-		/* ignore badness */
-		if (p - buf + 1 > sizeof(hostbuf))
-			continue;
-		(void)strlcpy(hostbuf, buf, p - buf + 1);
-		mi = xcalloc(1, sizeof(*mi));
-		(void)strlcpy(mi->text, hostbuf, sizeof(mi->text));
-		TAILQ_INSERT_TAIL(&menuq, mi, entry);
-	}
-	xfree(lbuf);
-	(void)fclose(fp);
-
 	if ((mi = menu_filter(sc, &menuq, "ssh", NULL, 1,
 	    search_match_exec, NULL)) != NULL) {
 		if (mi->text[0] == '\0')
@@ -440,12 +364,7 @@ kbfunc_ssh(struct client_ctx *cc, union arg *arg)
 			u_spawn(cmd);
 	}
 out:
-	if (mi != NULL && mi->dummy)
-		xfree(mi);
-	while ((mi = TAILQ_FIRST(&menuq)) != NULL) {
-		TAILQ_REMOVE(&menuq, mi, entry);
-		xfree(mi);
-	}
+	menuq_clear(&menuq);
 }
 
 void
@@ -454,18 +373,19 @@ kbfunc_client_label(struct client_ctx *cc, union arg *arg)
 	struct menu	*mi;
 	struct menu_q	 menuq;
 
-	TAILQ_INIT(&menuq);
+	menuq_init(&menuq);
 
 	/* dummy is set, so this will always return */
-	mi = menu_filter(cc->sc, &menuq, "label", cc->label, 1,
+	mi = menu_filter(cc->sc, &menuq, "label", cc->cold->label, 1,
 	    search_match_text, NULL);
 
 	if (!mi->abort) {
-		if (cc->label != NULL)
-			xfree(cc->label);
-		cc->label = xstrdup(mi->text);
+		if (cc->cold->label != NULL)
+			xfree(cc->cold->label);
+		cc->cold->label = xstrdup(mi->text);
+		ctl_event_client(CTL_EV_LABEL, cc);
 	}
-	xfree(mi);
+	menuq_clear(&menuq);
 }
 
 void
@@ -1,37 +1,496 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Logging to ~/cwm.log without a system call per message.  Each thread
+ * puts its messages in a ring of its own, which only it writes, so no
+ * lock is taken; the main thread drains all rings from the event loop
+ * when idle.  A full ring drops messages rather than wait.  Messages
+ * are not formatted when logged: the record keeps the format, which
+ * must be a constant string, and the arguments, strings copied;
+ * printf(3) runs when the ring is drained.  The file is moved to
+ * cwm.log.old when it reaches LOG_MAXSIZE.
+ */
+
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
 
-static FILE *logfile;
+#include "calmwm.h"
 
-static void
-open_logfile(void)
+#define LOG_NRECS	256		/* per thread, a power of two */
+#define LOG_MAXARGS	8
+#define LOG_STRLEN	96
+#define LOG_LINELEN	256
+#define LOG_MAXSIZE	(1024 * 1024)
+#define LOG_FILE	"cwm.log"
+
+/* What a conversion takes, see log_conv(). */
+enum {
+	LOG_INT, LOG_LONG, LOG_LLONG, LOG_SIZE, LOG_DOUBLE, LOG_PTR,
+	LOG_STR, LOG_NONE, LOG_BAD
+};
+
+union log_arg {
+	int			 i;
+	long			 l;
+	long long		 ll;
+	size_t			 z;
+	double			 d;
+	void			*p;
+	u_int			 s;	/* offset in strs */
+};
+
+struct log_rec {
+	struct timespec		 ts;
+	const char		*fmt;
+	int			 level;
+	int			 nargs;
+	union log_arg		 args[LOG_MAXARGS];
+	char			 strs[LOG_STRLEN];
+};
+
+struct log_ring {
+	struct log_ring		*next;
+	u_int			 inuse;
+	u_long			 drops;
+	/* Written by the owner, and by the main thread, respectively. */
+	u_int			 head __attribute__((__aligned__(CACHELINE)));
+	u_int			 tail __attribute__((__aligned__(CACHELINE)));
+	struct log_rec		 recs[LOG_NRECS];
+};
+
+static struct log_ring	*log_attach(void);
+static int		 log_conv(const char **, int *);
+static void		 log_detach(void *);
+static void		 log_keyinit(void);
+static void		 log_open(void);
+static void		 log_out(const char *, size_t);
+static int		 log_render(struct log_rec *, char *, size_t);
+
+static const char	*log_levels[] = { "error", "warn", "info", "debug" };
+
+static pthread_key_t	 log_key;
+static pthread_once_t	 log_once = PTHREAD_ONCE_INIT;
+/* Protects the list of rings and inuse. */
+static pthread_mutex_t	 log_mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct log_ring	*log_rings;
+/* Held by the one flushing: for the tails, and the file. */
+static pthread_mutex_t	 log_out_mtx = PTHREAD_MUTEX_INITIALIZER;
+static int		 log_fd = -1;
+static off_t		 log_size;
+static char		 log_path[MAXPATHLEN];
+
+/*
+ * Use the log_*() macros, which drop messages above CWM_LOG_LEVEL at
+ * compile time, rather than this.
+ */
+void
+log_write(int level, const char *fmt, ...)
 {
-	const char *home;
-	char buf[4096];
+	struct log_ring	*r;
+	struct log_rec	*rec;
+	const char	*f, *s;
+	va_list		 ap;
+	size_t		 len, soff = 0;
+	u_int		 h;
+	int		 n = 0, nstar, type;
 
-	if (logfile)
+	(void)pthread_once(&log_once, log_keyinit);
+	if ((r = pthread_getspecific(log_key)) == NULL &&
+	    (r = log_attach()) == NULL)
 		return;
 
-	home = getenv("HOME");
-	if (!home)
+	h = r->head;
+	if (h - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) == LOG_NRECS) {
+		__atomic_fetch_add(&r->drops, 1, __ATOMIC_RELAXED);
 		return;
-	snprintf(buf, sizeof buf, "%s/cwm.log", home);
+	}
+	rec = &r->recs[h & (LOG_NRECS - 1)];
+	(void)clock_gettime(CLOCK_REALTIME, &rec->ts);
+	rec->fmt = fmt;
+	rec->level = level;
+
+	va_start(ap, fmt);
+	for (f = fmt; (f = strchr(f, '%')) != NULL && n < LOG_MAXARGS; ) {
+		f++;
+		if ((type = log_conv(&f, &nstar)) == LOG_BAD)
+			break;
+		while (nstar-- > 0 && n < LOG_MAXARGS)
+			rec->args[n++].i = va_arg(ap, int);
+		if (type == LOG_NONE || n == LOG_MAXARGS)
+			continue;
+		switch (type) {
+		case LOG_INT:
+			rec->args[n++].i = va_arg(ap, int);
+			break;
+		case LOG_LONG:
+			rec->args[n++].l = va_arg(ap, long);
+			break;
+		case LOG_LLONG:
+			rec->args[n++].ll = va_arg(ap, long long);
+			break;
+		case LOG_SIZE:
+			rec->args[n++].z = va_arg(ap, size_t);
+			break;
+		case LOG_DOUBLE:
+			rec->args[n++].d = va_arg(ap, double);
+			break;
+		case LOG_PTR:
+			rec->args[n++].p = va_arg(ap, void *);
+			break;
+		case LOG_STR:
+			if ((s = va_arg(ap, const char *)) == NULL)
+				s = "(null)";
+			len = strnlen(s, LOG_STRLEN - 1 - soff);
+			(void)memcpy(rec->strs + soff, s, len);
+			rec->strs[soff + len] = '\0';
+			rec->args[n++].s = soff;
+			soff += len + (soff + len < LOG_STRLEN - 1);
+			break;
+		}
+	}
+	va_end(ap);
+	rec->nargs = n;
 
-	logfile = fopen(buf, "w");
-	if (logfile)
-		setvbuf(logfile, NULL, _IOLBF, 0);
+	__atomic_store_n(&r->head, h + 1, __ATOMIC_RELEASE);
 }
 
+/*
+ * Anything queued and not yet written?
+ */
+int
+log_pending(void)
+{
+	struct log_ring	*r;
+	int		 pending = 0;
+
+	pthread_mutex_lock(&log_mtx);
+	for (r = log_rings; r != NULL && !pending; r = r->next)
+		pending = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) !=
+		    __atomic_load_n(&r->tail, __ATOMIC_RELAXED) ||
+		    __atomic_load_n(&r->drops, __ATOMIC_RELAXED) != 0;
+	pthread_mutex_unlock(&log_mtx);
+
+	return (pending);
+}
+
+/*
+ * Write out every ring.  Any thread may flush, the watchdog does when
+ * the main thread is stuck, so flushes take turns on log_out_mtx; the
+ * list lock is only held to find the first ring, as rings are only
+ * ever added at the head, and never while writing.
+ */
 void
-write_log(const char *fmt, ...)
+log_flush(void)
 {
-	va_list ap;
+	struct log_ring	*r, *rings;
+	struct log_rec	*rec;
+	struct tm	 tm;
+	char		 buf[8192];
+	size_t		 off = 0;
+	u_long		 drops;
+	u_int		 t, h;
 
-	open_logfile();
+	pthread_mutex_lock(&log_out_mtx);
+	pthread_mutex_lock(&log_mtx);
+	rings = log_rings;
+	pthread_mutex_unlock(&log_mtx);
 
-	va_start(ap, fmt);
-	vfprintf(logfile, fmt, ap);
-	va_end(ap);
-        fflush(logfile);
+	for (r = rings; r != NULL; r = r->next) {
+		h = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+		for (t = r->tail; t != h; t++) {
+			if (sizeof(buf) - off < LOG_LINELEN + 64) {
+				log_out(buf, off);
+				off = 0;
+			}
+			rec = &r->recs[t & (LOG_NRECS - 1)];
+			(void)localtime_r(&rec->ts.tv_sec, &tm);
+			off += strftime(buf + off, sizeof(buf) - off,
+			    "%H:%M:%S", &tm);
+			off += snprintf(buf + off, sizeof(buf) - off,
+			    ".%06ld %s: ", rec->ts.tv_nsec / 1000,
+			    log_levels[rec->level]);
+			off += log_render(rec, buf + off, LOG_LINELEN);
+			buf[off++] = '\n';
+		}
+		__atomic_store_n(&r->tail, t, __ATOMIC_RELEASE);
+
+		if ((drops = __atomic_exchange_n(&r->drops, 0,
+		    __ATOMIC_RELAXED)) != 0)
+			off += snprintf(buf + off, sizeof(buf) - off,
+			    "log: %lu messages dropped\n", drops);
+	}
+	if (off > 0)
+		log_out(buf, off);
+	pthread_mutex_unlock(&log_out_mtx);
+}
+
+/*
+ * Format rec into buf, returning the length, at most size - 1.
+ */
+static int
+log_render(struct log_rec *rec, char *buf, size_t size)
+{
+	union log_arg	*a = rec->args;
+	const char	*f = rec->fmt, *p, *c;
+	char		 spec[32], *sp;
+	int		 n = 0, len, nstar, type;
+
+#define LOG_ADD(_len) do {						\
+	n += MIN((size_t)MAX((_len), 0), size - 1 - n);			\
+} while (0)
+
+	buf[0] = '\0';
+	while (*f != '\0' && (size_t)n < size - 1) {
+		if ((p = strchr(f, '%')) == NULL)
+			p = f + strlen(f);
+		len = MIN(p - f, (int)(size - 1 - n));
+		(void)memcpy(buf + n, f, len);
+		n += len;
+		buf[n] = '\0';
+		if (*p == '\0')
+			break;
+
+		c = p + 1;
+		if ((type = log_conv(&c, &nstar)) == LOG_BAD) {
+			LOG_ADD(snprintf(buf + n, size - n, "%s", p));
+			break;
+		}
+		f = c;
+		if (type == LOG_NONE) {
+			LOG_ADD(snprintf(buf + n, size - n, "%%"));
+			continue;
+		}
+		if (a + nstar + 1 > rec->args + rec->nargs) {
+			LOG_ADD(snprintf(buf + n, size - n, "..."));
+			break;
+		}
+
+		/* The conversion, with any '*' replaced by its value. */
+		for (sp = spec; p < c && sp < spec + sizeof(spec) - 12; p++)
+			if (*p == '*')
+				sp += snprintf(sp, 12, "%d", (a++)->i);
+			else
+				*sp++ = *p;
+		*sp = '\0';
+
+		switch (type) {
+		case LOG_INT:
+			len = snprintf(buf + n, size - n, spec, a->i);
+			break;
+		case LOG_LONG:
+			len = snprintf(buf + n, size - n, spec, a->l);
+			break;
+		case LOG_LLONG:
+			len = snprintf(buf + n, size - n, spec, a->ll);
+			break;
+		case LOG_SIZE:
+			len = snprintf(buf + n, size - n, spec, a->z);
+			break;
+		case LOG_DOUBLE:
+			len = snprintf(buf + n, size - n, spec, a->d);
+			break;
+		case LOG_PTR:
+			len = snprintf(buf + n, size - n, spec, a->p);
+			break;
+		case LOG_STR:
+			len = snprintf(buf + n, size - n, spec,
+			    rec->strs + a->s);
+			break;
+		}
+		a++;
+		LOG_ADD(len);
+	}
+#undef LOG_ADD
+
+	return (n);
+}
+
+/*
+ * Scan the printf(3) conversion at *fp, which is just past its '%', and
+ * leave *fp past it.  Returns the kind of argument it takes, and in
+ * *nstar the number of '*' int arguments before that.
+ */
+static int
+log_conv(const char **fp, int *nstar)
+{
+	const char	*f = *fp;
+	int		 type = LOG_INT;
+
+	*nstar = 0;
+	f += strspn(f, "-+ #0");
+	if (*f == '*') {
+		(*nstar)++;
+		f++;
+	} else
+		f += strspn(f, "0123456789");
+	if (*f == '.') {
+		f++;
+		if (*f == '*') {
+			(*nstar)++;
+			f++;
+		} else
+			f += strspn(f, "0123456789");
+	}
+
+	switch (*f) {
+	case 'h':
+		f += (f[1] == 'h') ? 2 : 1;
+		break;
+	case 'l':
+		if (f[1] == 'l') {
+			type = LOG_LLONG;
+			f += 2;
+		} else {
+			type = LOG_LONG;
+			f++;
+		}
+		break;
+	case 'j':
+		type = LOG_LLONG;
+		f++;
+		break;
+	case 'z':
+	case 't':
+		type = LOG_SIZE;
+		f++;
+		break;
+	}
+
+	switch (*f++) {
+	case 'd':
+	case 'i':
+	case 'o':
+	case 'u':
+	case 'x':
+	case 'X':
+	case 'c':
+		break;
+	case 'e':
+	case 'E':
+	case 'f':
+	case 'F':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A':
+		type = LOG_DOUBLE;
+		break;
+	case 's':
+		type = LOG_STR;
+		break;
+	case 'p':
+		type = LOG_PTR;
+		break;
+	case '%':
+		type = LOG_NONE;
+		break;
+	default:
+		return (LOG_BAD);
+	}
+	*fp = f;
+
+	return (type);
+}
+
+/* Take over the ring of a thread gone, if drained, or make one. */
+static struct log_ring *
+log_attach(void)
+{
+	struct log_ring	*r;
+
+	pthread_mutex_lock(&log_mtx);
+	for (r = log_rings; r != NULL; r = r->next)
+		if (!r->inuse &&
+		    r->head == __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE))
+			break;
+	if (r == NULL) {
+		r = xcalloc(1, sizeof(*r));
+		r->next = log_rings;
+		log_rings = r;
+	}
+	r->inuse = 1;
+	pthread_mutex_unlock(&log_mtx);
+
+	if (pthread_setspecific(log_key, r) != 0) {
+		log_detach(r);
+		return (NULL);
+	}
+	return (r);
+}
+
+static void
+log_detach(void *v)
+{
+	struct log_ring	*r = v;
+
+	pthread_mutex_lock(&log_mtx);
+	r->inuse = 0;
+	pthread_mutex_unlock(&log_mtx);
+}
+
+static void
+log_keyinit(void)
+{
+	(void)pthread_key_create(&log_key, log_detach);
+}
+
+static void
+log_open(void)
+{
+	const char	*home;
+
+	if (log_path[0] == '\0') {
+		if ((home = getenv("HOME")) == NULL)
+			return;
+		(void)snprintf(log_path, sizeof(log_path), "%s/%s", home,
+		    LOG_FILE);
+	}
+	log_fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (log_fd != -1)
+		(void)fcntl(log_fd, F_SETFD, FD_CLOEXEC);
+	log_size = 0;
+}
+
+static void
+log_out(const char *buf, size_t len)
+{
+	char	 old[MAXPATHLEN + 4];
+
+	if (log_fd != -1 && log_size + len > LOG_MAXSIZE) {
+		(void)close(log_fd);
+		(void)snprintf(old, sizeof(old), "%s.old", log_path);
+		(void)rename(log_path, old);
+		log_fd = -1;
+	}
+	if (log_fd == -1)
+		log_open();
+	if (log_fd == -1)
+		return;
+
+	if (write(log_fd, buf, len) > 0)
+		log_size += len;
 }
@@ -1,6 +0,0 @@
-#ifndef LOG_H
-#define LOG_H
-
-void write_log(const char *fmt, ...);
-
-#endif
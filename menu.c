@@ -24,13 +24,19 @@
 
 #include <err.h>
 #include <errno.h>
+#include <poll.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "calmwm.h"
 
+#define MENU_MAXFEEDS	4
+#define MENU_MAXSEARCH	1024
+#define MENU_MAXPRINT	256
+
 #define PROMPT_SCHAR	"\xc2\xbb"
 #define PROMPT_ECHAR	"\xc2\xab"
 
@@ -41,9 +47,9 @@ enum ctltype {
 };
 
 struct menu_ctx {
-	char			 searchstr[MENU_MAXENTRY + 1];
-	char			 dispstr[MENU_MAXENTRY*2 + 1];
-	char			 promptstr[MENU_MAXENTRY + 1];
+	char			 searchstr[MENU_MAXSEARCH + 1];
+	char			 dispstr[MENU_MAXSEARCH*2 + 1];
+	char			 promptstr[MENU_MAXSEARCH + 1];
 	int			 hasprompt;
 	int			 list;
 	int			 listing;
@@ -56,20 +62,32 @@ struct menu_ctx {
 	int			 x;
 	int			 y;
     	void (*match)(struct menu_q *, struct menu_q *, char *);
-    	void (*print)(struct menu *, int);
+    	void (*print)(struct menu *, int, char *, size_t);
 };
 static struct menu	*menu_handle_key(XEvent *, struct menu_ctx *,
 			     struct menu_q *, struct menu_q *);
 static void		 menu_handle_move(XEvent *, struct menu_ctx *,
 			     struct menu_q *, struct screen_ctx *);
 static struct menu	*menu_handle_release(XEvent *, struct menu_ctx *,
-			     struct screen_ctx *, struct menu_q *);
+			     struct screen_ctx *, struct menu_q *,
+			     struct menu_q *);
 static void		 menu_draw(struct screen_ctx *, struct menu_ctx *,
 			     struct menu_q *, struct menu_q *);
 static int		 menu_calc_entry(struct screen_ctx *, struct menu_ctx *,
 			     int, int);
 static int		 menu_keycode(KeyCode, u_int, enum ctltype *,
                              char *);
+static void		 menu_next_event(struct screen_ctx *,
+			     struct menu_ctx *, struct menu_q *,
+			     struct menu_q *, struct menu_feed *, int, int,
+			     XEvent *);
+static void		 menu_rematch(struct menu_ctx *, struct menu_q *,
+			     struct menu_q *);
+static void		 menu_match(struct menu_ctx *, struct menu_q *,
+			     struct menu_q *);
+
+static u_long		 menu_nopen;
+static double		 menu_matchtime;	/* seconds */
 
 void
 menu_init(struct screen_ctx *sc)
@@ -93,17 +111,44 @@ menu_init(struct screen_ctx *sc)
 	    GCForeground|GCBackground|GCFunction, &gv);
 }
 
+/*
+ * Menu statistics as a JSON line.
+ */
+void
+menu_stats(FILE *f)
+{
+	fprintf(f, "{\"stat\":\"menu\",\"invocations\":%lu,"
+	    "\"filter_ms\":%.3f}\n", menu_nopen, menu_matchtime * 1000);
+}
+
 struct menu *
 menu_filter(struct screen_ctx *sc, struct menu_q *menuq, char *prompt,
     char *initial, int dummy,
     void (*match)(struct menu_q *, struct menu_q *, char *),
-    void (*print)(struct menu *, int))
+    void (*print)(struct menu *, int, char *, size_t))
+{
+	return (menu_filter_feed(sc, menuq, prompt, initial, dummy,
+	    match, print, NULL, 0));
+}
+
+/*
+ * Like menu_filter(), but the feeds may keep adding entries to menuq,
+ * or otherwise change what match finds, while the menu is shown.
+ * menuq must stay sorted if match relies on it.
+ */
+struct menu *
+menu_filter_feed(struct screen_ctx *sc, struct menu_q *menuq, char *prompt,
+    char *initial, int dummy,
+    void (*match)(struct menu_q *, struct menu_q *, char *),
+    void (*print)(struct menu *, int, char *, size_t),
+    struct menu_feed *feeds, int nfeeds)
 {
 	struct menu_ctx		 mc;
 	struct menu_q		 resultq;
 	struct menu		*mi = NULL;
 	XEvent			 e;
 	Window			 focuswin;
+	struct trace_span	 ts;
 	int			 evmask, focusrevert;
 	int			 xsave, ysave, xcur, ycur;
 
@@ -111,6 +156,9 @@ menu_filter(struct screen_ctx *sc, struct menu_q *menuq, char *prompt,
 
 	bzero(&mc, sizeof(mc));
 
+	trace_begin(&ts, "menu_filter", 0);
+	menu_nopen++;
+	xop_begin(XOP_MENU_OPEN);
 	xu_ptr_getpos(sc->rootwin, &mc.x, &mc.y);
 
 	xsave = mc.x;
@@ -146,6 +194,8 @@ menu_filter(struct screen_ctx *sc, struct menu_q *menuq, char *prompt,
 
 	if (xu_ptr_grab(sc->menuwin, MENUGRABMASK, Cursor_question) < 0) {
 		XUnmapWindow(X_Dpy, sc->menuwin);
+		xop_end(XOP_MENU_OPEN);
+		trace_end(&ts);
 		return (NULL);
 	}
 
@@ -157,11 +207,16 @@ menu_filter(struct screen_ctx *sc, struct menu_q *menuq, char *prompt,
 	    GrabModeAsync, GrabModeAsync, CurrentTime);
 
 	menu_draw(sc, &mc, menuq, &resultq);
+	xop_end(XOP_MENU_OPEN);
 
 	for (;;) {
 		mc.changed = 0;
 
-		XWindowEvent(X_Dpy, sc->menuwin, evmask, &e);
+		/* Waiting for the user is not being stuck. */
+		watchdog_end();
+		menu_next_event(sc, &mc, menuq, &resultq, feeds, nfeeds,
+		    evmask, &e);
+		watchdog_begin("menu", e.type, sc->menuwin);
 
 		switch (e.type) {
 		case KeyPress:
@@ -176,8 +231,8 @@ menu_filter(struct screen_ctx *sc, struct menu_q *menuq, char *prompt,
 			menu_handle_move(&e, &mc, &resultq, sc);
 			break;
 		case ButtonRelease:
-			if ((mi = menu_handle_release(&e, &mc, sc, &resultq))
-			    != NULL)
+			if ((mi = menu_handle_release(&e, &mc, sc, menuq,
+			    &resultq)) != NULL)
 				goto out;
 			break;
 		default:
@@ -185,10 +240,8 @@ menu_filter(struct screen_ctx *sc, struct menu_q *menuq, char *prompt,
 		}
 	}
 out:
-	if (dummy == 0 && mi->dummy) { /* no mouse based match */
-		xfree(mi);
+	if (dummy == 0 && mi->dummy) /* no mouse based match */
 		mi = NULL;
-	}
 
 	XSetInputFocus(X_Dpy, focuswin, focusrevert, CurrentTime);
 	/* restore if user didn't move */
@@ -199,10 +252,94 @@ out:
 
 	XUnmapWindow(X_Dpy, sc->menuwin);
 	XUngrabKeyboard(X_Dpy, CurrentTime);
+	trace_end(&ts);
 
 	return (mi);
 }
 
+/*
+ * Wait for the next event on the menu window, taking in what the feeds
+ * have to offer meanwhile.  A feed that is done gets its fd set to -1.
+ */
+static void
+menu_next_event(struct screen_ctx *sc, struct menu_ctx *mc,
+    struct menu_q *menuq, struct menu_q *resultq, struct menu_feed *feeds,
+    int nfeeds, int evmask, XEvent *e)
+{
+	struct pollfd		 pfd[MENU_MAXFEEDS + 1];
+	int			 i, active, fed;
+
+	nfeeds = MIN(nfeeds, MENU_MAXFEEDS);
+
+	for (;;) {
+		pfd[0].fd = ConnectionNumber(X_Dpy);
+		pfd[0].events = POLLIN;
+		for (i = 0, active = 0; i < nfeeds; i++) {
+			/* poll(2) skips negative fds */
+			pfd[i + 1].fd = feeds[i].fd;
+			pfd[i + 1].events = POLLIN;
+			pfd[i + 1].revents = 0;
+			if (feeds[i].fd != -1)
+				active++;
+		}
+		if (active == 0)
+			break;
+
+		if (XCheckWindowEvent(X_Dpy, sc->menuwin, evmask, e)) {
+			rec_event(e);
+			return;
+		}
+
+		if (poll(pfd, nfeeds + 1, -1) == -1) {
+			if (errno != EINTR)
+				err(1, "poll");
+			continue;
+		}
+
+		watchdog_begin("menu_feed", 0, sc->menuwin);
+		for (i = 0, fed = 0; i < nfeeds; i++) {
+			if (feeds[i].fd == -1 || pfd[i + 1].revents == 0)
+				continue;
+			if ((*feeds[i].fill)(menuq, feeds[i].arg) == 0)
+				feeds[i].fd = -1;
+			fed = 1;
+		}
+		if (fed) {
+			menu_rematch(mc, menuq, resultq);
+			menu_draw(sc, mc, menuq, resultq);
+		}
+		watchdog_end();
+	}
+
+	XWindowEvent(X_Dpy, sc->menuwin, evmask, e);
+	rec_event(e);
+}
+
+/* Run the menu's match function, keeping count of the time spent. */
+static void
+menu_match(struct menu_ctx *mc, struct menu_q *menuq, struct menu_q *resultq)
+{
+	struct timespec	 t0, t1;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &t0);
+	(*mc->match)(menuq, resultq, mc->searchstr);
+	(void)clock_gettime(CLOCK_MONOTONIC, &t1);
+	menu_matchtime += (t1.tv_sec - t0.tv_sec) +
+	    (t1.tv_nsec - t0.tv_nsec) / 1e9;
+}
+
+static void
+menu_rematch(struct menu_ctx *mc, struct menu_q *menuq,
+    struct menu_q *resultq)
+{
+	if (mc->searchstr[0] != '\0') {
+		menu_match(mc, menuq, resultq);
+		mc->noresult = TAILQ_EMPTY(resultq) && !TAILQ_EMPTY(menuq);
+	} else if (mc->listing)
+		/* menu_draw() copies everything over again */
+		TAILQ_INIT(resultq);
+}
+
 static struct menu *
 menu_handle_key(XEvent *e, struct menu_ctx *mc, struct menu_q *menuq,
     struct menu_q *resultq)
@@ -244,10 +381,13 @@ menu_handle_key(XEvent *e, struct menu_ctx *mc, struct menu_q *menuq,
 		 * even if dummy is zero, we need to return something.
 		 */
 		if ((mi = TAILQ_FIRST(resultq)) == NULL) {
-			mi = xmalloc(sizeof *mi);
-			(void)strlcpy(mi->text,
-			    mc->searchstr, sizeof(mi->text));
+			mi = menuq_entry(menuq, NULL, mc->searchstr);
 			mi->dummy = 1;
+		} else if (mi->descend) {
+			(void)strlcpy(mc->searchstr, mi->text,
+			    sizeof(mc->searchstr));
+			mc->changed = 1;
+			break;
 		}
 		mi->abort = 0;
 		return (mi);
@@ -259,8 +399,7 @@ menu_handle_key(XEvent *e, struct menu_ctx *mc, struct menu_q *menuq,
 		mc->list = !mc->list;
 		break;
 	case CTL_ABORT:
-		mi = xmalloc(sizeof *mi);
-		mi->text[0] = '\0';
+		mi = menuq_entry(menuq, NULL, "");
 		mi->dummy = 1;
 		mi->abort = 1;
 		return (mi);
@@ -279,7 +418,7 @@ menu_handle_key(XEvent *e, struct menu_ctx *mc, struct menu_q *menuq,
 
 	mc->noresult = 0;
 	if (mc->changed && mc->searchstr[0] != '\0') {
-		(*mc->match)(menuq, resultq, mc->searchstr);
+		menu_match(mc, menuq, resultq);
 		/* If menuq is empty, never show we've failed */
 		mc->noresult = TAILQ_EMPTY(resultq) && !TAILQ_EMPTY(menuq);
 	} else if (mc->changed)
@@ -299,10 +438,14 @@ menu_draw(struct screen_ctx *sc, struct menu_ctx *mc, struct menu_q *menuq,
 {
 	struct menu		*mi;
 	XineramaScreenInfo	*xine;
+	char			 buf[MENU_MAXPRINT + 1];
 	int			 xmin, xmax, ymin, ymax;
 	int			 n, dy, xsave, ysave;
 	int			 bwidth2;
 	XftColor		*xftcolorp = &sc->xftcolor;
+	struct trace_span	 ts;
+
+	trace_begin(&ts, "menu_draw", 0);
 
 	if (mc->list) {
 		if (TAILQ_EMPTY(resultq) && mc->list) {
@@ -331,15 +474,17 @@ menu_draw(struct screen_ctx *sc, struct menu_ctx *mc, struct menu_q *menuq,
 		char *text;
 
 		if (mc->print != NULL) {
-			(*mc->print)(mi, mc->listing);
+			(*mc->print)(mi, mc->listing, buf, sizeof(buf));
+			/* Redrawn often; only keep a copy when it changed. */
+			if (mi->print == NULL || strcmp(mi->print, buf) != 0)
+				mi->print = menuq_strdup(menuq, buf);
 			text = mi->print;
 		} else {
-			mi->print[0] = '\0';
+			mi->print = NULL;
 			text = mi->text;
 		}
 
-		mc->width = MAX(mc->width, font_width(sc, text,
-		    MIN(strlen(text), MENU_MAXENTRY)));
+		mc->width = MAX(mc->width, font_width(sc, text, strlen(text)));
 		dy += font_height(sc);
 		mc->num++;
 	}
@@ -361,6 +506,9 @@ menu_draw(struct screen_ctx *sc, struct menu_ctx *mc, struct menu_q *menuq,
 
 	bwidth2 = Conf.bwidth * 2;
 
+	/* Entries are as long as they need to be; the screen is not. */
+	mc->width = MIN(mc->width, xmax - xmin - bwidth2);
+
 	if (mc->x < xmin)
 		mc->x = xmin;
 	else if (mc->x + mc->width + bwidth2 >= xmax)
@@ -409,15 +557,16 @@ menu_draw(struct screen_ctx *sc, struct menu_ctx *mc, struct menu_q *menuq,
 		xftcolorp = &sc->xftcolor;
 	}
 	TAILQ_FOREACH(mi, resultq, resultentry) {
-		char *text = mi->print[0] != '\0' ?
-		    mi->print : mi->text;
+		char *text = mi->print != NULL ? mi->print : mi->text;
 
-		font_draw(sc, text, MIN(strlen(text), MENU_MAXENTRY),
+		font_draw(sc, text, strlen(text),
 		    sc->menuwin, 0, n * font_height(sc) + font_ascent(sc) + 1,
 		    xftcolorp);
 		n++;
 		xftcolorp = &sc->xftcolor;
 	}
+	ts.arg = n;		/* lines drawn */
+	trace_end(&ts);
 }
 
 static char *
@@ -427,7 +576,7 @@ menu_get_entry_text(struct menu_q *q, int i)
 
 	TAILQ_FOREACH(mi, q, resultentry) {
 		if (i-- == 0)
-			return mi->print[0] != '\0' ? mi->print : mi->text;
+			return mi->print != NULL ? mi->print : mi->text;
 	}
 	return NULL;
 }
@@ -454,7 +603,7 @@ menu_handle_move(XEvent *e, struct menu_ctx *mc, struct menu_q *mq,
 		text = menu_get_entry_text(mq, mc->prev);
 		font_draw(sc,
 		    text,
-		    MIN(strlen(text), MENU_MAXENTRY),
+		    strlen(text),
 		    sc->menuwin,
 		    0,
 		    (mc->prev + (mc->hasprompt ? 1 : 0))
@@ -469,7 +618,7 @@ menu_handle_move(XEvent *e, struct menu_ctx *mc, struct menu_q *mq,
 		text = menu_get_entry_text(mq, mc->entry);
 		font_draw(sc,
 		    text,
-		    MIN(strlen(text), MENU_MAXENTRY),
+		    strlen(text),
 		    sc->menuwin,
 		    0,
 		    (mc->entry + (mc->hasprompt ? 1 : 0))
@@ -481,7 +630,7 @@ menu_handle_move(XEvent *e, struct menu_ctx *mc, struct menu_q *mq,
 
 static struct menu *
 menu_handle_release(XEvent *e, struct menu_ctx *mc, struct screen_ctx *sc,
-    struct menu_q *resultq)
+    struct menu_q *menuq, struct menu_q *resultq)
 {
 	struct menu	*mi;
 	int		 entry;
@@ -495,9 +644,14 @@ menu_handle_release(XEvent *e, struct menu_ctx *mc, struct screen_ctx *sc,
 		if (entry-- == 0)
 			break;
 	if (mi == NULL) {
-		mi = xmalloc(sizeof(*mi));
-		mi->text[0] = '\0';
+		mi = menuq_entry(menuq, NULL, "");
 		mi->dummy = 1;
+	} else if (mi->descend) {
+		(void)strlcpy(mc->searchstr, mi->text, sizeof(mc->searchstr));
+		menu_match(mc, menuq, resultq);
+		mc->noresult = TAILQ_EMPTY(resultq) && !TAILQ_EMPTY(menuq);
+		menu_draw(sc, mc, menuq, resultq);
+		return (NULL);
 	}
 	return (mi);
 }
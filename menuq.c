@@ -0,0 +1,154 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Copyright (c) 2004 Martin Murray <mmurray@monkey.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Storage for menu entries.  A menu lives only as long as it is shown,
+ * so its entries and their text are carved out of a few large chunks
+ * owned by the menu_q, and all of it goes at once in menuq_clear().
+ */
+
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include <err.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "calmwm.h"
+
+#define MENUQ_ALIGN		sizeof(void *)
+#define MENUQ_MINCHUNK		(4 * 1024)
+#define MENUQ_MAXCHUNK		(256 * 1024)
+
+#define MENUQ_ROUND(_n)		(((_n) + MENUQ_ALIGN - 1) & ~(MENUQ_ALIGN - 1))
+
+struct menu_chunk {
+	struct menu_chunk	*next;
+	size_t			 size;
+	size_t			 used;
+};
+
+static void		*menuq_alloc(struct menu_q *, size_t);
+
+void
+menuq_init(struct menu_q *mq)
+{
+	TAILQ_INIT(mq);
+	mq->chunks = NULL;
+}
+
+/*
+ * Free every entry ever made for mq, whether still on it or not.
+ */
+void
+menuq_clear(struct menu_q *mq)
+{
+	struct menu_chunk	*ch;
+
+	while ((ch = mq->chunks) != NULL) {
+		mq->chunks = ch->next;
+		xfree(ch);
+	}
+	TAILQ_INIT(mq);
+}
+
+/*
+ * A new entry for text, made from the storage of mq but not put on it.
+ */
+struct menu *
+menuq_entry(struct menu_q *mq, void *ctx, const char *text)
+{
+	struct menu	*mi;
+	size_t		 len;
+
+	len = strlen(text) + 1;
+	mi = menuq_alloc(mq, MENUQ_ROUND(sizeof(*mi)) + len);
+	bzero(mi, sizeof(*mi));
+	mi->text = (char *)mi + MENUQ_ROUND(sizeof(*mi));
+	(void)memcpy(mi->text, text, len);
+	mi->ctx = ctx;
+
+	return (mi);
+}
+
+/*
+ * Add an entry at the end of mq, its text formatted as by printf(3).
+ */
+struct menu *
+menuq_add(struct menu_q *mq, void *ctx, const char *fmt, ...)
+{
+	struct menu	*mi;
+	va_list		 ap;
+	int		 len;
+
+	va_start(ap, fmt);
+	len = vsnprintf(NULL, 0, fmt, ap);
+	va_end(ap);
+	if (len == -1)
+		err(1, "vsnprintf");
+
+	mi = menuq_alloc(mq, MENUQ_ROUND(sizeof(*mi)) + len + 1);
+	bzero(mi, sizeof(*mi));
+	mi->text = (char *)mi + MENUQ_ROUND(sizeof(*mi));
+	va_start(ap, fmt);
+	(void)vsnprintf(mi->text, len + 1, fmt, ap);
+	va_end(ap);
+	mi->ctx = ctx;
+	TAILQ_INSERT_TAIL(mq, mi, entry);
+
+	return (mi);
+}
+
+char *
+menuq_strdup(struct menu_q *mq, const char *s)
+{
+	size_t	 len;
+
+	len = strlen(s) + 1;
+	return (memcpy(menuq_alloc(mq, len), s, len));
+}
+
+static void *
+menuq_alloc(struct menu_q *mq, size_t len)
+{
+	struct menu_chunk	*ch = mq->chunks;
+	size_t			 hdr, size;
+	void			*p;
+
+	hdr = MENUQ_ROUND(sizeof(*ch));
+	len = MENUQ_ROUND(len);
+
+	if (ch == NULL || ch->size - ch->used < len) {
+		/* Each chunk twice the last, so big menus take few. */
+		size = (ch == NULL) ? MENUQ_MINCHUNK :
+		    MIN(ch->size * 2, MENUQ_MAXCHUNK);
+		size = MAX(size, hdr + len);
+		ch = xmalloc(size);
+		ch->size = size;
+		ch->used = hdr;
+		ch->next = mq->chunks;
+		mq->chunks = ch;
+	}
+
+	p = (char *)ch + ch->used;
+	ch->used += len;
+
+	return (p);
+}
@@ -58,8 +58,8 @@ mousefunc_sweep_draw(struct client_ctx *cc)
 	int			 width, width_size, width_name;
 
 	(void)snprintf(asize, sizeof(asize), "%dx%d",
-	    (cc->geom.width - cc->hint.basew) / cc->hint.incw,
-	    (cc->geom.height - cc->hint.baseh) / cc->hint.inch);
+	    (cc->geom.width - cc->cold->hint.basew) / cc->cold->hint.incw,
+	    (cc->geom.height - cc->cold->hint.baseh) / cc->cold->hint.inch);
 	width_size = font_width(sc, asize, strlen(asize)) + 4;
 	width_name = font_width(sc, cc->name, strlen(cc->name)) + 4;
 	width = MAX(width_size, width_name);
@@ -96,7 +96,10 @@ mousefunc_window_resize(struct client_ctx *cc, void *arg)
 	mousefunc_sweep_draw(cc);
 
 	for (;;) {
+		watchdog_end();
 		XMaskEvent(X_Dpy, MOUSEMASK|ExposureMask, &ev);
+		rec_event(&ev);
+		watchdog_begin("mouse_resize", ev.type, cc->win);
 
 		switch (ev.type) {
 		case Expose:
@@ -122,10 +125,10 @@ mousefunc_window_resize(struct client_ctx *cc, void *arg)
 			xu_ptr_ungrab();
 
 			/* Make sure the pointer stays within the window. */
-			if (cc->ptr.x > cc->geom.width)
-				cc->ptr.x = cc->geom.width - cc->bwidth;
-			if (cc->ptr.y > cc->geom.height)
-				cc->ptr.y = cc->geom.height - cc->bwidth;
+			if (cc->cold->ptr.x > cc->geom.width)
+				cc->cold->ptr.x = cc->geom.width - cc->bwidth;
+			if (cc->cold->ptr.y > cc->geom.height)
+				cc->cold->ptr.y = cc->geom.height - cc->bwidth;
 			client_ptrwarp(cc);
 			return;
 		}
@@ -151,7 +154,10 @@ mousefunc_window_move(struct client_ctx *cc, void *arg)
 	xu_ptr_getpos(cc->win, &px, &py);
 
 	for (;;) {
+		watchdog_end();
 		XMaskEvent(X_Dpy, MOUSEMASK|ExposureMask, &ev);
+		rec_event(&ev);
+		watchdog_begin("mouse_move", ev.type, cc->win);
 
 		switch (ev.type) {
 		case Expose:
@@ -227,17 +233,14 @@ mousefunc_menu_unhide(struct client_ctx *cc, void *arg)
 	sc = cc->sc;
 	old_cc = client_current();
 
-	TAILQ_INIT(&menuq);
+	menuq_init(&menuq);
 	TAILQ_FOREACH(cc, &Clientq, entry)
 		if (cc->flags & CLIENT_HIDDEN) {
-			wname = (cc->label) ? cc->label : cc->name;
+			wname = (cc->cold->label) ? cc->cold->label : cc->name;
 			if (wname == NULL)
 				continue;
 
-			mi = xcalloc(1, sizeof(*mi));
-			(void)strlcpy(mi->text, wname, sizeof(mi->text));
-			mi->ctx = cc;
-			TAILQ_INSERT_TAIL(&menuq, mi, entry);
+			(void)menuq_add(&menuq, cc, "%s", wname);
 		}
 
 	if (TAILQ_EMPTY(&menuq))
@@ -251,12 +254,8 @@ mousefunc_menu_unhide(struct client_ctx *cc, void *arg)
 		if (old_cc != NULL)
 			client_ptrsave(old_cc);
 		client_ptrwarp(cc);
-	} else {
-		while ((mi = TAILQ_FIRST(&menuq)) != NULL) {
-			TAILQ_REMOVE(&menuq, mi, entry);
-			xfree(mi);
-		}
 	}
+	menuq_clear(&menuq);
 }
 
 void
@@ -269,22 +268,14 @@ mousefunc_menu_cmd(struct client_ctx *cc, void *arg)
 
 	sc = cc->sc;
 
-	TAILQ_INIT(&menuq);
-	TAILQ_FOREACH(cmd, &Conf.cmdq, entry) {
-		mi = xcalloc(1, sizeof(*mi));
-		(void)strlcpy(mi->text, cmd->label, sizeof(mi->text));
-		mi->ctx = cmd;
-		TAILQ_INSERT_TAIL(&menuq, mi, entry);
-	}
+	menuq_init(&menuq);
+	TAILQ_FOREACH(cmd, &Conf.cmdq, entry)
+		(void)menuq_add(&menuq, cmd, "%s", cmd->label);
 	if (TAILQ_EMPTY(&menuq))
 		return;
 
 	mi = menu_filter(sc, &menuq, NULL, NULL, 0, NULL, NULL);
 	if (mi != NULL)
 		u_spawn(((struct cmd *)mi->ctx)->image);
-	else
-		while ((mi = TAILQ_FIRST(&menuq)) != NULL) {
-			TAILQ_REMOVE(&menuq, mi, entry);
-			xfree(mi);
-		}
+	menuq_clear(&menuq);
 }
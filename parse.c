@@ -70,16 +70,19 @@ typedef struct {
 #define MOVEAMOUNT 268
 #define COLOR 269
 #define SNAPDIST 270
-#define ACTIVEBORDER 271
-#define INACTIVEBORDER 272
-#define GROUPBORDER 273
-#define UNGROUPBORDER 274
-#define MENUBG 275
-#define MENUFG 276
-#define FONTCOLOR 277
-#define ERROR 278
-#define STRING 279
-#define NUMBER 280
+#define FILTERTHREADS 271
+#define PATHCACHE 272
+#define WATCHDOG 273
+#define ACTIVEBORDER 274
+#define INACTIVEBORDER 275
+#define GROUPBORDER 276
+#define UNGROUPBORDER 277
+#define MENUBG 278
+#define MENUFG 279
+#define FONTCOLOR 280
+#define ERROR 281
+#define STRING 282
+#define NUMBER 283
 #define YYERRCODE 256
 #if defined(__cplusplus) || defined(__STDC__)
 const short yylhs[] =
@@ -89,7 +92,8 @@ short yylhs[] =
 	{                                        -1,
     0,    0,    0,    0,    0,    2,    2,    1,    1,    3,
     3,    3,    3,    3,    3,    3,    3,    3,    3,    3,
-    4,    5,    5,    5,    5,    5,    5,    5,
+    3,    3,    3,    4,    5,    5,    5,    5,    5,    5,
+    5,
 };
 #if defined(__cplusplus) || defined(__STDC__)
 const short yylen[] =
@@ -98,8 +102,9 @@ short yylen[] =
 #endif
 	{                                         2,
     0,    2,    3,    3,    3,    2,    1,    1,    1,    2,
-    2,    2,    2,    2,    3,    3,    2,    3,    5,    3,
-    2,    2,    2,    2,    2,    2,    2,    2,
+    2,    2,    2,    2,    2,    2,    2,    3,    3,    2,
+    3,    5,    3,    2,    2,    2,    2,    2,    2,    2,
+    2,
 };
 #if defined(__cplusplus) || defined(__STDC__)
 const short yydefred[] =
@@ -108,11 +113,12 @@ short yydefred[] =
 #endif
 	{                                      1,
     0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
-    0,    0,    0,    0,    2,    0,    0,    5,   10,    8,
-    9,   11,    0,    0,    0,    0,    0,   17,   12,   13,
-    0,    0,    0,    0,    0,    0,    0,   21,   14,    3,
-    4,    0,    7,    0,   16,    0,    0,   22,   23,   24,
-   25,   26,   27,   28,    0,    6,   19,
+    0,    0,    0,    0,    0,    0,    0,    2,    0,    0,
+    5,   10,    8,    9,   11,    0,    0,    0,    0,    0,
+   20,   13,   14,    0,    0,    0,    0,    0,    0,    0,
+   24,   15,   16,   12,   17,    3,    4,    0,    7,    0,
+   19,    0,    0,   25,   26,   27,   28,   29,   30,   31,
+    0,    6,   22,
 };
 #if defined(__cplusplus) || defined(__STDC__)
 const short yydgoto[] =
@@ -120,7 +126,7 @@ const short yydgoto[] =
 short yydgoto[] =
 #endif
 	{                                       1,
-   22,   44,   16,   17,   38,
+   25,   50,   19,   20,   41,
 };
 #if defined(__cplusplus) || defined(__STDC__)
 const short yysindex[] =
@@ -128,12 +134,13 @@ const short yysindex[] =
 short yysindex[] =
 #endif
 	{                                      0,
-  -10,    2, -266, -257, -265, -263, -262, -260, -259, -258,
- -256, -255, -270, -254,    0,    4,    7,    0,    0,    0,
-    0,    0, -253, -251, -250, -251, -251,    0,    0,    0,
- -249, -248, -247, -246, -245, -244, -243,    0,    0,    0,
-    0, -242,    0, -240,    0, -240, -240,    0,    0,    0,
-    0,    0,    0,    0, -239,    0,    0,};
+  -10,    2, -269, -257, -268, -266, -265, -263, -262, -261,
+ -260, -259, -273, -258, -256, -257, -255,    0,    4,    7,
+    0,    0,    0,    0,    0, -254, -252, -251, -252, -252,
+    0,    0,    0, -250, -249, -248, -247, -246, -245, -244,
+    0,    0,    0,    0,    0,    0,    0, -243,    0, -241,
+    0, -241, -241,    0,    0,    0,    0,    0,    0,    0,
+ -240,    0,    0,};
 #if defined(__cplusplus) || defined(__STDC__)
 const short yyrindex[] =
 #else
@@ -144,28 +151,29 @@ short yyrindex[] =
     0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
     0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
     0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
-    0,    0,    0,   12,    0,    2,   13,    0,    0,    0,
-    0,    0,    0,    0,    0,    0,    0,};
+    0,    0,    0,    0,    0,    0,    0,    0,    0,   12,
+    0,    2,   16,    0,    0,    0,    0,    0,    0,    0,
+    0,    0,    0,};
 #if defined(__cplusplus) || defined(__STDC__)
 const short yygindex[] =
 #else
 short yygindex[] =
 #endif
 	{                                      0,
-    0,  -16,    0,    0,    0,
+   23,  -19,    0,    0,    0,
 };
-#define YYTABLESIZE 260
+#define YYTABLESIZE 263
 #if defined(__cplusplus) || defined(__STDC__)
 const short yytable[] =
 #else
 short yytable[] =
 #endif
-	{                                      15,
-   31,   32,   33,   34,   35,   36,   37,   20,   21,   46,
-   47,   18,   19,   40,   23,   24,   41,   25,   26,   27,
-   28,   20,   15,   29,   30,   39,   42,   43,   45,   48,
-   49,   50,   51,   52,   53,   54,    0,   55,   56,    0,
-   57,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	{                                      18,
+   34,   35,   36,   37,   38,   39,   40,   23,   24,   52,
+   53,   21,   22,   46,   26,   27,   47,   28,   29,   30,
+   31,   23,   32,   33,   42,   18,   43,   45,   48,   49,
+   51,   54,   55,   56,   57,   58,   59,   60,   44,   61,
+   62,    0,   63,    0,    0,    0,    0,    0,    0,    0,
     0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
     0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
     0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
@@ -187,6 +195,7 @@ short yytable[] =
     0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
     0,    0,    0,    0,    0,    2,    3,    4,    5,    6,
     7,    8,    9,   10,    0,    0,   11,   12,   13,   14,
+   15,   16,   17,
 };
 #if defined(__cplusplus) || defined(__STDC__)
 const short yycheck[] =
@@ -194,11 +203,11 @@ const short yycheck[] =
 short yycheck[] =
 #endif
 	{                                      10,
-  271,  272,  273,  274,  275,  276,  277,  265,  266,   26,
-   27,   10,  279,   10,  280,  279,   10,  280,  279,  279,
-  279,   10,   10,  280,  280,  280,  280,  279,  279,  279,
-  279,  279,  279,  279,  279,  279,   -1,  280,  279,   -1,
-  280,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,
+  274,  275,  276,  277,  278,  279,  280,  265,  266,   29,
+   30,   10,  282,   10,  283,  282,   10,  283,  282,  282,
+  282,   10,  283,  283,  283,   10,  283,  283,  283,  282,
+  282,  282,  282,  282,  282,  282,  282,  282,   16,  283,
+  282,   -1,  283,   -1,   -1,   -1,   -1,   -1,   -1,   -1,
    -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,
    -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,
    -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,
@@ -220,12 +229,13 @@ short yycheck[] =
    -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,   -1,
    -1,   -1,   -1,   -1,   -1,  256,  257,  258,  259,  260,
   261,  262,  263,  264,   -1,   -1,  267,  268,  269,  270,
+  271,  272,  273,
 };
 #define YYFINAL 1
 #ifndef YYDEBUG
 #define YYDEBUG 0
 #endif
-#define YYMAXTOKEN 280
+#define YYMAXTOKEN 283
 #if YYDEBUG
 #if defined(__cplusplus) || defined(__STDC__)
 const char * const yyname[] =
@@ -241,8 +251,9 @@ char *yyname[] =
 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,"FONTNAME","STICKY","GAP",
 "MOUSEBIND","AUTOGROUP","BIND","COMMAND","IGNORE","YES","NO","BORDERWIDTH",
-"MOVEAMOUNT","COLOR","SNAPDIST","ACTIVEBORDER","INACTIVEBORDER","GROUPBORDER",
-"UNGROUPBORDER","MENUBG","MENUFG","FONTCOLOR","ERROR","STRING","NUMBER",
+"MOVEAMOUNT","COLOR","SNAPDIST","FILTERTHREADS","PATHCACHE","WATCHDOG",
+"ACTIVEBORDER","INACTIVEBORDER","GROUPBORDER","UNGROUPBORDER","MENUBG","MENUFG",
+"FONTCOLOR","ERROR","STRING","NUMBER",
 };
 #if defined(__cplusplus) || defined(__STDC__)
 const char * const yyrule[] =
@@ -261,9 +272,12 @@ char *yyrule[] =
 "yesno : NO",
 "main : FONTNAME STRING",
 "main : STICKY yesno",
+"main : PATHCACHE yesno",
 "main : BORDERWIDTH NUMBER",
 "main : MOVEAMOUNT NUMBER",
 "main : SNAPDIST NUMBER",
+"main : FILTERTHREADS NUMBER",
+"main : WATCHDOG NUMBER",
 "main : COMMAND STRING string",
 "main : AUTOGROUP NUMBER STRING",
 "main : IGNORE STRING",
@@ -305,7 +319,7 @@ short *yyss;
 short *yysslim;
 YYSTYPE *yyvs;
 int yystacksize;
-#line 202 "parse.y"
+#line 221 "parse.y"
 
 struct keywords {
 	const char	*k_name;
@@ -343,6 +357,7 @@ lookup(char *s)
 		{ "borderwidth",	BORDERWIDTH},
 		{ "color",		COLOR},
 		{ "command",		COMMAND},
+		{ "filterthreads",	FILTERTHREADS},
 		{ "font",		FONTCOLOR},
 		{ "fontname",		FONTNAME},
 		{ "gap",		GAP},
@@ -354,9 +369,11 @@ lookup(char *s)
 		{ "mousebind",		MOUSEBIND},
 		{ "moveamount",		MOVEAMOUNT},
 		{ "no",			NO},
+		{ "pathcache",		PATHCACHE},
 		{ "snapdist",		SNAPDIST},
 		{ "sticky",		STICKY},
 		{ "ungroupborder",	UNGROUPBORDER},
+		{ "watchdog",		WATCHDOG},
 		{ "yes",		YES}
 	};
 	const struct keywords	*p;
@@ -585,8 +602,8 @@ pushfile(const char *name)
 	nfile->name = xstrdup(name);
 
 	if ((nfile->stream = fopen(nfile->name, "r")) == NULL) {
-		free(nfile->name);
-		free(nfile);
+		xfree(nfile->name);
+		xfree(nfile);
 		return (NULL);
 	}
 	nfile->lineno = 1;
@@ -603,8 +620,8 @@ popfile(void)
 		prev->errors += file->errors;
 		TAILQ_REMOVE(&files, file, entry);
 		fclose(file->stream);
-		free(file->name);
-		free(file);
+		xfree(file->name);
+		xfree(file);
 		file = prev;
 		return (0);
 	}
@@ -619,7 +636,7 @@ parse_config(const char *filename, struct conf *xconf)
 	conf = xcalloc(1, sizeof(*conf));
 
 	if ((file = pushfile(filename)) == NULL) {
-		free(conf);
+		xfree(conf);
 		return (-1);
 	}
 
@@ -649,6 +666,8 @@ parse_config(const char *filename, struct conf *xconf)
 		xconf->bwidth = conf->bwidth;
 		xconf->mamount = conf->mamount;
 		xconf->snapdist = conf->snapdist;
+		xconf->filterthreads = conf->filterthreads;
+		xconf->watchdog = conf->watchdog;
 		xconf->gap = conf->gap;
 
 		while ((cmd = TAILQ_FIRST(&conf->cmdq)) != NULL) {
@@ -687,11 +706,11 @@ parse_config(const char *filename, struct conf *xconf)
 		xconf->font = conf->font;
 	}
 
-	free(conf);
+	xfree(conf);
 
 	return (errors ? -1 : 0);
 }
-#line 643 "y.tab.c"
+#line 658 "y.tab.c"
 /* allocate initial stack or double stack size, up to YYMAXDEPTH */
 #if defined(__cplusplus) || defined(__STDC__)
 static int yygrowstack(void)
@@ -903,33 +922,32 @@ break;
 case 6:
 #line 91 "parse.y"
 {
-			if (asprintf(&yyval.v.string, "%s %s", yyvsp[-1].v.string, yyvsp[0].v.string) == -1) {
-				free(yyvsp[-1].v.string);
-				free(yyvsp[0].v.string);
-				yyerror("string: asprintf");
-				YYERROR;
-			}
-			free(yyvsp[-1].v.string);
-			free(yyvsp[0].v.string);
+			size_t	 len = strlen(yyvsp[-1].v.string) + strlen(yyvsp[0].v.string) + 2;
+
+			/* Not asprintf(3): the words are freed with xfree(). */
+			yyval.v.string = xmalloc(len);
+			(void)snprintf(yyval.v.string, len, "%s %s", yyvsp[-1].v.string, yyvsp[0].v.string);
+			xfree(yyvsp[-1].v.string);
+			xfree(yyvsp[0].v.string);
 		}
 break;
 case 8:
-#line 104 "parse.y"
+#line 103 "parse.y"
 { yyval.v.number = 1; }
 break;
 case 9:
-#line 105 "parse.y"
+#line 104 "parse.y"
 { yyval.v.number = 0; }
 break;
 case 10:
-#line 108 "parse.y"
+#line 107 "parse.y"
 {
-			free(conf->font);
+			xfree(conf->font);
 			conf->font = yyvsp[0].v.string;
 		}
 break;
 case 11:
-#line 112 "parse.y"
+#line 111 "parse.y"
 {
 			if (yyvsp[0].v.number == 0)
 				conf->flags &= ~CONF_STICKY_GROUPS;
@@ -938,46 +956,75 @@ case 11:
 		}
 break;
 case 12:
-#line 118 "parse.y"
+#line 117 "parse.y"
 {
-			conf->bwidth = yyvsp[0].v.number;
+			if (yyvsp[0].v.number == 0)
+				conf->flags &= ~CONF_PATHCACHE;
+			else
+				conf->flags |= CONF_PATHCACHE;
 		}
 break;
 case 13:
-#line 121 "parse.y"
+#line 123 "parse.y"
 {
-			conf->mamount = yyvsp[0].v.number;
+			conf->bwidth = yyvsp[0].v.number;
 		}
 break;
 case 14:
-#line 124 "parse.y"
+#line 126 "parse.y"
 {
-			conf->snapdist = yyvsp[0].v.number;
+			conf->mamount = yyvsp[0].v.number;
 		}
 break;
 case 15:
-#line 127 "parse.y"
+#line 129 "parse.y"
 {
-			conf_cmd_add(conf, yyvsp[0].v.string, yyvsp[-1].v.string, 0);
-			free(yyvsp[-1].v.string);
-			free(yyvsp[0].v.string);
+			conf->snapdist = yyvsp[0].v.number;
 		}
 break;
 case 16:
 #line 132 "parse.y"
+{
+			if (yyvsp[0].v.number < 0) {
+				yyerror("invalid filterthreads: %d", yyvsp[0].v.number);
+				YYERROR;
+			}
+			conf->filterthreads = yyvsp[0].v.number;
+		}
+break;
+case 17:
+#line 139 "parse.y"
+{
+			if (yyvsp[0].v.number < 0) {
+				yyerror("invalid watchdog: %d", yyvsp[0].v.number);
+				YYERROR;
+			}
+			conf->watchdog = yyvsp[0].v.number;
+		}
+break;
+case 18:
+#line 146 "parse.y"
+{
+			conf_cmd_add(conf, yyvsp[0].v.string, yyvsp[-1].v.string, 0);
+			xfree(yyvsp[-1].v.string);
+			xfree(yyvsp[0].v.string);
+		}
+break;
+case 19:
+#line 151 "parse.y"
 {
 			if (yyvsp[-1].v.number < 0 || yyvsp[-1].v.number > 9) {
-				free(yyvsp[0].v.string);
+				xfree(yyvsp[0].v.string);
 				yyerror("autogroup number out of range: %d", yyvsp[-1].v.number);
 				YYERROR;
 			}
 
 			group_make_autogroup(conf, yyvsp[0].v.string, yyvsp[-1].v.number);
-			free(yyvsp[0].v.string);
+			xfree(yyvsp[0].v.string);
 		}
 break;
-case 17:
-#line 142 "parse.y"
+case 20:
+#line 161 "parse.y"
 {
 			struct winmatch	*wm;
 
@@ -985,19 +1032,19 @@ case 17:
 			(void)strlcpy(wm->title, yyvsp[0].v.string, sizeof(wm->title));
 			TAILQ_INSERT_TAIL(&conf->ignoreq, wm, entry);
 
-			free(yyvsp[0].v.string);
+			xfree(yyvsp[0].v.string);
 		}
 break;
-case 18:
-#line 151 "parse.y"
+case 21:
+#line 170 "parse.y"
 {
 			conf_bindname(conf, yyvsp[-1].v.string, yyvsp[0].v.string);
-			free(yyvsp[-1].v.string);
-			free(yyvsp[0].v.string);
+			xfree(yyvsp[-1].v.string);
+			xfree(yyvsp[0].v.string);
 		}
 break;
-case 19:
-#line 156 "parse.y"
+case 22:
+#line 175 "parse.y"
 {
 			conf->gap.top = yyvsp[-3].v.number;
 			conf->gap.bottom = yyvsp[-2].v.number;
@@ -1005,64 +1052,64 @@ case 19:
 			conf->gap.right = yyvsp[0].v.number;
 		}
 break;
-case 20:
-#line 162 "parse.y"
+case 23:
+#line 181 "parse.y"
 {
 			conf_mousebind(conf, yyvsp[-1].v.string, yyvsp[0].v.string);
-			free(yyvsp[-1].v.string);
-			free(yyvsp[0].v.string);
+			xfree(yyvsp[-1].v.string);
+			xfree(yyvsp[0].v.string);
 		}
 break;
-case 22:
-#line 172 "parse.y"
+case 25:
+#line 191 "parse.y"
 {
-			free(conf->color[CWM_COLOR_BORDER_ACTIVE].name);
+			xfree(conf->color[CWM_COLOR_BORDER_ACTIVE].name);
 			conf->color[CWM_COLOR_BORDER_ACTIVE].name = yyvsp[0].v.string;
 		}
 break;
-case 23:
-#line 176 "parse.y"
+case 26:
+#line 195 "parse.y"
 {
-			free(conf->color[CWM_COLOR_BORDER_INACTIVE].name);
+			xfree(conf->color[CWM_COLOR_BORDER_INACTIVE].name);
 			conf->color[CWM_COLOR_BORDER_INACTIVE].name = yyvsp[0].v.string;
 		}
 break;
-case 24:
-#line 180 "parse.y"
+case 27:
+#line 199 "parse.y"
 {
-			free(conf->color[CWM_COLOR_BORDER_GROUP].name);
+			xfree(conf->color[CWM_COLOR_BORDER_GROUP].name);
 			conf->color[CWM_COLOR_BORDER_GROUP].name = yyvsp[0].v.string;
 		}
 break;
-case 25:
-#line 184 "parse.y"
+case 28:
+#line 203 "parse.y"
 {
-			free(conf->color[CWM_COLOR_BORDER_UNGROUP].name);
+			xfree(conf->color[CWM_COLOR_BORDER_UNGROUP].name);
 			conf->color[CWM_COLOR_BORDER_UNGROUP].name = yyvsp[0].v.string;
 		}
 break;
-case 26:
-#line 188 "parse.y"
+case 29:
+#line 207 "parse.y"
 {
-			free(conf->color[CWM_COLOR_BG_MENU].name);
+			xfree(conf->color[CWM_COLOR_BG_MENU].name);
 			conf->color[CWM_COLOR_BG_MENU].name = yyvsp[0].v.string;
 		}
 break;
-case 27:
-#line 192 "parse.y"
+case 30:
+#line 211 "parse.y"
 {
-			free(conf->color[CWM_COLOR_FG_MENU].name);
+			xfree(conf->color[CWM_COLOR_FG_MENU].name);
 			conf->color[CWM_COLOR_FG_MENU].name = yyvsp[0].v.string;
 		}
 break;
-case 28:
-#line 196 "parse.y"
+case 31:
+#line 215 "parse.y"
 {
-			free(conf->color[CWM_COLOR_FONT].name);
+			xfree(conf->color[CWM_COLOR_FONT].name);
 			conf->color[CWM_COLOR_FONT].name = yyvsp[0].v.string;
 		}
 break;
-#line 1014 "y.tab.c"
+#line 1057 "y.tab.c"
     }
     yyssp -= yym;
     yystate = *yyssp;
@@ -70,7 +70,7 @@ typedef struct {
 %token	FONTNAME STICKY GAP MOUSEBIND
 %token	AUTOGROUP BIND COMMAND IGNORE
 %token	YES NO BORDERWIDTH MOVEAMOUNT
-%token	COLOR SNAPDIST
+%token	COLOR SNAPDIST FILTERTHREADS PATHCACHE WATCHDOG
 %token	ACTIVEBORDER INACTIVEBORDER
 %token	GROUPBORDER UNGROUPBORDER
 %token	MENUBG MENUFG FONTCOLOR
@@ -89,14 +89,13 @@ grammar		: /* empty */
 		;
 
 string		: string STRING			{
-			if (asprintf(&$$, "%s %s", $1, $2) == -1) {
-				free($1);
-				free($2);
-				yyerror("string: asprintf");
-				YYERROR;
-			}
-			free($1);
-			free($2);
+			size_t	 len = strlen($1) + strlen($2) + 2;
+
+			/* Not asprintf(3): the words are freed with xfree(). */
+			$$ = xmalloc(len);
+			(void)snprintf($$, len, "%s %s", $1, $2);
+			xfree($1);
+			xfree($2);
 		}
 		| STRING
 		;
@@ -106,7 +105,7 @@ yesno		: YES				{ $$ = 1; }
 		;
 
 main		: FONTNAME STRING		{
-			free(conf->font);
+			xfree(conf->font);
 			conf->font = $2;
 		}
 		| STICKY yesno {
@@ -115,6 +114,12 @@ main		: FONTNAME STRING		{
 			else
 				conf->flags |= CONF_STICKY_GROUPS;
 		}
+		| PATHCACHE yesno {
+			if ($2 == 0)
+				conf->flags &= ~CONF_PATHCACHE;
+			else
+				conf->flags |= CONF_PATHCACHE;
+		}
 		| BORDERWIDTH NUMBER {
 			conf->bwidth = $2;
 		}
@@ -124,20 +129,34 @@ main		: FONTNAME STRING		{
 		| SNAPDIST NUMBER {
 			conf->snapdist = $2;
 		}
+		| FILTERTHREADS NUMBER {
+			if ($2 < 0) {
+				yyerror("invalid filterthreads: %d", $2);
+				YYERROR;
+			}
+			conf->filterthreads = $2;
+		}
+		| WATCHDOG NUMBER {
+			if ($2 < 0) {
+				yyerror("invalid watchdog: %d", $2);
+				YYERROR;
+			}
+			conf->watchdog = $2;
+		}
 		| COMMAND STRING string		{
 			conf_cmd_add(conf, $3, $2, 0);
-			free($2);
-			free($3);
+			xfree($2);
+			xfree($3);
 		}
 		| AUTOGROUP NUMBER STRING	{
 			if ($2 < 0 || $2 > 9) {
-				free($3);
+				xfree($3);
 				yyerror("autogroup number out of range: %d", $2);
 				YYERROR;
 			}
 
 			group_make_autogroup(conf, $3, $2);
-			free($3);
+			xfree($3);
 		}
 		| IGNORE STRING {
 			struct winmatch	*wm;
@@ -146,12 +165,12 @@ main		: FONTNAME STRING		{
 			(void)strlcpy(wm->title, $2, sizeof(wm->title));
 			TAILQ_INSERT_TAIL(&conf->ignoreq, wm, entry);
 
-			free($2);
+			xfree($2);
 		}
 		| BIND STRING string		{
 			conf_bindname(conf, $2, $3);
-			free($2);
-			free($3);
+			xfree($2);
+			xfree($3);
 		}
 		| GAP NUMBER NUMBER NUMBER NUMBER {
 			conf->gap.top = $2;
@@ -161,8 +180,8 @@ main		: FONTNAME STRING		{
 		}
 		| MOUSEBIND STRING string	{
 			conf_mousebind(conf, $2, $3);
-			free($2);
-			free($3);
+			xfree($2);
+			xfree($3);
 		}
 		;
 
@@ -170,31 +189,31 @@ color		: COLOR colors
 		;
 
 colors		: ACTIVEBORDER STRING {
-			free(conf->color[CWM_COLOR_BORDER_ACTIVE].name);
+			xfree(conf->color[CWM_COLOR_BORDER_ACTIVE].name);
 			conf->color[CWM_COLOR_BORDER_ACTIVE].name = $2;
 		}
 		| INACTIVEBORDER STRING {
-			free(conf->color[CWM_COLOR_BORDER_INACTIVE].name);
+			xfree(conf->color[CWM_COLOR_BORDER_INACTIVE].name);
 			conf->color[CWM_COLOR_BORDER_INACTIVE].name = $2;
 		}
 		| GROUPBORDER STRING {
-			free(conf->color[CWM_COLOR_BORDER_GROUP].name);
+			xfree(conf->color[CWM_COLOR_BORDER_GROUP].name);
 			conf->color[CWM_COLOR_BORDER_GROUP].name = $2;
 		}
 		| UNGROUPBORDER STRING {
-			free(conf->color[CWM_COLOR_BORDER_UNGROUP].name);
+			xfree(conf->color[CWM_COLOR_BORDER_UNGROUP].name);
 			conf->color[CWM_COLOR_BORDER_UNGROUP].name = $2;
 		}
 		| MENUBG STRING {
-			free(conf->color[CWM_COLOR_BG_MENU].name);
+			xfree(conf->color[CWM_COLOR_BG_MENU].name);
 			conf->color[CWM_COLOR_BG_MENU].name = $2;
 		}
 		| MENUFG STRING {
-			free(conf->color[CWM_COLOR_FG_MENU].name);
+			xfree(conf->color[CWM_COLOR_FG_MENU].name);
 			conf->color[CWM_COLOR_FG_MENU].name = $2;
 		}
 		| FONTCOLOR STRING {
-			free(conf->color[CWM_COLOR_FONT].name);
+			xfree(conf->color[CWM_COLOR_FONT].name);
 			conf->color[CWM_COLOR_FONT].name = $2;
 		}
 		;
@@ -236,6 +255,7 @@ lookup(char *s)
 		{ "borderwidth",	BORDERWIDTH},
 		{ "color",		COLOR},
 		{ "command",		COMMAND},
+		{ "filterthreads",	FILTERTHREADS},
 		{ "font",		FONTCOLOR},
 		{ "fontname",		FONTNAME},
 		{ "gap",		GAP},
@@ -247,9 +267,11 @@ lookup(char *s)
 		{ "mousebind",		MOUSEBIND},
 		{ "moveamount",		MOVEAMOUNT},
 		{ "no",			NO},
+		{ "pathcache",		PATHCACHE},
 		{ "snapdist",		SNAPDIST},
 		{ "sticky",		STICKY},
 		{ "ungroupborder",	UNGROUPBORDER},
+		{ "watchdog",		WATCHDOG},
 		{ "yes",		YES}
 	};
 	const struct keywords	*p;
@@ -478,8 +500,8 @@ pushfile(const char *name)
 	nfile->name = xstrdup(name);
 
 	if ((nfile->stream = fopen(nfile->name, "r")) == NULL) {
-		free(nfile->name);
-		free(nfile);
+		xfree(nfile->name);
+		xfree(nfile);
 		return (NULL);
 	}
 	nfile->lineno = 1;
@@ -496,8 +518,8 @@ popfile(void)
 		prev->errors += file->errors;
 		TAILQ_REMOVE(&files, file, entry);
 		fclose(file->stream);
-		free(file->name);
-		free(file);
+		xfree(file->name);
+		xfree(file);
 		file = prev;
 		return (0);
 	}
@@ -512,7 +534,7 @@ parse_config(const char *filename, struct conf *xconf)
 	conf = xcalloc(1, sizeof(*conf));
 
 	if ((file = pushfile(filename)) == NULL) {
-		free(conf);
+		xfree(conf);
 		return (-1);
 	}
 
@@ -542,6 +564,8 @@ parse_config(const char *filename, struct conf *xconf)
 		xconf->bwidth = conf->bwidth;
 		xconf->mamount = conf->mamount;
 		xconf->snapdist = conf->snapdist;
+		xconf->filterthreads = conf->filterthreads;
+		xconf->watchdog = conf->watchdog;
 		xconf->gap = conf->gap;
 
 		while ((cmd = TAILQ_FIRST(&conf->cmdq)) != NULL) {
@@ -580,7 +604,7 @@ parse_config(const char *filename, struct conf *xconf)
 		xconf->font = conf->font;
 	}
 
-	free(conf);
+	xfree(conf);
 
 	return (errors ? -1 : 0);
 }
@@ -0,0 +1,694 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Copyright (c) 2004 Martin Murray <mmurray@monkey.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Executables found in $PATH, cached per directory.  A directory is
+ * only read again when its device, inode or modification time differs
+ * from what was cached.  The cache may also be kept on disk so it
+ * survives restarts.
+ *
+ * All of this runs on threads of their own, one per directory up to a
+ * limit, which hand the names over one directory at a time, so the
+ * exec menu shows up at once and a slow or hung directory never
+ * stalls the window manager or the other directories.
+ *
+ * Note that making an existing file executable does not change the
+ * modification time of its directory and is not noticed.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include <dirent.h>
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <paths.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "calmwm.h"
+
+#define PATHCACHE_NPATHS	256
+#define PATHCACHE_MAXTHREADS	16
+#define PATHCACHE_MAGIC		"CWMPATH1"
+
+struct pathdir {
+	TAILQ_ENTRY(pathdir)	 entry;
+	char			*path;
+	dev_t			 dev;
+	ino_t			 ino;
+	struct timespec		 mtime;
+	char			*names;	/* NUL separated */
+	size_t			 namelen;
+	int			 nnames;
+	int			 used;
+};
+TAILQ_HEAD(pathdir_q, pathdir);
+
+/* On-disk record, followed by the path and the names. */
+struct pathdir_rec {
+	uint64_t		 dev;
+	uint64_t		 ino;
+	int64_t			 sec;
+	int64_t			 nsec;
+	uint32_t		 pathlen;
+	uint32_t		 namelen;
+	uint32_t		 nnames;
+	uint32_t		 pad;
+};
+
+/* The names of one directory, on their way to the menu. */
+struct pathbatch {
+	TAILQ_ENTRY(pathbatch)	 entry;
+	char			*names;
+	size_t			 namelen;
+	int			 nnames;
+};
+TAILQ_HEAD(pathbatch_q, pathbatch);
+
+/*
+ * One scan of $PATH, shared by the menu and the scanning threads; the
+ * last one to let go frees it.
+ */
+struct pathcache_job {
+	struct pathbatch_q	 batchq;
+	char			*path;
+	char			*paths[PATHCACHE_NPATHS];
+	int			 npaths;
+	int			 next;
+	struct {
+		dev_t		 dev;
+		ino_t		 ino;
+	}			 seen[PATHCACHE_NPATHS];
+	int			 nseen;
+	int			 fd[2];
+	int			 persist;
+	int			 nbusy;
+	int			 done;
+	int			 cancel;
+	int			 refs;
+};
+
+/*
+ * Protects the cache and all jobs.  The cache file is read and written
+ * without it, since the X thread takes it too.
+ */
+static pthread_mutex_t	 pathcache_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	 pathcache_cv = PTHREAD_COND_INITIALIZER;
+static struct pathdir_q	 pathdirq = TAILQ_HEAD_INITIALIZER(pathdirq);
+static int		 pathcache_loaded;	/* 1 while loading, 2 done */
+static int		 pathcache_dirty;
+
+static int		 pathcache_fill(struct menu_q *, void *);
+static struct pathdir	*pathcache_find(struct pathdir_q *, const char *);
+static void		 pathcache_free(struct pathdir *);
+static int		 pathcache_getfile(char *, size_t);
+static void		 pathcache_load(struct pathdir_q *);
+static void		 pathcache_post(struct pathcache_job *,
+			     struct pathbatch *);
+static void		 pathcache_release(struct pathcache_job *);
+static void		 pathcache_run(struct pathcache_job *);
+static int		 pathcache_seen(struct pathcache_job *,
+			     struct stat *);
+static int		 pathcache_save(struct pathdir_q *);
+static void		 pathcache_scan(const char *, struct pathbatch *);
+static void		*pathcache_worker(void *);
+
+/*
+ * Start looking for executables in $PATH, and set up feed to
+ * deliver them to the exec menu.  Without a pipe there is no feed:
+ * the executables are looked for here and put straight in menuq.
+ */
+void
+pathcache_start(struct menu_feed *feed, struct menu_q *menuq)
+{
+	struct pathcache_job	*job;
+	pthread_attr_t		 attr;
+	pthread_t		 tid;
+	sigset_t		 set, oset;
+	char			*path, *pathcpy, **ap;
+	int			 i, nthreads;
+
+	job = xcalloc(1, sizeof(*job));
+	TAILQ_INIT(&job->batchq);
+	if ((path = getenv("PATH")) == NULL)
+		path = _PATH_DEFPATH;
+	pathcpy = job->path = xstrdup(path);
+	job->persist = Conf.flags & CONF_PATHCACHE;
+
+	for (ap = job->paths; ap < &job->paths[PATHCACHE_NPATHS - 1] &&
+	    (*ap = strsep(&pathcpy, ":")) != NULL;) {
+		if (**ap != '\0')
+			ap++;
+	}
+	*ap = NULL;
+	job->npaths = ap - job->paths;
+
+	feed->fill = pathcache_fill;
+	feed->arg = job;
+
+	if (pipe(job->fd) == -1) {
+		warn("pathcache_start: pipe");
+		job->fd[0] = job->fd[1] = -1;
+		feed->fd = -1;
+		job->refs = 2;
+		job->nbusy = 1;
+		pathcache_run(job);
+		(void)pathcache_fill(menuq, job);
+		return;
+	}
+	for (i = 0; i < 2; i++) {
+		(void)fcntl(job->fd[i], F_SETFD, FD_CLOEXEC);
+		(void)fcntl(job->fd[i], F_SETFL, O_NONBLOCK);
+	}
+	feed->fd = job->fd[0];
+
+	nthreads = MAX(1, MIN(job->npaths, PATHCACHE_MAXTHREADS));
+	job->refs = 1 + nthreads;
+	job->nbusy = nthreads;
+
+	(void)pthread_attr_init(&attr);
+	(void)pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	/* Signals are for the main thread. */
+	(void)sigfillset(&set);
+	(void)pthread_sigmask(SIG_SETMASK, &set, &oset);
+	/* Hold the threads back until the counts are right. */
+	(void)pthread_mutex_lock(&pathcache_mtx);
+	for (i = 0; i < nthreads; i++)
+		if (pthread_create(&tid, &attr, pathcache_worker, job) != 0)
+			break;
+	if (i < nthreads) {
+		job->refs -= nthreads - i;
+		job->nbusy -= nthreads - i;
+	}
+	if (i == 0) {
+		/* Nobody to do the work; do it here. */
+		job->refs++;
+		job->nbusy++;
+	}
+	(void)pthread_mutex_unlock(&pathcache_mtx);
+	(void)pthread_sigmask(SIG_SETMASK, &oset, NULL);
+	(void)pthread_attr_destroy(&attr);
+
+	if (i == 0) {
+		warnx("pathcache_start: cannot create thread");
+		pathcache_run(job);
+	}
+}
+
+/*
+ * Done with the menu; a scan still in progress is abandoned.
+ */
+void
+pathcache_stop(struct menu_feed *feed)
+{
+	struct pathcache_job	*job = feed->arg;
+
+	(void)pthread_mutex_lock(&pathcache_mtx);
+	job->cancel = 1;
+	(void)pthread_mutex_unlock(&pathcache_mtx);
+
+	pathcache_release(job);
+	feed->arg = NULL;
+	feed->fd = -1;
+}
+
+/*
+ * Merge whatever the worker has found so far into menuq.
+ */
+static int
+pathcache_fill(struct menu_q *menuq, void *arg)
+{
+	struct pathcache_job	*job = arg;
+	struct pathbatch_q	 batchq;
+	struct pathbatch	*b;
+	struct menu_q		 addq;
+	struct menu		*mi;
+	char			 buf[64], *p;
+	int			 done, i;
+
+	while (read(job->fd[0], buf, sizeof(buf)) > 0)
+		;
+
+	TAILQ_INIT(&batchq);
+	(void)pthread_mutex_lock(&pathcache_mtx);
+	while ((b = TAILQ_FIRST(&job->batchq)) != NULL) {
+		TAILQ_REMOVE(&job->batchq, b, entry);
+		TAILQ_INSERT_TAIL(&batchq, b, entry);
+	}
+	done = job->done;
+	(void)pthread_mutex_unlock(&pathcache_mtx);
+
+	TAILQ_INIT(&addq);
+	while ((b = TAILQ_FIRST(&batchq)) != NULL) {
+		TAILQ_REMOVE(&batchq, b, entry);
+		for (p = b->names, i = 0; i < b->nnames;
+		    p += strlen(p) + 1, i++) {
+			/* Kept by menuq, though put on addq for now. */
+			mi = menuq_entry(menuq, NULL, p);
+			TAILQ_INSERT_TAIL(&addq, mi, entry);
+		}
+		xfree(b->names);
+		xfree(b);
+	}
+	search_merge(menuq, &addq);
+
+	return (!done);
+}
+
+static void *
+pathcache_worker(void *arg)
+{
+	pathcache_run(arg);
+	return (NULL);
+}
+
+/*
+ * Take directories off the job one at a time until none are left.
+ */
+static void
+pathcache_run(struct pathcache_job *job)
+{
+	struct pathdir_q	 fileq;
+	struct pathdir		*pd, *copy;
+	struct pathbatch	*b;
+	struct stat		 sb;
+	struct trace_span	 ts;
+	char			*dir;
+	int			 last, save = 0;
+
+	TAILQ_INIT(&fileq);
+	if (job->persist) {
+		(void)pthread_mutex_lock(&pathcache_mtx);
+		if (pathcache_loaded == 0) {
+			/* The others wait for the file rather than scan. */
+			pathcache_loaded = 1;
+			(void)pthread_mutex_unlock(&pathcache_mtx);
+			pathcache_load(&fileq);
+			(void)pthread_mutex_lock(&pathcache_mtx);
+			while ((pd = TAILQ_FIRST(&fileq)) != NULL) {
+				TAILQ_REMOVE(&fileq, pd, entry);
+				if (pathcache_find(&pathdirq, pd->path) == NULL)
+					TAILQ_INSERT_TAIL(&pathdirq, pd, entry);
+				else
+					pathcache_free(pd);
+			}
+			pathcache_loaded = 2;
+			(void)pthread_cond_broadcast(&pathcache_cv);
+		}
+		while (pathcache_loaded == 1)
+			(void)pthread_cond_wait(&pathcache_cv, &pathcache_mtx);
+		(void)pthread_mutex_unlock(&pathcache_mtx);
+	}
+
+	for (;;) {
+		(void)pthread_mutex_lock(&pathcache_mtx);
+		if (job->cancel || job->next >= job->npaths) {
+			(void)pthread_mutex_unlock(&pathcache_mtx);
+			break;
+		}
+		dir = job->paths[job->next++];
+		(void)pthread_mutex_unlock(&pathcache_mtx);
+
+		if (stat(dir, &sb) == -1 || !S_ISDIR(sb.st_mode))
+			continue;
+
+		b = xcalloc(1, sizeof(*b));
+
+		(void)pthread_mutex_lock(&pathcache_mtx);
+		if (pathcache_seen(job, &sb)) {
+			(void)pthread_mutex_unlock(&pathcache_mtx);
+			xfree(b);
+			continue;
+		}
+		if ((pd = pathcache_find(&pathdirq, dir)) != NULL &&
+		    pd->names != NULL && pd->dev == sb.st_dev &&
+		    pd->ino == sb.st_ino &&
+		    pd->mtime.tv_sec == sb.st_mtim.tv_sec &&
+		    pd->mtime.tv_nsec == sb.st_mtim.tv_nsec) {
+			b->names = xmalloc(pd->namelen + 1);
+			(void)memcpy(b->names, pd->names, pd->namelen + 1);
+			b->namelen = pd->namelen;
+			b->nnames = pd->nnames;
+			pd->used = 1;
+		}
+		(void)pthread_mutex_unlock(&pathcache_mtx);
+
+		if (b->names == NULL) {
+			/* The stamp is taken first, so changes during the
+			 * scan get picked up next time. */
+			trace_begin(&ts, "pathcache_scan", 0);
+			pathcache_scan(dir, b);
+			ts.arg = b->nnames;
+			trace_end(&ts);
+
+			(void)pthread_mutex_lock(&pathcache_mtx);
+			if ((pd = pathcache_find(&pathdirq, dir)) == NULL) {
+				pd = xcalloc(1, sizeof(*pd));
+				pd->path = xstrdup(dir);
+				TAILQ_INSERT_TAIL(&pathdirq, pd, entry);
+			}
+			xfree(pd->names);
+			pd->names = xmalloc(b->namelen + 1);
+			(void)memcpy(pd->names, b->names, b->namelen + 1);
+			pd->namelen = b->namelen;
+			pd->nnames = b->nnames;
+			pd->dev = sb.st_dev;
+			pd->ino = sb.st_ino;
+			pd->mtime = sb.st_mtim;
+			pd->used = 1;
+			pathcache_dirty = 1;
+			(void)pthread_mutex_unlock(&pathcache_mtx);
+		}
+
+		pathcache_post(job, b);
+	}
+
+	(void)pthread_mutex_lock(&pathcache_mtx);
+	if ((last = (--job->nbusy == 0))) {
+		if (job->persist && pathcache_dirty) {
+			/* Only what is still in $PATH is worth keeping. */
+			TAILQ_FOREACH(pd, &pathdirq, entry) {
+				if (!pd->used || pd->names == NULL)
+					continue;
+				copy = xmalloc(sizeof(*copy));
+				*copy = *pd;
+				copy->path = xstrdup(pd->path);
+				copy->names = xmalloc(pd->namelen + 1);
+				(void)memcpy(copy->names, pd->names,
+				    pd->namelen + 1);
+				TAILQ_INSERT_TAIL(&fileq, copy, entry);
+			}
+			pathcache_dirty = 0;
+			save = 1;
+		}
+		job->done = 1;
+	}
+	(void)pthread_mutex_unlock(&pathcache_mtx);
+	if (last)
+		(void)write(job->fd[1], "", 1);
+
+	if (save && pathcache_save(&fileq) == -1) {
+		(void)pthread_mutex_lock(&pathcache_mtx);
+		pathcache_dirty = 1;
+		(void)pthread_mutex_unlock(&pathcache_mtx);
+	}
+	while ((pd = TAILQ_FIRST(&fileq)) != NULL) {
+		TAILQ_REMOVE(&fileq, pd, entry);
+		pathcache_free(pd);
+	}
+
+	pathcache_release(job);
+}
+
+/*
+ * Skip repeated entries, and symlinks to directories already visited.
+ * Called with the lock held.
+ */
+static int
+pathcache_seen(struct pathcache_job *job, struct stat *sb)
+{
+	int	 i;
+
+	for (i = 0; i < job->nseen; i++)
+		if (job->seen[i].dev == sb->st_dev &&
+		    job->seen[i].ino == sb->st_ino)
+			return (1);
+
+	job->seen[job->nseen].dev = sb->st_dev;
+	job->seen[job->nseen].ino = sb->st_ino;
+	job->nseen++;
+
+	return (0);
+}
+
+static void
+pathcache_post(struct pathcache_job *job, struct pathbatch *b)
+{
+	(void)pthread_mutex_lock(&pathcache_mtx);
+	if (job->cancel) {
+		xfree(b->names);
+		xfree(b);
+		b = NULL;
+	} else
+		TAILQ_INSERT_TAIL(&job->batchq, b, entry);
+	(void)pthread_mutex_unlock(&pathcache_mtx);
+
+	/* A full pipe already has the reader's attention. */
+	if (b != NULL)
+		(void)write(job->fd[1], "", 1);
+}
+
+static void
+pathcache_release(struct pathcache_job *job)
+{
+	struct pathbatch	*b;
+	int			 refs;
+
+	(void)pthread_mutex_lock(&pathcache_mtx);
+	refs = --job->refs;
+	(void)pthread_mutex_unlock(&pathcache_mtx);
+	if (refs > 0)
+		return;
+
+	while ((b = TAILQ_FIRST(&job->batchq)) != NULL) {
+		TAILQ_REMOVE(&job->batchq, b, entry);
+		xfree(b->names);
+		xfree(b);
+	}
+	if (job->fd[0] != -1) {
+		(void)close(job->fd[0]);
+		(void)close(job->fd[1]);
+	}
+	xfree(job->path);
+	xfree(job);
+}
+
+static struct pathdir *
+pathcache_find(struct pathdir_q *pdq, const char *path)
+{
+	struct pathdir	*pd;
+
+	TAILQ_FOREACH(pd, pdq, entry)
+		if (strcmp(pd->path, path) == 0)
+			return (pd);
+
+	return (NULL);
+}
+
+static void
+pathcache_free(struct pathdir *pd)
+{
+	xfree(pd->names);
+	xfree(pd->path);
+	xfree(pd);
+}
+
+/*
+ * Collect the names of the executables in dir.  Everything is looked
+ * up relative to the directory; only symlinks, and file systems that
+ * do not report a file type, need a stat to tell files from
+ * directories.
+ */
+static void
+pathcache_scan(const char *dir, struct pathbatch *b)
+{
+	DIR		*dirp;
+	struct dirent	*dp;
+	struct stat	 sb;
+	size_t		 len, size = 0;
+	int		 fd;
+
+	if ((fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1) {
+		b->names = xcalloc(1, 1);
+		return;
+	}
+	if ((dirp = fdopendir(fd)) == NULL) {
+		(void)close(fd);
+		b->names = xcalloc(1, 1);
+		return;
+	}
+
+	while ((dp = readdir(dirp)) != NULL) {
+		switch (dp->d_type) {
+		case DT_REG:
+			break;
+		case DT_LNK:
+		case DT_UNKNOWN:
+			if (fstatat(fd, dp->d_name, &sb, 0) == -1 ||
+			    !S_ISREG(sb.st_mode))
+				continue;
+			break;
+		default:
+			continue;
+		}
+		if (faccessat(fd, dp->d_name, X_OK, AT_EACCESS) != 0)
+			continue;
+
+		len = strlen(dp->d_name) + 1;
+		if (b->namelen + len + 1 > size) {
+			size = MAX(size * 2, b->namelen + len + 1024);
+			b->names = xrealloc(b->names, size);
+		}
+		(void)memcpy(b->names + b->namelen, dp->d_name, len);
+		b->namelen += len;
+		b->nnames++;
+	}
+	/* closes fd as well */
+	(void)closedir(dirp);
+
+	if (b->names == NULL)
+		b->names = xcalloc(1, 1);
+	else
+		b->names[b->namelen] = '\0';
+}
+
+static int
+pathcache_getfile(char *buf, size_t len)
+{
+	char	*home;
+	int	 l;
+
+	if ((home = getenv("HOME")) == NULL)
+		return (-1);
+
+	l = snprintf(buf, len, "%s/%s", home, PATHCACHEFILE);
+	if (l == -1 || l >= len)
+		return (-1);
+
+	return (0);
+}
+
+/*
+ * Read the cache file onto pdq.
+ */
+static void
+pathcache_load(struct pathdir_q *pdq)
+{
+	struct pathdir_rec	 rec;
+	struct pathdir		*pd;
+	FILE			*fp;
+	char			 filename[MAXPATHLEN], magic[8];
+	uint32_t		 i, n;
+
+	if (pathcache_getfile(filename, sizeof(filename)) == -1)
+		return;
+	if ((fp = fopen(filename, "r")) == NULL)
+		return;
+
+	if (fread(magic, sizeof(magic), 1, fp) != 1 ||
+	    memcmp(magic, PATHCACHE_MAGIC, sizeof(magic)) != 0)
+		goto out;
+
+	while (fread(&rec, sizeof(rec), 1, fp) == 1) {
+		if (rec.pathlen == 0 || rec.pathlen > MAXPATHLEN ||
+		    rec.namelen > 64 * 1024 * 1024)
+			break;
+
+		pd = xcalloc(1, sizeof(*pd));
+		pd->path = xcalloc(1, rec.pathlen + 1);
+		pd->names = xcalloc(1, rec.namelen + 1);
+		if (fread(pd->path, rec.pathlen, 1, fp) != 1 ||
+		    (rec.namelen > 0 &&
+		    fread(pd->names, rec.namelen, 1, fp) != 1) ||
+		    (rec.namelen > 0 && pd->names[rec.namelen - 1] != '\0') ||
+		    pathcache_find(pdq, pd->path) != NULL) {
+			pathcache_free(pd);
+			break;
+		}
+		/* The names are walked by count; it has to add up. */
+		for (i = 0, n = 0; i < rec.namelen; i++)
+			if (pd->names[i] == '\0')
+				n++;
+		if (n != rec.nnames) {
+			pathcache_free(pd);
+			break;
+		}
+		pd->dev = rec.dev;
+		pd->ino = rec.ino;
+		pd->mtime.tv_sec = rec.sec;
+		pd->mtime.tv_nsec = rec.nsec;
+		pd->namelen = rec.namelen;
+		pd->nnames = rec.nnames;
+		TAILQ_INSERT_TAIL(pdq, pd, entry);
+	}
+out:
+	(void)fclose(fp);
+}
+
+/*
+ * Write the directories on pdq to the cache file.
+ */
+static int
+pathcache_save(struct pathdir_q *pdq)
+{
+	struct pathdir_rec	 rec;
+	struct pathdir		*pd;
+	FILE			*fp;
+	char			 filename[MAXPATHLEN], tmpname[MAXPATHLEN];
+	int			 fd, l;
+
+	if (pathcache_getfile(filename, sizeof(filename)) == -1)
+		return (-1);
+	l = snprintf(tmpname, sizeof(tmpname), "%s.XXXXXXXXXX", filename);
+	if (l == -1 || l >= sizeof(tmpname))
+		return (-1);
+
+	if ((fd = mkstemp(tmpname)) == -1) {
+		warn("%s", tmpname);
+		return (-1);
+	}
+	if ((fp = fdopen(fd, "w")) == NULL) {
+		warn("%s", tmpname);
+		(void)close(fd);
+		(void)unlink(tmpname);
+		return (-1);
+	}
+
+	(void)fwrite(PATHCACHE_MAGIC, strlen(PATHCACHE_MAGIC), 1, fp);
+	TAILQ_FOREACH(pd, pdq, entry) {
+		bzero(&rec, sizeof(rec));
+		rec.dev = pd->dev;
+		rec.ino = pd->ino;
+		rec.sec = pd->mtime.tv_sec;
+		rec.nsec = pd->mtime.tv_nsec;
+		rec.pathlen = strlen(pd->path);
+		rec.namelen = pd->namelen;
+		rec.nnames = pd->nnames;
+		(void)fwrite(&rec, sizeof(rec), 1, fp);
+		(void)fwrite(pd->path, rec.pathlen, 1, fp);
+		if (pd->namelen > 0)
+			(void)fwrite(pd->names, pd->namelen, 1, fp);
+	}
+
+	if (fclose(fp) == EOF || rename(tmpname, filename) == -1) {
+		warn("%s", filename);
+		(void)unlink(tmpname);
+		return (-1);
+	}
+
+	return (0);
+}
@@ -0,0 +1,130 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Copyright (c) 2004 Martin Murray <mmurray@monkey.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Pools of fixed size items, for records that come and go all the time.
+ * Items are cut from slabs and kept on a free list when put back; the
+ * slabs themselves are never given back, so once a pool has grown to
+ * what is needed it does not call malloc again.
+ */
+
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "calmwm.h"
+
+#define POOL_SLABSIZE	(16 * 1024)
+
+struct pool_item {
+	struct pool_item	*next;
+};
+
+struct pool_slab {
+	struct pool_slab	*next;
+};
+
+#define POOL_MAXPOOLS	32
+
+static void	 pool_grow(struct pool *);
+
+/* Every pool that has grown, for pool_dump(). */
+static struct pool	*pool_list[POOL_MAXPOOLS];
+static u_int		 pool_npools;
+
+/*
+ * Return a zeroed item.
+ */
+void *
+pool_get(struct pool *pp)
+{
+	struct pool_item	*pi;
+
+	if (pp->freelist == NULL)
+		pool_grow(pp);
+
+	pi = pp->freelist;
+	pp->freelist = pi->next;
+	pp->nget++;
+	pp->nout++;
+
+	bzero(pi, pp->size);
+	return (pi);
+}
+
+void
+pool_put(struct pool *pp, void *v)
+{
+	struct pool_item	*pi = v;
+
+	pi->next = pp->freelist;
+	pp->freelist = pi;
+	pp->nput++;
+	pp->nout--;
+}
+
+void
+pool_dump(int fd)
+{
+	struct pool	*pp;
+	u_int		 i;
+
+	dprintf(fd, "pools:\n");
+	dprintf(fd, "  %-16s %10s %10s %10s %10s %10s\n", "name", "size",
+	    "out", "slabs", "gets", "puts");
+	for (i = 0; i < pool_npools; i++) {
+		pp = pool_list[i];
+		dprintf(fd, "  %-16s %10zu %10lu %10lu %10lu %10lu\n",
+		    pp->name, pp->size, pp->nout, pp->nslab, pp->nget,
+		    pp->nput);
+	}
+}
+
+static void
+pool_grow(struct pool *pp)
+{
+	struct pool_slab	*ps;
+	struct pool_item	*pi;
+	size_t			 align, hdr, size;
+	char			*p;
+	u_int			 i, n;
+
+	/* Items hold at least the free list link, and are aligned. */
+	align = MAX(pp->align, sizeof(void *));
+	size = roundup(MAX(pp->size, sizeof(*pi)), align);
+	hdr = roundup(sizeof(*ps), align);
+	n = MAX((POOL_SLABSIZE - hdr) / size, 1);
+
+	if (posix_memalign((void **)&ps, align, hdr + n * size) != 0)
+		err(1, "posix_memalign");
+	if (pp->slabs == NULL && pool_npools < POOL_MAXPOOLS)
+		pool_list[pool_npools++] = pp;
+	ps->next = pp->slabs;
+	pp->slabs = ps;
+	pp->nslab++;
+
+	for (i = 0, p = (char *)ps + hdr; i < n; i++, p += size) {
+		pi = (struct pool_item *)p;
+		pi->next = pp->freelist;
+		pp->freelist = pi;
+	}
+}
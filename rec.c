@@ -0,0 +1,292 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Recording of the events cwm takes, in the event loop, the menus and
+ * mouse drags, and of the replies to what it asked the server about
+ * the windows, to $CWM_RECORD if set, for bench/replay to play back;
+ * see rec.h for the layout.  Written through stdio, flushed when the
+ * event loop runs out of events.
+ */
+
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "calmwm.h"
+#include "rec.h"
+
+#define REC_BUFSIZE	65536
+#define REC_MAXSTR	1024
+
+static void		 rec_put(int, const void *, size_t, const char *,
+			    size_t);
+static void		 rec_atom(Atom);
+static void		 rec_close(void);
+
+static FILE		*rec_fp;
+static char		*rec_path;
+static struct timespec	 rec_last;
+
+/* Atoms whose name has been written. */
+static Atom		*rec_atoms;
+static u_int		 rec_natoms, rec_atomsize;
+
+void
+rec_init(void)
+{
+	struct rec_hdr	 hdr;
+	const char	*path;
+
+	if ((path = getenv("CWM_RECORD")) == NULL || path[0] == '\0')
+		return;
+	if ((rec_fp = fopen(path, "we")) == NULL) {
+		warn("%s", path);
+		return;
+	}
+	rec_path = xstrdup(path);
+	(void)setvbuf(rec_fp, NULL, _IOFBF, REC_BUFSIZE);
+
+	bzero(&hdr, sizeof(hdr));
+	hdr.magic = REC_MAGIC;
+	hdr.version = REC_VERSION;
+	hdr.width = DisplayWidth(X_Dpy, DefaultScreen(X_Dpy));
+	hdr.height = DisplayHeight(X_Dpy, DefaultScreen(X_Dpy));
+	if (fwrite(&hdr, sizeof(hdr), 1, rec_fp) != 1) {
+		rec_close();
+		return;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &rec_last);
+}
+
+void
+rec_teardown(void)
+{
+	if (rec_fp != NULL && fclose(rec_fp) == EOF)
+		warn("%s", rec_path);
+	rec_fp = NULL;
+	xfree(rec_path);
+	rec_path = NULL;
+	xfree(rec_atoms);
+	rec_atoms = NULL;
+	rec_natoms = rec_atomsize = 0;
+}
+
+void
+rec_flush(void)
+{
+	if (rec_fp != NULL && fflush(rec_fp) == EOF)
+		rec_close();
+}
+
+void
+rec_event(XEvent *e)
+{
+	XRRScreenChangeNotifyEvent	*rev;
+	struct rec_event		 ev;
+	int				 i;
+
+	if (rec_fp == NULL)
+		return;
+
+	bzero(&ev, sizeof(ev));
+	ev.type = e->type;
+	ev.window = e->xany.window;
+	switch (e->type) {
+	case KeyPress:
+	case KeyRelease:
+		ev.arg[0] = e->xkey.keycode;
+		ev.arg[1] = e->xkey.state;
+		ev.arg[2] = e->xkey.x_root;
+		ev.arg[3] = e->xkey.y_root;
+		ev.arg[4] = e->xkey.time;
+		break;
+	case ButtonPress:
+	case ButtonRelease:
+		ev.arg[0] = e->xbutton.button;
+		ev.arg[1] = e->xbutton.state;
+		ev.arg[2] = e->xbutton.x_root;
+		ev.arg[3] = e->xbutton.y_root;
+		ev.arg[4] = e->xbutton.time;
+		break;
+	case MotionNotify:
+		ev.arg[1] = e->xmotion.state;
+		ev.arg[2] = e->xmotion.x_root;
+		ev.arg[3] = e->xmotion.y_root;
+		ev.arg[4] = e->xmotion.time;
+		break;
+	case EnterNotify:
+	case LeaveNotify:
+		ev.arg[1] = e->xcrossing.state;
+		ev.arg[2] = e->xcrossing.x_root;
+		ev.arg[3] = e->xcrossing.y_root;
+		ev.arg[4] = e->xcrossing.time;
+		break;
+	case MapRequest:
+		ev.window = e->xmaprequest.window;
+		break;
+	case ConfigureRequest:
+		ev.window = e->xconfigurerequest.window;
+		ev.arg[0] = e->xconfigurerequest.x;
+		ev.arg[1] = e->xconfigurerequest.y;
+		ev.arg[2] = e->xconfigurerequest.width;
+		ev.arg[3] = e->xconfigurerequest.height;
+		ev.arg[4] = e->xconfigurerequest.border_width;
+		ev.arg[5] = e->xconfigurerequest.value_mask;
+		break;
+	case UnmapNotify:
+		ev.window = e->xunmap.window;
+		ev.arg[0] = e->xunmap.send_event;
+		break;
+	case DestroyNotify:
+		ev.window = e->xdestroywindow.window;
+		break;
+	case PropertyNotify:
+		rec_atom(e->xproperty.atom);
+		ev.arg[0] = e->xproperty.atom;
+		ev.arg[1] = e->xproperty.state;
+		ev.arg[4] = e->xproperty.time;
+		break;
+	case ClientMessage:
+		rec_atom(e->xclient.message_type);
+		ev.arg[0] = e->xclient.message_type;
+		for (i = 0; i < 5 && e->xclient.format == 32; i++)
+			ev.arg[i + 1] = e->xclient.data.l[i];
+		break;
+	default:
+		if (HasRandr && e->type - Randr_ev == RRScreenChangeNotify) {
+			rev = (XRRScreenChangeNotifyEvent *)e;
+			ev.type = REC_RANDR;
+			ev.window = rev->root;
+			ev.arg[0] = rev->width;
+			ev.arg[1] = rev->height;
+			ev.arg[2] = rev->mwidth;
+			ev.arg[3] = rev->mheight;
+		}
+		break;
+	}
+	rec_put(REC_EVENT, &ev, sizeof(ev), NULL, 0);
+}
+
+void
+rec_geom(Window win, XWindowAttributes *wattr)
+{
+	struct rec_geom	 g;
+
+	if (rec_fp == NULL)
+		return;
+
+	bzero(&g, sizeof(g));
+	g.window = win;
+	g.x = wattr->x;
+	g.y = wattr->y;
+	g.width = wattr->width;
+	g.height = wattr->height;
+	g.bwidth = wattr->border_width;
+	g.mapped = wattr->map_state == IsViewable;
+	rec_put(REC_GEOM, &g, sizeof(g), NULL, 0);
+}
+
+void
+rec_name(Window win, const char *name)
+{
+	char		 buf[REC_MAXSTR];
+	uint32_t	 w = win;
+
+	if (rec_fp == NULL)
+		return;
+	/* Titles are kept whole, but the item length is 16 bits. */
+	(void)strlcpy(buf, name, sizeof(buf));
+	rec_put(REC_NAME, &w, sizeof(w), buf, strlen(buf) + 1);
+}
+
+void
+rec_class(Window win, const char *name, const char *class)
+{
+	char		 buf[2 * REC_MAXSTR];
+	uint32_t	 w = win;
+	int		 len;
+
+	if (rec_fp == NULL)
+		return;
+	len = snprintf(buf, sizeof(buf), "%.*s%c%.*s", REC_MAXSTR - 1,
+	    name != NULL ? name : "", '\0', REC_MAXSTR - 1,
+	    class != NULL ? class : "");
+	rec_put(REC_CLASS, &w, sizeof(w), buf, len + 1);
+}
+
+/*
+ * Write an item of a fixed part and slen bytes of s.
+ */
+static void
+rec_put(int kind, const void *p, size_t len, const char *s, size_t slen)
+{
+	struct rec_item	 item;
+	struct timespec	 ts;
+	long long	 usec;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	usec = (ts.tv_sec - rec_last.tv_sec) * 1000000LL +
+	    (ts.tv_nsec - rec_last.tv_nsec) / 1000;
+	rec_last = ts;
+
+	item.usec = MIN(usec, UINT32_MAX);
+	item.kind = kind;
+	item.len = len + slen;
+	if (fwrite(&item, sizeof(item), 1, rec_fp) != 1 ||
+	    fwrite(p, len, 1, rec_fp) != 1 ||
+	    (slen > 0 && fwrite(s, slen, 1, rec_fp) != 1))
+		rec_close();
+}
+
+/* The first time an atom is seen, write its name down. */
+static void
+rec_atom(Atom atom)
+{
+	uint32_t	 a = atom;
+	char		*name;
+	u_int		 i;
+
+	for (i = 0; i < rec_natoms; i++)
+		if (rec_atoms[i] == atom)
+			return;
+	if (rec_natoms == rec_atomsize) {
+		rec_atomsize = MAX(rec_atomsize * 2, 32);
+		rec_atoms = xrealloc(rec_atoms,
+		    rec_atomsize * sizeof(*rec_atoms));
+	}
+	rec_atoms[rec_natoms++] = atom;
+
+	if ((name = XGetAtomName(X_Dpy, atom)) == NULL)
+		return;
+	if (strlen(name) < REC_MAXSTR)
+		rec_put(REC_ATOM, &a, sizeof(a), name, strlen(name) + 1);
+	XFree(name);
+}
+
+/* Give up on the recording after an error writing it. */
+static void
+rec_close(void)
+{
+	warn("%s", rec_path);
+	(void)fclose(rec_fp);
+	rec_fp = NULL;
+}
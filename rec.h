@@ -0,0 +1,90 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * The layout of an event recording, $CWM_RECORD, for bench/replay and
+ * whatever else reads it; it includes nothing of cwm's own.  All fields
+ * are in host byte order.
+ *
+ * The file is a header and then items, each a rec_item and len bytes.
+ * Events come in the order cwm took them.  What cwm read from the
+ * server because of an event, a window's geometry, title or class,
+ * follows the event; what it read of the windows there when it started
+ * comes before the first event.  An atom's name comes before the first
+ * event naming it.  Strings are NUL terminated.
+ */
+
+#ifndef _REC_H_
+#define _REC_H_
+
+#include <stdint.h>
+
+#define REC_MAGIC	0x52574d43	/* "CWMR" */
+#define REC_VERSION	1
+
+struct rec_hdr {
+	uint32_t	 magic;
+	uint32_t	 version;
+	int32_t		 width;		/* of the first screen */
+	int32_t		 height;
+};
+
+struct rec_item {
+	uint32_t	 usec;		/* since the item before */
+#define REC_EVENT	 1		/* struct rec_event */
+#define REC_ATOM	 2		/* uint32_t atom, its name */
+#define REC_GEOM	 3		/* struct rec_geom */
+#define REC_NAME	 4		/* uint32_t window, its title */
+#define REC_CLASS	 5		/* uint32_t window, name, class */
+	uint16_t	 kind;
+	uint16_t	 len;		/* bytes following */
+};
+
+/*
+ * X events, by what of them the handlers use; window is the one the
+ * event is about, not the one it was reported on.
+ *
+ *	KeyPress	keycode, state, x_root, y_root, time
+ *	ButtonPress	button, state, x_root, y_root, time
+ *	and Release
+ *	MotionNotify	0, state, x_root, y_root, time
+ *	EnterNotify	0, state, x_root, y_root, time
+ *	and Leave
+ *	ConfigureRequest x, y, width, height, border_width, value_mask
+ *	UnmapNotify	send_event
+ *	PropertyNotify	atom, state, 0, 0, time
+ *	ClientMessage	message_type, data.l[0] to data.l[4]
+ *	REC_RANDR	width, height, mwidth, mheight
+ */
+#define REC_RANDR	 128		/* RRScreenChangeNotify */
+
+struct rec_event {
+	uint32_t	 type;
+	uint32_t	 window;
+	int32_t		 arg[6];
+};
+
+struct rec_geom {
+	uint32_t	 window;
+	int32_t		 x;
+	int32_t		 y;
+	int32_t		 width;
+	int32_t		 height;
+	int32_t		 bwidth;
+	uint32_t	 mapped;
+};
+
+#endif /* _REC_H_ */
@@ -59,7 +59,7 @@ screen_updatestackingorder(struct screen_ctx *sc)
 		    cc->flags & CLIENT_HIDDEN)
 			continue;
 
-		cc->stackingorder = s++;
+		cc->cold->stackingorder = s++;
 	}
 
 	XFree(wins);
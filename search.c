@@ -25,6 +25,8 @@
 #include <err.h>
 #include <errno.h>
 #include <fnmatch.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -32,7 +34,48 @@
 
 #include "calmwm.h"
 
+#define SEARCH_NTIERS		4
+#define SEARCH_CHUNK		512	/* entries handed out at a time */
+#define SEARCH_MINPARALLEL	4096	/* below this, filter inline */
+#define SEARCH_MAXTHREADS	16
+
+struct search_query {
+	char			*search;
+	struct client_ctx	*curcc;
+	int			 glob;
+};
+
+struct search_job {
+	struct search_query	*q;
+	int			(*score)(struct menu *, struct search_query *);
+	struct menu		**mv;
+	signed char		*tier;
+	size_t			 n;
+	size_t			 next;
+	size_t			 ndone;
+	int			 nbusy;
+	int			 nthreads;
+};
+
 static int	strsubmatch(char *, char *, int);
+static int	search_cmp(const void *, const void *);
+static void	search_filter(struct menu_q *, struct menu_q *,
+		    struct search_query *,
+		    int (*)(struct menu *, struct search_query *), int);
+static int	search_score_app(struct menu *, struct search_query *);
+static int	search_score_client(struct menu *, struct search_query *);
+static int	search_score_exec(struct menu *, struct search_query *);
+static int	search_score_text(struct menu *, struct search_query *);
+static int	search_spawn(int);
+static void	search_work(struct search_job *);
+static void	*search_worker(void *);
+
+static pthread_mutex_t	 search_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	 search_wakeup = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t	 search_done = PTHREAD_COND_INITIALIZER;
+static struct search_job *search_job;
+static u_int		 search_gen;
+static int		 search_nworkers;
 
 /*
  * Match: label, title, class.
@@ -41,12 +84,20 @@ static int	strsubmatch(char *, char *, int);
 void
 search_match_client(struct menu_q *menuq, struct menu_q *resultq, char *search)
 {
-	struct winname	*wn;
-	struct menu	*mi, *tierp[4], *before = NULL;
+	struct search_query	 q;
 
-	TAILQ_INIT(resultq);
+	q.search = search;
+	q.curcc = client_current();
+	q.glob = 0;
+
+	search_filter(menuq, resultq, &q, search_score_client, SEARCH_NTIERS);
+}
 
-	(void)memset(tierp, 0, sizeof(tierp));
+static int
+search_score_client(struct menu *mi, struct search_query *q)
+{
+	struct client_ctx	*cc = mi->ctx;
+	int			 i, tier = -1;
 
 	/*
 	 * In order of rank:
@@ -56,73 +107,55 @@ search_match_client(struct menu_q *menuq, struct menu_q *resultq, char *search)
 	 *   3. Look at window class name.
 	 */
 
-	TAILQ_FOREACH(mi, menuq, entry) {
-		int tier = -1, t;
-		struct client_ctx *cc = mi->ctx;
+	/* First, try to match on labels. */
+	if (cc->cold->label != NULL &&
+	    strsubmatch(q->search, cc->cold->label, 0)) {
+		cc->cold->matchname = cc->cold->label;
+		tier = 0;
+	}
 
-		/* First, try to match on labels. */
-		if (cc->label != NULL && strsubmatch(search, cc->label, 0)) {
-			cc->matchname = cc->label;
-			tier = 0;
-		}
+	/* Then, on window names. */
+	if (tier < 0) {
+		for (i = 0; i < cc->cold->nameqlen; i++)
+			if (strsubmatch(q->search, CLIENT_NAME(cc, i), 0)) {
+				cc->cold->matchname = CLIENT_NAME(cc, i);
+				tier = 2;
+				break;
+			}
+	}
 
-		/* Then, on window names. */
-		if (tier < 0) {
-			TAILQ_FOREACH_REVERSE(wn, &cc->nameq, winname_q, entry)
-				if (strsubmatch(search, wn->name, 0)) {
-					cc->matchname = wn->name;
-					tier = 2;
-					break;
-				}
-		}
+	/* Then if there is a match on the window class name. */
+	if (tier < 0 && strsubmatch(q->search, cc->cold->app_class, 0)) {
+		cc->cold->matchname = cc->cold->app_class;
+		tier = 3;
+	}
 
-		/* Then if there is a match on the window class name. */
-		if (tier < 0 && strsubmatch(search, cc->app_class, 0)) {
-			cc->matchname = cc->app_class;
-			tier = 3;
-		}
+	if (tier < 0)
+		return (-1);
 
-		if (tier < 0)
-			continue;
+	/*
+	 * De-rank a client one tier if it's the current
+	 * window.  Furthermore, this is denoted by a "!" when
+	 * printing the window name in the search menu.
+	 */
+	if (cc == q->curcc && tier < SEARCH_NTIERS - 1)
+		tier++;
 
-		/*
-		 * De-rank a client one tier if it's the current
-		 * window.  Furthermore, this is denoted by a "!" when
-		 * printing the window name in the search menu.
-		 */
-		if (cc == client_current() && tier < nitems(tierp) - 1)
-			tier++;
-
-		/* Clients that are hidden get ranked one up. */
-		if (cc->flags & CLIENT_HIDDEN && tier > 0)
-			tier--;
-
-		assert(tier < nitems(tierp));
-
-		/*
-		 * If you have a tierp, insert after it, and make it
-		 * the new tierp.  If you don't have a tierp, find the
-		 * first nonzero tierp above you, insert after it.
-		 * Always make your current tierp the newly inserted
-		 * entry.
-		 */
-		for (t = tier; t >= 0 && ((before = tierp[t]) == NULL); t--)
-			;
-
-		if (before == NULL)
-			TAILQ_INSERT_HEAD(resultq, mi, resultentry);
-		else
-			TAILQ_INSERT_AFTER(resultq, before, mi, resultentry);
+	/* Clients that are hidden get ranked one up. */
+	if (cc->flags & CLIENT_HIDDEN && tier > 0)
+		tier--;
 
-		tierp[tier] = mi;
-	}
+	assert(tier < SEARCH_NTIERS);
+
+	return (tier);
 }
 
 void
-search_print_client(struct menu *mi, int list)
+search_print_client(struct menu *mi, int list, char *buf, size_t len)
 {
 	struct client_ctx	*cc;
 	char			 flag = ' ';
+	size_t			 used;
 
 	cc = mi->ctx;
 
@@ -132,18 +165,16 @@ search_print_client(struct menu *mi, int list)
 		flag = '&';
 
 	if (list)
-		cc->matchname = cc->name;
+		cc->cold->matchname = cc->name;
 
-	(void)snprintf(mi->print, sizeof(mi->print), "%c%s", flag,
-	    cc->matchname);
+	(void)snprintf(buf, len, "%c%s", flag, cc->cold->matchname);
 
-	if (!list && cc->matchname != cc->name &&
-	    strlen(mi->print) < sizeof(mi->print) - 1) {
+	if (!list && cc->cold->matchname != cc->name &&
+	    (used = strlen(buf)) < len - 1) {
 		const char	*marker = "";
-		char		 buf[MENU_MAXENTRY + 1];
 		int		 diff;
 
-		diff = sizeof(mi->print) - 1 - strlen(mi->print);
+		diff = len - 1 - used;
 
 		/* One for the ':' */
 		diff -= 1;
@@ -155,45 +186,304 @@ search_print_client(struct menu *mi, int list)
 			diff = strlen(cc->name);
 		}
 
-		(void)strlcpy(buf, mi->print, sizeof(buf));
-		(void)snprintf(mi->print, sizeof(mi->print),
-		    "%s:%.*s%s", buf, diff, cc->name, marker);
+		(void)snprintf(buf + used, len - used,
+		    ":%.*s%s", MAX(diff, 0), cc->name, marker);
 	}
 }
 
 void
 search_match_text(struct menu_q *menuq, struct menu_q *resultq, char *search)
 {
-	struct menu	*mi;
+	struct search_query	 q;
 
-	TAILQ_INIT(resultq);
+	q.search = search;
+	q.curcc = NULL;
+	q.glob = 0;
 
-	TAILQ_FOREACH(mi, menuq, entry)
-		if (strsubmatch(search, mi->text, 0))
-			TAILQ_INSERT_TAIL(resultq, mi, resultentry);
+	search_filter(menuq, resultq, &q, search_score_text, 1);
 }
 
+static int
+search_score_text(struct menu *mi, struct search_query *q)
+{
+	return (strsubmatch(q->search, mi->text, 0) ? 0 : -1);
+}
+
+/*
+ * Match: application name, then keywords.
+ */
+void
+search_match_app(struct menu_q *menuq, struct menu_q *resultq, char *search)
+{
+	struct search_query	 q;
+
+	q.search = search;
+	q.curcc = NULL;
+	q.glob = 0;
+
+	search_filter(menuq, resultq, &q, search_score_app, 2);
+}
+
+static int
+search_score_app(struct menu *mi, struct search_query *q)
+{
+	struct desktop_app	*app = mi->ctx;
+
+	if (strsubmatch(q->search, (char *)app->name, 0))
+		return (0);
+	if (strsubmatch(q->search, (char *)app->keywords, 0))
+		return (1);
+	return (-1);
+}
+
+/*
+ * menuq must already be in display order, see search_sort(); matching
+ * then just preserves that order instead of re-sorting every keystroke.
+ */
 void
 search_match_exec(struct menu_q *menuq, struct menu_q *resultq, char *search)
 {
-	struct menu	*mi, *mj;
+	struct search_query	 q;
+
+	q.search = search;
+	q.curcc = NULL;
+	/* Without metacharacters fnmatch can't match more than a prefix. */
+	q.glob = (strpbrk(search, "*?[\\") != NULL);
+
+	search_filter(menuq, resultq, &q, search_score_exec, 1);
+}
+
+/*
+ * As search_match_exec(), but once a '/' is typed complete a path to
+ * run instead.
+ */
+void
+search_match_path(struct menu_q *menuq, struct menu_q *resultq, char *search)
+{
+	if (strchr(search, '/') != NULL)
+		complete_match(resultq, search);
+	else
+		search_match_exec(menuq, resultq, search);
+}
+
+static int
+search_score_exec(struct menu *mi, struct search_query *q)
+{
+	if (strsubmatch(q->search, mi->text, 1) == 0 &&
+	    (!q->glob || fnmatch(q->search, mi->text, 0) == FNM_NOMATCH))
+		return (-1);
+	return (0);
+}
+
+/*
+ * Score every entry of menuq into a tier, or -1 for no match, then
+ * build resultq by tier and within a tier in menuq order.  Large menus
+ * are split into chunks and scored on a pool of worker threads, but
+ * since the merge does not depend on who scored what the result is
+ * the same as when scoring inline.
+ */
+static void
+search_filter(struct menu_q *menuq, struct menu_q *resultq,
+    struct search_query *q, int (*score)(struct menu *, struct search_query *),
+    int ntiers)
+{
+	struct search_job	 job;
+	struct menu		*mi;
+	size_t			 i;
+	int			 t;
 
 	TAILQ_INIT(resultq);
 
-	TAILQ_FOREACH(mi, menuq, entry) {
-		if (strsubmatch(search, mi->text, 1) == 0 &&
-		    fnmatch(search, mi->text, 0) == FNM_NOMATCH)
-				continue;
-		for (mj = TAILQ_FIRST(resultq); mj != NULL;
-		     mj = TAILQ_NEXT(mj, resultentry)) {
-			if (strcasecmp(mi->text, mj->text) < 0) {
-				TAILQ_INSERT_BEFORE(mj, mi, resultentry);
-				break;
-			}
+	bzero(&job, sizeof(job));
+	TAILQ_FOREACH(mi, menuq, entry)
+		job.n++;
+	if (job.n == 0)
+		return;
+
+	job.q = q;
+	job.score = score;
+	job.mv = xcalloc(job.n, sizeof(*job.mv));
+	job.tier = xcalloc(job.n, sizeof(*job.tier));
+	i = 0;
+	TAILQ_FOREACH(mi, menuq, entry)
+		job.mv[i++] = mi;
+
+	job.nthreads = MIN(Conf.filterthreads, SEARCH_MAXTHREADS);
+	if (job.n < SEARCH_MINPARALLEL || job.nthreads < 2 ||
+	    (job.nthreads = search_spawn(job.nthreads - 1) + 1) < 2) {
+		for (i = 0; i < job.n; i++)
+			job.tier[i] = (*score)(job.mv[i], q);
+	} else {
+		pthread_mutex_lock(&search_mtx);
+		search_job = &job;
+		search_gen++;
+		pthread_cond_broadcast(&search_wakeup);
+		pthread_mutex_unlock(&search_mtx);
+
+		/* Lend a hand rather than sit idle. */
+		search_work(&job);
+
+		pthread_mutex_lock(&search_mtx);
+		while (job.ndone < job.n || job.nbusy > 0)
+			pthread_cond_wait(&search_done, &search_mtx);
+		search_job = NULL;
+		pthread_mutex_unlock(&search_mtx);
+	}
+
+	for (t = 0; t < ntiers; t++)
+		for (i = 0; i < job.n; i++)
+			if (job.tier[i] == t)
+				TAILQ_INSERT_TAIL(resultq, job.mv[i],
+				    resultentry);
+
+	xfree(job.tier);
+	xfree(job.mv);
+}
+
+static void
+search_work(struct search_job *job)
+{
+	size_t	 i, start, end;
+
+	for (;;) {
+		pthread_mutex_lock(&search_mtx);
+		start = job->next;
+		end = job->next = MIN(job->n, start + SEARCH_CHUNK);
+		pthread_mutex_unlock(&search_mtx);
+
+		if (start == end)
+			break;
+
+		for (i = start; i < end; i++)
+			job->tier[i] = (*job->score)(job->mv[i], job->q);
+
+		pthread_mutex_lock(&search_mtx);
+		job->ndone += end - start;
+		if (job->ndone == job->n)
+			pthread_cond_signal(&search_done);
+		pthread_mutex_unlock(&search_mtx);
+	}
+}
+
+static void *
+search_worker(void *arg)
+{
+	struct search_job	*job;
+	u_int			 gen = 0;
+	int			 id = (int)(long)arg;
+
+	pthread_mutex_lock(&search_mtx);
+	for (;;) {
+		while (search_job == NULL || search_gen == gen)
+			pthread_cond_wait(&search_wakeup, &search_mtx);
+		gen = search_gen;
+		job = search_job;
+
+		/* The pool may be larger than what is configured now. */
+		if (id >= job->nthreads - 1)
+			continue;
+
+		job->nbusy++;
+		pthread_mutex_unlock(&search_mtx);
+
+		search_work(job);
+
+		pthread_mutex_lock(&search_mtx);
+		if (--job->nbusy == 0)
+			pthread_cond_signal(&search_done);
+	}
+	/* NOTREACHED */
+	return (NULL);
+}
+
+/*
+ * Make sure at least n workers exist; return how many there are.
+ */
+static int
+search_spawn(int n)
+{
+	pthread_t	 tid;
+	sigset_t	 all, old;
+
+	if (search_nworkers >= n)
+		return (n);
+
+	/* Workers inherit this mask, signals stay with the main thread. */
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	while (search_nworkers < n) {
+		if (pthread_create(&tid, NULL, search_worker,
+		    (void *)(long)search_nworkers) != 0) {
+			warnx("search: cannot create filter thread");
+			break;
 		}
-		if (mj == NULL)
-			TAILQ_INSERT_TAIL(resultq, mi, resultentry);
+		pthread_detach(tid);
+		search_nworkers++;
 	}
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	return (MIN(search_nworkers, n));
+}
+
+/*
+ * Sort a menu case insensitively by text, once, when it is built.
+ */
+void
+search_sort(struct menu_q *menuq)
+{
+	struct menu	*mi, **mv;
+	size_t		 i, n = 0;
+
+	TAILQ_FOREACH(mi, menuq, entry)
+		n++;
+	if (n < 2)
+		return;
+
+	mv = xcalloc(n, sizeof(*mv));
+	i = 0;
+	TAILQ_FOREACH(mi, menuq, entry)
+		mv[i++] = mi;
+
+	qsort(mv, n, sizeof(*mv), search_cmp);
+
+	TAILQ_INIT(menuq);
+	for (i = 0; i < n; i++)
+		TAILQ_INSERT_TAIL(menuq, mv[i], entry);
+	xfree(mv);
+}
+
+/*
+ * Sort addq and merge it into the already sorted menuq.
+ */
+void
+search_merge(struct menu_q *menuq, struct menu_q *addq)
+{
+	struct menu	*mi, *pos;
+
+	search_sort(addq);
+
+	pos = TAILQ_FIRST(menuq);
+	while ((mi = TAILQ_FIRST(addq)) != NULL) {
+		TAILQ_REMOVE(addq, mi, entry);
+		while (pos != NULL && search_cmp(&pos, &mi) <= 0)
+			pos = TAILQ_NEXT(pos, entry);
+		if (pos == NULL)
+			TAILQ_INSERT_TAIL(menuq, mi, entry);
+		else
+			TAILQ_INSERT_BEFORE(pos, mi, entry);
+	}
+}
+
+static int
+search_cmp(const void *a, const void *b)
+{
+	const struct menu	*ma = *(const struct menu **)a;
+	const struct menu	*mb = *(const struct menu **)b;
+	int			 r;
+
+	if ((r = strcasecmp(ma->text, mb->text)) != 0)
+		return (r);
+	return (strcmp(ma->text, mb->text));
 }
 
 static int
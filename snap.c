@@ -0,0 +1,308 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * The clients, groups and MRU order of every screen, published in a
+ * file mapped into memory for other programs to read without asking the
+ * X server or cwm anything; see snap.h for the layout.  It is brought
+ * up to date whenever the event loop runs out of events, and only
+ * rewritten if something in it changed.
+ */
+
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "calmwm.h"
+#include "snap.h"
+
+#define SNAP_FILE	"cwm-%s.state"
+#define SNAP_MINSIZE	16384
+
+static void		 snap_build(void);
+static uint32_t		 snap_str(const char *);
+static int		 snap_grow(size_t);
+
+static char		 snap_path[MAXPATHLEN];
+static int		 snap_fd = -1;
+static u_char		*snap_map;
+static size_t		 snap_mapsize;
+
+/* The next snapshot, built here and compared with the published one. */
+static u_char		*snap_buf;
+static size_t		 snap_bufsize, snap_len;
+static char		*snap_strs;
+static size_t		 snap_strsize, snap_strlen;
+
+/*
+ * Create $CWM_SNAPSHOT, or ~/cwm-<display>.state; an empty CWM_SNAPSHOT
+ * turns the snapshot off.  Failing to create it is not fatal.
+ */
+void
+snap_init(void)
+{
+	struct stat	 sb;
+	const char	*path, *home, *dpy;
+	int		 len;
+
+	if ((path = getenv("CWM_SNAPSHOT")) != NULL) {
+		if (path[0] == '\0')
+			return;
+		len = strlcpy(snap_path, path, sizeof(snap_path));
+	} else {
+		if ((home = getenv("HOME")) == NULL)
+			return;
+		dpy = DisplayString(X_Dpy);
+		if ((path = strrchr(dpy, ':')) != NULL)
+			dpy = path + 1;
+		len = snprintf(snap_path, sizeof(snap_path), "%s/" SNAP_FILE,
+		    home, dpy);
+	}
+	if (len < 0 || len >= sizeof(snap_path)) {
+		warnx("snapshot path too long");
+		snap_path[0] = '\0';
+		return;
+	}
+
+	/*
+	 * One left by a cwm before, as on a restart, may still be mapped
+	 * by readers: keep its size and update it like any other time.
+	 */
+	if ((snap_fd = open(snap_path, O_RDWR | O_CREAT, 0600)) == -1 ||
+	    fstat(snap_fd, &sb) == -1) {
+		warn("%s", snap_path);
+		if (snap_fd != -1)
+			(void)close(snap_fd);
+		snap_fd = -1;
+		snap_path[0] = '\0';
+		return;
+	}
+	(void)fcntl(snap_fd, F_SETFD, FD_CLOEXEC);
+	if (snap_grow(MAX(SNAP_MINSIZE, sb.st_size)) == -1) {
+		snap_teardown();
+		return;
+	}
+	snap_update();
+}
+
+void
+snap_teardown(void)
+{
+	if (snap_map != NULL) {
+		(void)munmap(snap_map, snap_mapsize);
+		snap_map = NULL;
+		snap_mapsize = 0;
+	}
+	if (snap_fd != -1) {
+		(void)close(snap_fd);
+		snap_fd = -1;
+	}
+	if (snap_path[0] != '\0') {
+		(void)unlink(snap_path);
+		snap_path[0] = '\0';
+	}
+}
+
+/*
+ * Publish the current state, if it differs from what was last published.
+ */
+void
+snap_update(void)
+{
+	struct snap_hdr	*hdr, *new;
+	uint32_t	 seq;
+
+	if (snap_map == NULL)
+		return;
+
+	snap_build();
+	hdr = (struct snap_hdr *)snap_map;
+	new = (struct snap_hdr *)snap_buf;
+	if (hdr->magic == SNAP_MAGIC && hdr->version == SNAP_VERSION &&
+	    (hdr->seq & 1) == 0 &&
+	    hdr->size == snap_len && hdr->nscreens == new->nscreens &&
+	    hdr->nclients == new->nclients &&
+	    memcmp(snap_map + sizeof(*hdr), snap_buf + sizeof(*hdr),
+	    snap_len - sizeof(*hdr)) == 0)
+		return;
+
+	if (snap_len > snap_mapsize && snap_grow(snap_len * 2) == -1) {
+		snap_teardown();
+		return;
+	}
+	hdr = (struct snap_hdr *)snap_map;
+
+	/*
+	 * Readers throw away whatever they copy while seq is odd; it
+	 * already is if a cwm before died while writing.
+	 */
+	seq = hdr->seq | 1;
+	__atomic_store_n(&hdr->seq, seq, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	hdr->magic = SNAP_MAGIC;
+	hdr->version = SNAP_VERSION;
+	hdr->size = snap_len;
+	hdr->serial++;
+	hdr->nscreens = new->nscreens;
+	hdr->nclients = new->nclients;
+	hdr->strings = new->strings;
+	(void)memcpy(snap_map + sizeof(*hdr), snap_buf + sizeof(*hdr),
+	    snap_len - sizeof(*hdr));
+	__atomic_store_n(&hdr->seq, seq + 1, __ATOMIC_RELEASE);
+}
+
+static void
+snap_build(void)
+{
+	struct screen_ctx	*sc;
+	struct client_ctx	*cc;
+	struct snap_hdr		*hdr;
+	struct snap_screen	*ss;
+	struct snap_client	*sn;
+	size_t			 len;
+	u_int			 nscreens = 0, nclients = 0, mru, i;
+
+	TAILQ_FOREACH(sc, &Screenq, entry) {
+		nscreens++;
+		TAILQ_FOREACH(cc, &sc->mruq, mru_entry)
+			nclients++;
+	}
+
+	snap_strlen = 0;
+	(void)snap_str("");
+
+	len = sizeof(*hdr) + nscreens * sizeof(*ss) +
+	    nclients * sizeof(*sn);
+	if (len > snap_bufsize) {
+		snap_bufsize = len * 2;
+		snap_buf = xrealloc(snap_buf, snap_bufsize);
+	}
+	bzero(snap_buf, len);
+	hdr = (struct snap_hdr *)snap_buf;
+	ss = (struct snap_screen *)(hdr + 1);
+	sn = (struct snap_client *)(ss + nscreens);
+
+	TAILQ_FOREACH(sc, &Screenq, entry) {
+		ss->which = sc->which;
+		ss->width = sc->xmax;
+		ss->height = sc->ymax;
+		ss->active = sc->group_active != NULL ?
+		    sc->group_active->shortcut : 0;
+		for (i = 0; i < SNAP_NGROUPS && i < CALMWM_NGROUPS; i++) {
+			if (i < sc->group_nonames)
+				ss->groups[i].name =
+				    snap_str(sc->group_names[i]);
+			ss->groups[i].hidden = sc->groups[i].hidden;
+			TAILQ_FOREACH(cc, &sc->groups[i].clients, group_entry)
+				ss->groups[i].nclients++;
+		}
+		ss++;
+
+		mru = 0;
+		TAILQ_FOREACH(cc, &sc->mruq, mru_entry) {
+			sn->win = cc->win;
+			sn->screen = sc->which;
+			sn->group = cc->group != NULL ? cc->group->shortcut : 0;
+			sn->x = cc->geom.x;
+			sn->y = cc->geom.y;
+			sn->width = cc->geom.width;
+			sn->height = cc->geom.height;
+			sn->bwidth = cc->bwidth;
+			if (cc->active)
+				sn->flags |= SNAP_ACTIVE;
+			if (cc->flags & CLIENT_HIDDEN)
+				sn->flags |= SNAP_HIDDEN;
+			if (cc->flags & CLIENT_VMAXIMIZED)
+				sn->flags |= SNAP_VMAXIMIZED;
+			if (cc->flags & CLIENT_HMAXIMIZED)
+				sn->flags |= SNAP_HMAXIMIZED;
+			if (cc->flags & CLIENT_FREEZE)
+				sn->flags |= SNAP_FREEZE;
+			sn->mru = mru++;
+			sn->name = snap_str(cc->name);
+			sn->label = snap_str(cc->cold->label);
+			sn->class = snap_str(cc->cold->app_class);
+			sn++;
+		}
+	}
+
+	hdr->nscreens = nscreens;
+	hdr->nclients = nclients;
+	hdr->strings = len;
+
+	snap_len = len + snap_strlen;
+	if (snap_len > snap_bufsize) {
+		snap_bufsize = snap_len * 2;
+		snap_buf = xrealloc(snap_buf, snap_bufsize);
+	}
+	(void)memcpy(snap_buf + len, snap_strs, snap_strlen);
+}
+
+/*
+ * Add s to the strings and return its offset.
+ */
+static uint32_t
+snap_str(const char *s)
+{
+	size_t	 off = snap_strlen, len;
+
+	if (s == NULL || (s[0] == '\0' && off > 0))
+		return (0);
+
+	len = strlen(s) + 1;
+	if (off + len > snap_strsize) {
+		snap_strsize = MAX(snap_strsize * 2, off + len);
+		snap_strs = xrealloc(snap_strs, snap_strsize);
+	}
+	(void)memcpy(snap_strs + off, s, len);
+	snap_strlen += len;
+	return (off);
+}
+
+/*
+ * Make the file, and its mapping, at least size bytes.  It never
+ * shrinks, so readers' mappings stay valid.
+ */
+static int
+snap_grow(size_t size)
+{
+	u_char	*map;
+	long	 pagesize = sysconf(_SC_PAGESIZE);
+
+	size = (size + pagesize - 1) / pagesize * pagesize;
+	if (ftruncate(snap_fd, size) == -1) {
+		warn("%s", snap_path);
+		return (-1);
+	}
+	map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, snap_fd, 0);
+	if (map == MAP_FAILED) {
+		warn("%s", snap_path);
+		return (-1);
+	}
+	if (snap_map != NULL)
+		(void)munmap(snap_map, snap_mapsize);
+	snap_map = map;
+	snap_mapsize = size;
+	return (0);
+}
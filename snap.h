@@ -0,0 +1,89 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * The layout of the state snapshot, ~/cwm-<display>.state, for programs
+ * reading it; it includes nothing of cwm's own.  All fields are in host
+ * byte order.
+ *
+ * The file is a header, the screens, the clients and then the strings,
+ * which fields name by their offset from the start of the strings; 0 is
+ * the empty string.  Clients come screen by screen, most recently used
+ * first.  cwm rewrites the file in place, never shrinking it, with seq
+ * odd while it does.  A reader copies out size bytes between two reads
+ * of an even and equal seq, and tries again otherwise; only the copy is
+ * to be looked at.  If size is larger than what the reader has mapped,
+ * the file has grown: map it again.
+ */
+
+#ifndef _SNAP_H_
+#define _SNAP_H_
+
+#include <stdint.h>
+
+#define SNAP_MAGIC	0x534d5743	/* "CWMS" */
+#define SNAP_VERSION	1
+#define SNAP_NGROUPS	9
+
+struct snap_hdr {
+	uint32_t	 magic;
+	uint32_t	 version;
+	uint32_t	 seq;
+	uint32_t	 size;		/* bytes in use, with the header */
+	uint64_t	 serial;	/* bumped on every change */
+	uint32_t	 nscreens;
+	uint32_t	 nclients;
+	uint32_t	 strings;	/* where the strings start */
+	uint32_t	 pad;
+};
+
+struct snap_group {
+	uint32_t	 name;
+	uint32_t	 hidden;
+	uint32_t	 nclients;
+};
+
+struct snap_screen {
+	uint32_t	 which;
+	int32_t		 width;
+	int32_t		 height;
+	uint32_t	 active;	/* group number, 1 to SNAP_NGROUPS */
+	struct snap_group groups[SNAP_NGROUPS];
+	uint32_t	 pad;
+};
+
+struct snap_client {
+	uint64_t	 win;
+	uint32_t	 screen;
+	uint32_t	 group;		/* 0 if in none */
+	int32_t		 x;
+	int32_t		 y;
+	int32_t		 width;
+	int32_t		 height;
+	uint32_t	 bwidth;
+#define SNAP_ACTIVE	 0x0001
+#define SNAP_HIDDEN	 0x0002
+#define SNAP_VMAXIMIZED	 0x0004
+#define SNAP_HMAXIMIZED	 0x0008
+#define SNAP_FREEZE	 0x0010
+	uint32_t	 flags;
+	uint32_t	 mru;		/* 0 is the most recently used */
+	uint32_t	 name;
+	uint32_t	 label;
+	uint32_t	 class;
+};
+
+#endif /* _SNAP_H_ */
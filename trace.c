@@ -0,0 +1,202 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * A timeline of what the window manager spent its time on.  Spans are
+ * recorded, from any thread, into a ring holding the last TRACE_NRECS
+ * of them, and written out on demand in the Chrome trace event format,
+ * which chrome://tracing and Perfetto load.  It is on when $CWM_TRACE
+ * is set, and then keeps going, so the moments before a stutter are
+ * there when someone asks for them.
+ */
+
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "calmwm.h"
+
+#define TRACE_NRECS	8192		/* a power of two */
+#define TRACE_FILE	"cwm-trace.json"
+
+struct trace_rec {
+	const char		*name;
+	uint64_t		 start;
+	uint64_t		 dur;
+	u_long			 arg;
+	u_int			 tid;
+	u_int			 seq;	/* index + 1 once filled in */
+};
+
+static u_int		 trace_tid(void);
+static void		 trace_keyinit(void);
+static uint64_t		 trace_now(void);
+
+static struct trace_rec	 trace_ring[TRACE_NRECS];
+static u_int		 trace_head;
+static pthread_key_t	 trace_key;
+static pthread_once_t	 trace_once = PTHREAD_ONCE_INIT;
+static u_int		 trace_ntids;
+static int		 trace_on;
+
+/*
+ * Called before any thread is started, so the others only ever read
+ * trace_on.
+ */
+void
+trace_init(void)
+{
+	trace_on = getenv("CWM_TRACE") != NULL;
+}
+
+void
+trace_begin(struct trace_span *ts, const char *name, u_long arg)
+{
+	if (!trace_on)
+		return;
+	ts->name = name;
+	ts->arg = arg;
+	ts->start = trace_now();
+}
+
+void
+trace_end(struct trace_span *ts)
+{
+	struct trace_rec	*r;
+	uint64_t		 end;
+	u_int			 i;
+
+	if (!trace_on)
+		return;
+	end = trace_now();
+	i = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED);
+	r = &trace_ring[i & (TRACE_NRECS - 1)];
+
+	/* Readers skip the record while seq is not i + 1. */
+	__atomic_store_n(&r->seq, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&r->name, ts->name, __ATOMIC_RELAXED);
+	__atomic_store_n(&r->start, ts->start, __ATOMIC_RELAXED);
+	__atomic_store_n(&r->dur, end - ts->start, __ATOMIC_RELAXED);
+	__atomic_store_n(&r->arg, ts->arg, __ATOMIC_RELAXED);
+	__atomic_store_n(&r->tid, trace_tid(), __ATOMIC_RELAXED);
+	__atomic_store_n(&r->seq, i + 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * Write the ring to fd as a JSON trace, oldest span first.
+ */
+void
+trace_dump(int fd)
+{
+	struct trace_rec	*r, rec;
+	u_int			 i, h, first;
+	int			 n = 0;
+
+	h = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE);
+	first = (h > TRACE_NRECS) ? h - TRACE_NRECS : 0;
+
+	dprintf(fd, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (i = first; i != h; i++) {
+		r = &trace_ring[i & (TRACE_NRECS - 1)];
+		if (__atomic_load_n(&r->seq, __ATOMIC_ACQUIRE) != i + 1)
+			continue;
+		rec.name = __atomic_load_n(&r->name, __ATOMIC_RELAXED);
+		rec.start = __atomic_load_n(&r->start, __ATOMIC_RELAXED);
+		rec.dur = __atomic_load_n(&r->dur, __ATOMIC_RELAXED);
+		rec.arg = __atomic_load_n(&r->arg, __ATOMIC_RELAXED);
+		rec.tid = __atomic_load_n(&r->tid, __ATOMIC_RELAXED);
+		/* Overwritten while we looked? */
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&r->seq, __ATOMIC_RELAXED) != i + 1)
+			continue;
+
+		dprintf(fd, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%ld,"
+		    "\"tid\":%u,\"ts\":%llu.%03llu,\"dur\":%llu.%03llu,"
+		    "\"args\":{\"arg\":\"0x%lx\"}}", n++ ? ",\n" : "",
+		    rec.name, (long)getpid(), rec.tid,
+		    (unsigned long long)(rec.start / 1000),
+		    (unsigned long long)(rec.start % 1000),
+		    (unsigned long long)(rec.dur / 1000),
+		    (unsigned long long)(rec.dur % 1000), rec.arg);
+	}
+	dprintf(fd, "\n]}\n");
+}
+
+/*
+ * Write the ring to ~/cwm-trace.json.
+ */
+void
+trace_write(void)
+{
+	const char	*home;
+	char		 path[MAXPATHLEN];
+	int		 fd;
+
+	if (!trace_on) {
+		log_info("trace: CWM_TRACE is not set");
+		return;
+	}
+	if ((home = getenv("HOME")) == NULL)
+		return;
+	(void)snprintf(path, sizeof(path), "%s/%s", home, TRACE_FILE);
+	if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600)) == -1) {
+		log_warn("trace: cannot open %s", path);
+		return;
+	}
+	trace_dump(fd);
+	(void)close(fd);
+	log_info("trace written to %s", path);
+}
+
+/* Threads are numbered in the order they first trace. */
+static u_int
+trace_tid(void)
+{
+	void	*v;
+	u_int	 tid;
+
+	(void)pthread_once(&trace_once, trace_keyinit);
+	if ((v = pthread_getspecific(trace_key)) != NULL)
+		return ((u_int)(uintptr_t)v);
+
+	tid = __atomic_add_fetch(&trace_ntids, 1, __ATOMIC_RELAXED);
+	(void)pthread_setspecific(trace_key, (void *)(uintptr_t)tid);
+	return (tid);
+}
+
+static void
+trace_keyinit(void)
+{
+	(void)pthread_key_create(&trace_key, NULL);
+}
+
+static uint64_t
+trace_now(void)
+{
+	struct timespec	 ts;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
@@ -47,6 +47,18 @@ u_spawn(char *argstr)
 	}
 }
 
+/*
+ * Write what memory is in use, and by whom, and the X traffic to fd.
+ */
+void
+u_dumpstats(int fd)
+{
+	xmalloc_dump(fd);
+	pool_dump(fd);
+	intern_dump(fd);
+	xop_dump(fd);
+}
+
 void
 u_exec(char *argstr)
 {
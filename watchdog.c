@@ -0,0 +1,261 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Noticing when the main thread is stuck.  The main thread marks each
+ * stretch of work between waits for the user: an event handler, a key
+ * typed into a menu, a step of a mouse drag.  A thread of its own waits
+ * for a stretch to start and then sleeps until it is due, and when one
+ * has run past the watchdog threshold in .cwmrc, logs what it is and,
+ * where backtrace(3) is to be had, where the main thread is, caught with
+ * SIGPROF.  It flushes the log itself, as the main thread cannot.  When
+ * the stretch ends, its full length is logged too.
+ */
+
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include <err.h>
+#include <errno.h>
+#ifdef HAVE_BACKTRACE
+#include <execinfo.h>
+#endif
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "calmwm.h"
+
+#define WATCHDOG_NFRAMES	32
+
+/*
+ * The current stretch.  Written by the main thread only, read by the
+ * watchdog as a seqlock: seq is odd while the main thread is busy.
+ */
+static struct {
+	const char	*name;
+	u_long		 win;
+	uint64_t	 start;
+	int		 type;
+	u_int		 limit;		/* ms */
+	u_int		 seq;
+} wd;
+
+static void		*watchdog_run(void *);
+static void		 watchdog_start(void);
+static void		 watchdog_sleep(u_int);
+static uint64_t		 watchdog_now(void);
+#ifdef HAVE_BACKTRACE
+static void		 watchdog_backtrace(void);
+static void		 watchdog_sigprof(int);
+
+static void		*watchdog_frames[WATCHDOG_NFRAMES];
+static int		 watchdog_nframes;
+#endif
+
+static pthread_t	 watchdog_main;
+static int		 watchdog_started;
+
+/* For the watchdog to wait for a stretch; idle is set while it does. */
+static pthread_mutex_t	 watchdog_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	 watchdog_cv = PTHREAD_COND_INITIALIZER;
+static int		 watchdog_idle;
+
+/*
+ * Start watching a stretch of work; one already being watched ends.
+ */
+void
+watchdog_begin(const char *name, int type, u_long win)
+{
+	u_int	 limit = Conf.watchdog;
+
+	watchdog_end();
+	if (limit == 0)
+		return;
+	if (!watchdog_started)
+		watchdog_start();
+
+	/* The fields must not be seen changing before seq does. */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&wd.name, name, __ATOMIC_RELAXED);
+	__atomic_store_n(&wd.type, type, __ATOMIC_RELAXED);
+	__atomic_store_n(&wd.win, win, __ATOMIC_RELAXED);
+	__atomic_store_n(&wd.limit, limit, __ATOMIC_RELAXED);
+	__atomic_store_n(&wd.start, watchdog_now(), __ATOMIC_RELAXED);
+	/* Ordered against idle, so a waiting watchdog always hears. */
+	__atomic_store_n(&wd.seq, wd.seq + 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&watchdog_idle, __ATOMIC_SEQ_CST)) {
+		(void)pthread_mutex_lock(&watchdog_mtx);
+		(void)pthread_cond_signal(&watchdog_cv);
+		(void)pthread_mutex_unlock(&watchdog_mtx);
+	}
+}
+
+void
+watchdog_end(void)
+{
+	unsigned long long	 ms;
+
+	if ((wd.seq & 1) == 0)
+		return;
+	__atomic_store_n(&wd.seq, wd.seq + 1, __ATOMIC_RELEASE);
+
+	ms = (watchdog_now() - wd.start) / 1000000;
+	if (ms >= wd.limit)
+		log_warn("watchdog: %s (event %d, window 0x%lx) took %llu ms",
+		    wd.name, wd.type, wd.win, ms);
+}
+
+static void *
+watchdog_run(void *arg)
+{
+	const char		*name;
+	unsigned long long	 ms;
+	uint64_t		 start, now, due;
+	u_long			 win;
+	u_int			 seq, reported = 0, limit;
+	int			 type;
+
+	for (;;) {
+		/* Nothing to watch until a stretch not yet reported. */
+		(void)pthread_mutex_lock(&watchdog_mtx);
+		__atomic_store_n(&watchdog_idle, 1, __ATOMIC_SEQ_CST);
+		while (((seq = __atomic_load_n(&wd.seq, __ATOMIC_SEQ_CST)) &
+		    1) == 0 || seq == reported)
+			(void)pthread_cond_wait(&watchdog_cv, &watchdog_mtx);
+		__atomic_store_n(&watchdog_idle, 0, __ATOMIC_RELAXED);
+		(void)pthread_mutex_unlock(&watchdog_mtx);
+
+		name = __atomic_load_n(&wd.name, __ATOMIC_RELAXED);
+		type = __atomic_load_n(&wd.type, __ATOMIC_RELAXED);
+		win = __atomic_load_n(&wd.win, __ATOMIC_RELAXED);
+		limit = __atomic_load_n(&wd.limit, __ATOMIC_RELAXED);
+		start = __atomic_load_n(&wd.start, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&wd.seq, __ATOMIC_RELAXED) != seq)
+			continue;
+
+		/* Sleep until it is due; it has likely ended by then. */
+		now = watchdog_now();
+		due = start + (uint64_t)limit * 1000000;
+		if (now < due) {
+			watchdog_sleep((due - now + 999999) / 1000000);
+			if (__atomic_load_n(&wd.seq, __ATOMIC_ACQUIRE) != seq)
+				continue;
+		}
+		ms = (watchdog_now() - start) / 1000000;
+
+		reported = seq;
+		log_warn("watchdog: %s (event %d, window 0x%lx) stuck for "
+		    "%llu ms", name, type, win, ms);
+#ifdef HAVE_BACKTRACE
+		watchdog_backtrace();
+#endif
+		log_flush();
+	}
+	return (NULL);
+}
+
+/* Called from the main thread the first time a stretch is watched. */
+static void
+watchdog_start(void)
+{
+	pthread_t		 tid;
+#ifdef HAVE_BACKTRACE
+	struct sigaction	 sa;
+
+	/* The first backtrace(3) may load libraries; not in the handler. */
+	(void)backtrace(watchdog_frames, 1);
+
+	bzero(&sa, sizeof(sa));
+	sa.sa_handler = watchdog_sigprof;
+	sa.sa_flags = SA_RESTART;
+	(void)sigemptyset(&sa.sa_mask);
+	if (sigaction(SIGPROF, &sa, NULL) == -1)
+		err(1, "sigaction");
+#endif
+	watchdog_main = pthread_self();
+	watchdog_started = 1;
+
+	if (pthread_create(&tid, NULL, watchdog_run, NULL) != 0) {
+		warnx("watchdog: cannot start thread");
+		return;
+	}
+	(void)pthread_detach(tid);
+}
+
+#ifdef HAVE_BACKTRACE
+/*
+ * Have the main thread take its own backtrace, and log it.
+ */
+static void
+watchdog_backtrace(void)
+{
+	char	**syms;
+	int	  i, n;
+
+	__atomic_store_n(&watchdog_nframes, -1, __ATOMIC_RELAXED);
+	if (pthread_kill(watchdog_main, SIGPROF) != 0)
+		return;
+	for (i = 0; i < 100; i++) {
+		if ((n = __atomic_load_n(&watchdog_nframes,
+		    __ATOMIC_ACQUIRE)) != -1)
+			break;
+		watchdog_sleep(1);
+	}
+	if (n <= 1 || (syms = backtrace_symbols(watchdog_frames, n)) == NULL) {
+		log_warn("watchdog: no backtrace");
+		return;
+	}
+	/* The first frame is the signal handler. */
+	for (i = 1; i < n; i++)
+		log_warn("watchdog:   %s", syms[i]);
+	free(syms);		/* from malloc(3), not xmalloc() */
+}
+
+static void
+watchdog_sigprof(int which)
+{
+	int	 save_errno = errno;
+
+	__atomic_store_n(&watchdog_nframes,
+	    backtrace(watchdog_frames, WATCHDOG_NFRAMES), __ATOMIC_RELEASE);
+	errno = save_errno;
+}
+#endif
+
+static void
+watchdog_sleep(u_int ms)
+{
+	struct timespec	 ts;
+
+	ts.tv_sec = ms / 1000;
+	ts.tv_nsec = (ms % 1000) * 1000000;
+	(void)nanosleep(&ts, NULL);
+}
+
+static uint64_t
+watchdog_now(void)
+{
+	struct timespec	 ts;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
@@ -29,6 +29,8 @@
 
 #include <err.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -70,6 +72,24 @@ void		(*xev_handlers[LASTEvent])(XEvent *) = {
 			[MappingNotify] = xev_handle_mappingnotify,
 };
 
+/* Trace span names, for the events handled above. */
+static const char	*xev_names[LASTEvent] = {
+			[MapRequest] = "MapRequest",
+			[UnmapNotify] = "UnmapNotify",
+			[ConfigureRequest] = "ConfigureRequest",
+			[PropertyNotify] = "PropertyNotify",
+			[EnterNotify] = "EnterNotify",
+			[LeaveNotify] = "LeaveNotify",
+			[ButtonPress] = "ButtonPress",
+			[ButtonRelease] = "ButtonRelease",
+			[KeyPress] = "KeyPress",
+			[KeyRelease] = "KeyRelease",
+			[Expose] = "Expose",
+			[DestroyNotify] = "DestroyNotify",
+			[ClientMessage] = "ClientMessage",
+			[MappingNotify] = "MappingNotify",
+};
+
 static void
 xev_handle_maprequest(XEvent *ee)
 {
@@ -77,6 +97,7 @@ xev_handle_maprequest(XEvent *ee)
 	struct client_ctx	*cc = NULL, *old_cc;
 	XWindowAttributes	 xattr;
 
+	xop_begin(XOP_MAP);
 	if ((old_cc = client_current()) != NULL)
 		client_ptrsave(old_cc);
 
@@ -87,6 +108,7 @@ xev_handle_maprequest(XEvent *ee)
 
 	if ((cc->flags & CLIENT_IGNORE) == 0)
 		client_ptrwarp(cc);
+	xop_end(XOP_MAP);
 }
 
 static void
@@ -108,9 +130,12 @@ xev_handle_unmapnotify(XEvent *ee)
 		 * deal with legacy clients.
 		 */
 		if (XCheckTypedWindowEvent(X_Dpy, cc->win,
-		    DestroyNotify, &ev) || e->send_event != 0) {
+		    DestroyNotify, &ev)) {
+			rec_event(&ev);
 			client_delete(cc);
-		} else
+		} else if (e->send_event != 0)
+			client_delete(cc);
+		else
 			client_hide(cc);
 	}
 	XUngrabServer(X_Dpy);
@@ -415,18 +440,124 @@ xev_handle_expose(XEvent *ee)
 		client_draw_border(cc);
 }
 
+static u_long		xev_nevents[LASTEvent];
+static u_long		xev_nrandr, xev_nother;
+
 volatile sig_atomic_t	xev_quit = 0;
+volatile sig_atomic_t	xev_dumpstats = 0;
+volatile sig_atomic_t	xev_dumptrace = 0;
+
+/* Written to by signal handlers, so poll(2) returns for them. */
+static int		xev_sigpipe[2] = { -1, -1 };
+
+/*
+ * Have the event loop look at the flags above, even while it waits;
+ * for signal handlers, after setting one.
+ */
+void
+xev_wakeup(void)
+{
+	int	 save_errno = errno;
+
+	(void)write(xev_sigpipe[1], "", 1);
+	errno = save_errno;
+}
 
 void
 xev_loop(void)
 {
-	XEvent		 e;
+	XEvent			 e;
+	struct pollfd		 pfd[2 + CTL_MAXFDS];
+	struct trace_span	 ts;
+	char			 buf[64];
+	int			 i, npfd;
+
+	if (pipe(xev_sigpipe) == -1)
+		err(1, "pipe");
+	for (i = 0; i < 2; i++) {
+		(void)fcntl(xev_sigpipe[i], F_SETFD, FD_CLOEXEC);
+		(void)fcntl(xev_sigpipe[i], F_SETFL, O_NONBLOCK);
+	}
+	pfd[0].fd = ConnectionNumber(X_Dpy);
+	pfd[0].events = POLLIN;
+	pfd[1].fd = xev_sigpipe[0];
+	pfd[1].events = POLLIN;
 
 	while (xev_quit == 0) {
+		if (xev_dumpstats) {
+			xev_dumpstats = 0;
+			u_dumpstats(STDERR_FILENO);
+		}
+		if (xev_dumptrace) {
+			xev_dumptrace = 0;
+			trace_write();
+		}
+		/*
+		 * Wait in poll(2), not XNextEvent(), so signals get
+		 * through and the control socket is served; idle time is
+		 * when the log, the recording and the snapshot get written.
+		 */
+		if (XPending(X_Dpy) == 0) {
+			log_flush();
+			rec_flush();
+			snap_update();
+			npfd = 2 + ctl_pollfds(pfd + 2);
+			if (poll(pfd, npfd, log_pending() ? 1000 : -1) == -1) {
+				if (errno != EINTR)
+					err(1, "poll");
+				continue;
+			}
+			/* The flags are looked at on the way round. */
+			if (pfd[1].revents & POLLIN)
+				while (read(xev_sigpipe[0], buf,
+				    sizeof(buf)) > 0)
+					;
+			ctl_dispatch(pfd + 2, npfd - 2);
+			continue;
+		}
 		XNextEvent(X_Dpy, &e);
-		if (e.type - Randr_ev == RRScreenChangeNotify)
+		rec_event(&e);
+		log_debug("event %d window 0x%lx", e.type, e.xany.window);
+		if (e.type - Randr_ev == RRScreenChangeNotify) {
+			xev_nrandr++;
+			trace_begin(&ts, "RRScreenChangeNotify", e.xany.window);
+			watchdog_begin(ts.name, e.type, e.xany.window);
 			xev_handle_randr(&e);
-		else if (e.type < LASTEvent && xev_handlers[e.type] != NULL)
+			watchdog_end();
+			trace_end(&ts);
+		} else if (e.type < LASTEvent) {
+			xev_nevents[e.type]++;
+			if (xev_handlers[e.type] == NULL)
+				continue;
+			trace_begin(&ts, xev_names[e.type], e.xany.window);
+			watchdog_begin(ts.name, e.type, e.xany.window);
 			(*xev_handlers[e.type])(&e);
+			watchdog_end();
+			trace_end(&ts);
+		} else
+			xev_nother++;
+	}
+}
+
+/*
+ * Events taken by the event loop as a JSON line, by the handler names;
+ * events without a handler are counted together.
+ */
+void
+xev_stats(FILE *f)
+{
+	u_long	 other = xev_nother, total = xev_nrandr + xev_nother;
+	int	 i;
+
+	fprintf(f, "{\"stat\":\"events\",\"counts\":{");
+	for (i = 0; i < LASTEvent; i++) {
+		total += xev_nevents[i];
+		if (xev_names[i] == NULL)
+			other += xev_nevents[i];
+		else
+			fprintf(f, "\"%s\":%lu,", xev_names[i],
+			    xev_nevents[i]);
 	}
+	fprintf(f, "\"RRScreenChangeNotify\":%lu,\"other\":%lu},"
+	    "\"total\":%lu}\n", xev_nrandr, other, total);
 }
@@ -23,13 +23,223 @@
 
 #include <err.h>
 #include <errno.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <unistd.h>
+#ifdef XMALLOC_STATS
+#include <pthread.h>
+#endif
 
 #include "calmwm.h"
 
+#ifdef XMALLOC_STATS
+/*
+ * Accounting mode: every block carries a header saying how big it is
+ * and which source file asked for it, and live bytes, live blocks and
+ * the high-water mark are kept per file.  The completion threads
+ * allocate too, hence the lock.
+ */
+#define XMALLOC_MAXTAGS		64
+#define XMALLOC_MAGIC		0x786d616cU
+
+struct xmalloc_hdr {
+	size_t			 size;
+	u_int			 tag;
+	u_int			 magic;
+};
+
+#define XMALLOC_HDRSIZE		roundup(sizeof(struct xmalloc_hdr), 16)
+
+struct xmalloc_tag {
+	const char		*file;
+	size_t			 bytes;
+	size_t			 peak;
+	u_long			 nlive;
+	u_long			 nalloc;
+};
+
+static struct xmalloc_tag	 xmalloc_tags[XMALLOC_MAXTAGS];
+static u_int			 xmalloc_ntags;
+static size_t			 xmalloc_bytes, xmalloc_peak;
+static pthread_mutex_t		 xmalloc_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+static u_int	 xmalloc_lookup(const char *);
+static void	*xmalloc_account(struct xmalloc_hdr *, size_t, const char *);
+static struct xmalloc_hdr *xmalloc_unaccount(void *);
+
+void *
+xmalloc_tag(size_t siz, const char *file)
+{
+	struct xmalloc_hdr	*h;
+
+	if (siz > SIZE_MAX - XMALLOC_HDRSIZE)
+		errx(1, "malloc: size too large");
+	if ((h = malloc(XMALLOC_HDRSIZE + siz)) == NULL)
+		err(1, "malloc");
+
+	return (xmalloc_account(h, siz, file));
+}
+
+void *
+xcalloc_tag(size_t no, size_t siz, const char *file)
+{
+	struct xmalloc_hdr	*h;
+
+	if (siz != 0 && no > (SIZE_MAX - XMALLOC_HDRSIZE) / siz)
+		errx(1, "calloc: size too large");
+	if ((h = calloc(1, XMALLOC_HDRSIZE + no * siz)) == NULL)
+		err(1, "calloc");
+
+	return (xmalloc_account(h, no * siz, file));
+}
+
+void *
+xrealloc_tag(void *p, size_t siz, const char *file)
+{
+	struct xmalloc_hdr	*h;
+
+	if (p == NULL)
+		return (xmalloc_tag(siz, file));
+	if (siz > SIZE_MAX - XMALLOC_HDRSIZE)
+		errx(1, "realloc: size too large");
+	h = xmalloc_unaccount(p);
+	if ((h = realloc(h, XMALLOC_HDRSIZE + siz)) == NULL)
+		err(1, "realloc");
+
+	return (xmalloc_account(h, siz, file));
+}
+
+void
+xfree(void *p)
+{
+	if (p != NULL)
+		free(xmalloc_unaccount(p));
+}
+
+char *
+xstrdup_tag(const char *str, const char *file)
+{
+	size_t	 len = strlen(str) + 1;
+
+	return (memcpy(xmalloc_tag(len, file), str, len));
+}
+
+/*
+ * Write the live allocations per source file to fd.
+ */
+void
+xmalloc_dump(int fd)
+{
+	struct xmalloc_tag	*t;
+	const char		*p;
+	u_int			 i;
+
+	pthread_mutex_lock(&xmalloc_mtx);
+	dprintf(fd, "xmalloc: %zu bytes live, peak %zu\n",
+	    xmalloc_bytes, xmalloc_peak);
+	dprintf(fd, "  %-16s %10s %10s %10s %10s\n", "file", "bytes",
+	    "blocks", "peak", "allocs");
+	for (i = 0; i < xmalloc_ntags; i++) {
+		t = &xmalloc_tags[i];
+		p = ((p = strrchr(t->file, '/')) != NULL) ? p + 1 : t->file;
+		dprintf(fd, "  %-16s %10zu %10lu %10zu %10lu\n", p,
+		    t->bytes, t->nlive, t->peak, t->nalloc);
+	}
+	pthread_mutex_unlock(&xmalloc_mtx);
+}
+
+/*
+ * The same as JSON lines, one per source file after the totals.
+ */
+void
+xmalloc_stats(FILE *f)
+{
+	struct xmalloc_tag	*t;
+	const char		*p;
+	u_long			 nlive = 0, nalloc = 0;
+	u_int			 i;
+
+	pthread_mutex_lock(&xmalloc_mtx);
+	for (i = 0; i < xmalloc_ntags; i++) {
+		nlive += xmalloc_tags[i].nlive;
+		nalloc += xmalloc_tags[i].nalloc;
+	}
+	fprintf(f, "{\"stat\":\"alloc\",\"bytes\":%zu,\"peak\":%zu,"
+	    "\"blocks\":%lu,\"allocs\":%lu}\n", xmalloc_bytes, xmalloc_peak,
+	    nlive, nalloc);
+	for (i = 0; i < xmalloc_ntags; i++) {
+		t = &xmalloc_tags[i];
+		p = ((p = strrchr(t->file, '/')) != NULL) ? p + 1 : t->file;
+		fprintf(f, "{\"stat\":\"alloc\",\"file\":\"%s\","
+		    "\"bytes\":%zu,\"peak\":%zu,\"blocks\":%lu,"
+		    "\"allocs\":%lu}\n", p, t->bytes, t->peak, t->nlive,
+		    t->nalloc);
+	}
+	pthread_mutex_unlock(&xmalloc_mtx);
+}
+
+static void *
+xmalloc_account(struct xmalloc_hdr *h, size_t siz, const char *file)
+{
+	struct xmalloc_tag	*t;
+
+	pthread_mutex_lock(&xmalloc_mtx);
+	h->size = siz;
+	h->tag = xmalloc_lookup(file);
+	h->magic = XMALLOC_MAGIC;
+	t = &xmalloc_tags[h->tag];
+	t->bytes += siz;
+	t->peak = MAX(t->peak, t->bytes);
+	t->nlive++;
+	t->nalloc++;
+	xmalloc_bytes += siz;
+	xmalloc_peak = MAX(xmalloc_peak, xmalloc_bytes);
+	pthread_mutex_unlock(&xmalloc_mtx);
+
+	return ((char *)h + XMALLOC_HDRSIZE);
+}
+
+static struct xmalloc_hdr *
+xmalloc_unaccount(void *p)
+{
+	struct xmalloc_hdr	*h;
+	struct xmalloc_tag	*t;
+
+	h = (struct xmalloc_hdr *)((char *)p - XMALLOC_HDRSIZE);
+	if (h->magic != XMALLOC_MAGIC)
+		errx(1, "xfree: %p not from xmalloc", p);
+
+	pthread_mutex_lock(&xmalloc_mtx);
+	h->magic = 0;
+	t = &xmalloc_tags[h->tag];
+	t->bytes -= h->size;
+	t->nlive--;
+	xmalloc_bytes -= h->size;
+	pthread_mutex_unlock(&xmalloc_mtx);
+
+	return (h);
+}
+
+/* Few files allocate, so a list does; the last slot takes the rest. */
+static u_int
+xmalloc_lookup(const char *file)
+{
+	u_int	 i;
+
+	for (i = 0; i < xmalloc_ntags; i++)
+		if (xmalloc_tags[i].file == file ||
+		    strcmp(xmalloc_tags[i].file, file) == 0)
+			return (i);
+	if (xmalloc_ntags == XMALLOC_MAXTAGS)
+		return (XMALLOC_MAXTAGS - 1);
+	xmalloc_tags[xmalloc_ntags].file = file;
+	return (xmalloc_ntags++);
+}
+
+#else /* !XMALLOC_STATS */
+
 void *
 xmalloc(size_t siz)
 {
@@ -52,6 +262,15 @@ xcalloc(size_t no, size_t siz)
 	return (p);
 }
 
+void *
+xrealloc(void *p, size_t siz)
+{
+	if ((p = realloc(p, siz)) == NULL)
+		err(1, "realloc");
+
+	return (p);
+}
+
 void
 xfree(void *p)
 {
@@ -68,3 +287,17 @@ xstrdup(const char *str)
 
 	return (p);
 }
+
+void
+xmalloc_dump(int fd)
+{
+	dprintf(fd, "xmalloc: no accounting, build with -DXMALLOC_STATS\n");
+}
+
+void
+xmalloc_stats(FILE *f)
+{
+	fprintf(f, "{\"stat\":\"alloc\",\"accounting\":false}\n");
+}
+
+#endif /* XMALLOC_STATS */
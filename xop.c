@@ -0,0 +1,150 @@
+/*
+ * calmwm - the calm window manager
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * X requests and round trips per window manager operation.  Requests
+ * are counted from the display's request sequence number, round trips
+ * by the macros in calmwm.h wrapping the Xlib calls that wait for a
+ * reply.  Each operation has a budget of round trips; going over it is
+ * logged, or fatal if CWM_XOP_STRICT is set in the environment, so
+ * tests can catch an operation getting slower.
+ */
+
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "calmwm.h"
+
+#define XOP_MAXDEPTH	8
+
+struct xop {
+	const char	*name;
+	u_int		 budget;	/* round trips */
+	u_long		 count;
+	u_long		 requests;
+	u_long		 replies;
+	u_long		 maxreplies;
+	u_long		 over;
+};
+
+/*
+ * Today's worst cases, from reading the code; lower them as round
+ * trips go away.
+ */
+static struct xop	 xop_ops[XOP_NOPS] = {
+	[XOP_MAP] =		{ "map", 14 },
+	[XOP_CLIENT_NEW] =	{ "client_new", 12 },
+	[XOP_CLIENT_DELETE] =	{ "client_delete", 1 },
+	[XOP_CLIENT_CYCLE] =	{ "client_cycle", 2 },
+	[XOP_CLIENT_PTRSAVE] =	{ "client_ptrsave", 1 },
+	[XOP_CLIENT_SETNAME] =	{ "client_setname", 2 },
+	[XOP_GROUP_HIDE] =	{ "group_hide", 1 },
+	[XOP_GROUP_SHOW] =	{ "group_show", 0 },
+	[XOP_MENU_OPEN] =	{ "menu_open", 4 },
+};
+
+static struct {
+	int		 op;
+	u_long		 seq;
+	u_long		 replies;
+} xop_stack[XOP_MAXDEPTH];
+static int		 xop_depth;
+static int		 xop_strict = -1;
+
+u_long			 xop_nreplies;
+
+void
+xop_begin(int op)
+{
+	if (xop_depth == XOP_MAXDEPTH)
+		errx(1, "xop_begin: %s nested too deep", xop_ops[op].name);
+	xop_stack[xop_depth].op = op;
+	xop_stack[xop_depth].seq = NextRequest(X_Dpy);
+	xop_stack[xop_depth].replies = xop_nreplies;
+	xop_depth++;
+}
+
+void
+xop_end(int op)
+{
+	struct xop	*xp = &xop_ops[op];
+	u_long		 replies;
+
+	if (xop_depth == 0 || xop_stack[xop_depth - 1].op != op)
+		errx(1, "xop_end: %s not the current operation", xp->name);
+	xop_depth--;
+
+	replies = xop_nreplies - xop_stack[xop_depth].replies;
+	xp->count++;
+	xp->requests += NextRequest(X_Dpy) - xop_stack[xop_depth].seq;
+	xp->replies += replies;
+	xp->maxreplies = MAX(xp->maxreplies, replies);
+	if (replies <= xp->budget)
+		return;
+
+	xp->over++;
+	log_warn("%s: %lu round trips, budget %u", xp->name, replies,
+	    xp->budget);
+	if (xop_strict == -1)
+		xop_strict = getenv("CWM_XOP_STRICT") != NULL;
+	if (xop_strict)
+		errx(1, "%s: %lu round trips, budget %u", xp->name, replies,
+		    xp->budget);
+}
+
+void
+xop_dump(int fd)
+{
+	struct xop	*xp;
+	int		 i;
+
+	dprintf(fd, "xop: %lu requests, %lu round trips\n",
+	    NextRequest(X_Dpy) - 1, xop_nreplies);
+	dprintf(fd, "  %-16s %8s %10s %10s %6s %6s %6s\n", "operation",
+	    "count", "requests", "replies", "max", "budget", "over");
+	for (i = 0; i < XOP_NOPS; i++) {
+		xp = &xop_ops[i];
+		dprintf(fd, "  %-16s %8lu %10lu %10lu %6lu %6u %6lu\n",
+		    xp->name, xp->count, xp->requests, xp->replies,
+		    xp->maxreplies, xp->budget, xp->over);
+	}
+}
+
+/*
+ * The same as JSON lines, one per operation after the totals.
+ */
+void
+xop_stats(FILE *f)
+{
+	struct xop	*xp;
+	int		 i;
+
+	fprintf(f, "{\"stat\":\"x\",\"requests\":%lu,"
+	    "\"round_trips\":%lu}\n", NextRequest(X_Dpy) - 1, xop_nreplies);
+	for (i = 0; i < XOP_NOPS; i++) {
+		xp = &xop_ops[i];
+		fprintf(f, "{\"stat\":\"xop\",\"op\":\"%s\",\"count\":%lu,"
+		    "\"requests\":%lu,\"round_trips\":%lu,\"max\":%lu,"
+		    "\"budget\":%u,\"over\":%lu}\n", xp->name, xp->count,
+		    xp->requests, xp->replies, xp->maxreplies, xp->budget,
+		    xp->over);
+	}
+}
@@ -30,6 +30,8 @@
 
 #include "calmwm.h"
 
+static char	*xu_strcpy(const char *, char *, size_t);
+
 static unsigned int ign_mods[] = { 0, LockMask, Mod2Mask, Mod2Mask | LockMask };
 
 int
@@ -170,13 +172,18 @@ xu_getprop(Window win, Atom atm, Atom type, long len, u_char **p)
 	return (n);
 }
 
+/*
+ * Get the text property atm of win into *text: buf when it fits in
+ * len bytes, otherwise a copy the caller has to xfree().
+ */
 int
-xu_getstrprop(Window win, Atom atm, char **text) {
+xu_getstrprop(Window win, Atom atm, char **text, char *buf, size_t len) {
 	XTextProperty	 prop;
 	char		**list;
 	int		 nitems = 0;
 
-	*text = NULL;
+	buf[0] = '\0';
+	*text = buf;
 
 	XGetTextProperty(X_Dpy, win, &prop, atm);
 	if (!prop.nitems)
@@ -188,11 +195,12 @@ xu_getstrprop(Window win, Atom atm, char **text) {
 			XTextProperty    prop2;
 			if (Xutf8TextListToTextProperty(X_Dpy, list, nitems,
 			    XUTF8StringStyle, &prop2) == Success) {
-				*text = xstrdup(prop2.value);
+				*text = xu_strcpy((char *)prop2.value,
+				    buf, len);
 				XFree(prop2.value);
 			}
 		} else {
-			*text = xstrdup(*list);
+			*text = xu_strcpy(*list, buf, len);
 		}
 		XFreeStringList(list);
 	}
@@ -202,6 +210,14 @@ xu_getstrprop(Window win, Atom atm, char **text) {
 	return (nitems);
 }
 
+static char *
+xu_strcpy(const char *src, char *buf, size_t len)
+{
+	if (strlcpy(buf, src, len) < len)
+		return (buf);
+	return (xstrdup(src));
+}
+
 int
 xu_getstate(struct client_ctx *cc, int *state)
 {
@@ -224,7 +240,7 @@ xu_setstate(struct client_ctx *cc, int state)
 	dat[0] = state;
 	dat[1] = None;
 
-	cc->state = state;
+	cc->cold->state = state;
 	XChangeProperty(X_Dpy, cc->win, WM_STATE, WM_STATE, 32,
 	    PropModeReplace, (unsigned char *)dat, 2);
 }
@@ -12,13 +12,16 @@
 #define MOVEAMOUNT 268
 #define COLOR 269
 #define SNAPDIST 270
-#define ACTIVEBORDER 271
-#define INACTIVEBORDER 272
-#define GROUPBORDER 273
-#define UNGROUPBORDER 274
-#define MENUBG 275
-#define MENUFG 276
-#define FONTCOLOR 277
-#define ERROR 278
-#define STRING 279
-#define NUMBER 280
+#define FILTERTHREADS 271
+#define PATHCACHE 272
+#define WATCHDOG 273
+#define ACTIVEBORDER 274
+#define INACTIVEBORDER 275
+#define GROUPBORDER 276
+#define UNGROUPBORDER 277
+#define MENUBG 278
+#define MENUFG 279
+#define FONTCOLOR 280
+#define ERROR 281
+#define STRING 282
+#define NUMBER 283